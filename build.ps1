@@ -10,6 +10,7 @@ $requiredDeps = @(
     "external/glm/glm/glm.hpp",
     "external/imgui/imgui.h",
     "external/stb/stb_image.h",
+    "external/stb/stb_image_write.h",
     "external/glad/include/glad/glad.h"
 )
 
@@ -37,5 +37,16 @@ if (-not (Test-Path "external/stb/stb_image.h")) {
     }
 }
 
+# stb_image_write (headless PNG output)
+if (-not (Test-Path "external/stb/stb_image_write.h")) {
+    Write-Host "Downloading stb_image_write..." -ForegroundColor Yellow
+    try {
+        Invoke-WebRequest -Uri "https://raw.githubusercontent.com/nothings/stb/master/stb_image_write.h" -OutFile "external/stb/stb_image_write.h" -ErrorAction Stop
+        Write-Host "  OK" -ForegroundColor Green
+    } catch {
+        Write-Host "  FAILED" -ForegroundColor Red
+    }
+}
+
 Write-Host "`nDependencies downloaded!" -ForegroundColor Green
 Write-Host "NOTE: GLAD must be manually generated from https://glad.dav1d.de/" -ForegroundColor Yellow
@@ -77,6 +77,16 @@ if (Test-Path "external/stb/stb_image.h") {
         Write-Host "  ✗ stb_image.h download failed" -ForegroundColor Red
     }
 }
+if (Test-Path "external/stb/stb_image_write.h") {
+    Write-Host "  stb_image_write.h already exists, skipping..." -ForegroundColor Gray
+} else {
+    try {
+        Invoke-WebRequest -Uri "https://raw.githubusercontent.com/nothings/stb/master/stb_image_write.h" -OutFile "external/stb/stb_image_write.h"
+        Write-Host "  ✓ stb_image_write.h downloaded" -ForegroundColor Green
+    } catch {
+        Write-Host "  ✗ stb_image_write.h download failed" -ForegroundColor Red
+    }
+}
 
 # GLAD - Special handling (needs to be generated)
 Write-Host "`nSetting up GLAD..." -ForegroundColor Yellow
@@ -119,6 +129,7 @@ $dependencies = @(
     @{Name="GLM"; Path="external/glm/glm/glm.hpp"},
     @{Name="ImGui"; Path="external/imgui/imgui.h"},
     @{Name="stb_image"; Path="external/stb/stb_image.h"},
+    @{Name="stb_image_write"; Path="external/stb/stb_image_write.h"},
     @{Name="GLAD"; Path="external/glad/include/glad/glad.h"}
 )
 
@@ -5,6 +5,39 @@ out vec4 FragColor;
 
 uniform sampler2D u_texture;
 uniform float u_exposure;
+uniform vec2 u_sourceSize;     // Size of u_texture in texels
+uniform bool u_upscale;        // Traced below window resolution (dynamic resolution)
+
+// Weight falloff with log-luminance difference across an edge
+const float EDGE_SHARPNESS = 4.0;
+
+float logLuminance(vec3 color) {
+    return log(dot(color, vec3(0.2126, 0.7152, 0.0722)) + 1e-3);
+}
+
+// Bilinear upsampling that does not blend across strong luminance edges:
+// each of the four source texels is weighted down by how much it differs
+// from the nearest one, so the shadow edge and the photon ring stay sharp
+vec3 upsampleEdgeAware(vec2 uv) {
+    vec2 pos = uv * u_sourceSize - 0.5;
+    ivec2 base = ivec2(floor(pos));
+    vec2 f = pos - vec2(base);
+    ivec2 maxCoord = ivec2(u_sourceSize) - 1;
+    
+    vec3 c00 = texelFetch(u_texture, clamp(base, ivec2(0), maxCoord), 0).rgb;
+    vec3 c10 = texelFetch(u_texture, clamp(base + ivec2(1, 0), ivec2(0), maxCoord), 0).rgb;
+    vec3 c01 = texelFetch(u_texture, clamp(base + ivec2(0, 1), ivec2(0), maxCoord), 0).rgb;
+    vec3 c11 = texelFetch(u_texture, clamp(base + ivec2(1, 1), ivec2(0), maxCoord), 0).rgb;
+    
+    vec3 nearest = f.y < 0.5 ? (f.x < 0.5 ? c00 : c10) : (f.x < 0.5 ? c01 : c11);
+    float anchor = logLuminance(nearest);
+    
+    vec4 w = vec4((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+    w *= exp(-EDGE_SHARPNESS * abs(vec4(logLuminance(c00), logLuminance(c10),
+                                        logLuminance(c01), logLuminance(c11)) - anchor));
+    
+    return (w.x * c00 + w.y * c10 + w.z * c01 + w.w * c11) / max(w.x + w.y + w.z + w.w, 1e-6);
+}
 
 // ACES tone mapping
 vec3 acesToneMapping(vec3 color) {
@@ -28,7 +61,7 @@ vec3 gammaCorrect(vec3 color) {
 }
 
 void main() {
-    vec3 hdrColor = texture(u_texture, TexCoord).rgb;
+    vec3 hdrColor = u_upscale ? upsampleEdgeAware(TexCoord) : texture(u_texture, TexCoord).rgb;
     
     // Exposure
     hdrColor *= u_exposure;
@@ -0,0 +1,225 @@
+#include "CommandLine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace Core {
+
+namespace {
+
+bool parseFloat(const std::string& text, float& value) {
+    char* end = nullptr;
+    value = std::strtof(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0';
+}
+
+bool parseInt(const std::string& text, int& value) {
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    value = static_cast<int>(parsed);
+    return end != text.c_str() && *end == '\0';
+}
+
+bool parseVec3(const std::string& text, glm::vec3& value) {
+    char trailing = 0;
+    return std::sscanf(text.c_str(), "%f,%f,%f%c", &value.x, &value.y, &value.z, &trailing) == 3;
+}
+
+bool parseSize(const std::string& text, int& width, int& height) {
+    char trailing = 0;
+    if (std::sscanf(text.c_str(), "%dx%d%c", &width, &height, &trailing) != 2) {
+        return false;
+    }
+    return width > 0 && height > 0;
+}
+
+bool takesValue(const std::string& arg) {
+    static const char* const valueOptions[] = {
+        "--mass", "--spin", "--cam", "--target", "--fov", "--size", "-o", "--output",
+        "--exposure", "--threads", "--steps", "--step-size", "--disk-inner", "--disk-outer",
+        "--batch", "--tolerance", "--integrator", "--influence-radius",
+        "--lensing-cache", "--shader-cache", "--profile", "--quality", "--sky", "--sky-size",
+        "--benchmark", "--benchmark-output", "--warmup"
+    };
+    for (const char* option : valueOptions) {
+        if (arg == option) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool parseCommandLine(int argc, char** argv, LaunchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            options.mode = RunMode::Help;
+            return true;
+        }
+        if (arg == "--render") {
+            options.mode = RunMode::Render;
+            continue;
+        }
+        if (arg == "--overwrite") {
+            options.overwrite = true;
+            continue;
+        }
+        if (arg == "--no-shader-cache") {
+            options.shaderCacheDir.clear();
+            continue;
+        }
+        if (arg == "--no-disk") {
+            options.showAccretionDisk = false;
+            continue;
+        }
+        if (arg == "--photon-sphere") {
+            options.showPhotonSphere = true;
+            continue;
+        }
+
+        // Everything else takes a value
+        if (!takesValue(arg)) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        bool ok = true;
+
+        if (arg == "--mass") {
+            ok = parseFloat(value, options.mass) && options.mass > 0.0f;
+        } else if (arg == "--spin") {
+            ok = parseFloat(value, options.spin) && options.spin >= 0.0f && options.spin < 1.0f;
+        } else if (arg == "--cam") {
+            ok = parseVec3(value, options.cameraPosition);
+        } else if (arg == "--target") {
+            ok = parseVec3(value, options.cameraTarget);
+        } else if (arg == "--fov") {
+            ok = parseFloat(value, options.fov) && options.fov > 0.0f && options.fov < 180.0f;
+        } else if (arg == "--size") {
+            ok = parseSize(value, options.width, options.height);
+        } else if (arg == "-o" || arg == "--output") {
+            options.outputPath = value;
+        } else if (arg == "--exposure") {
+            ok = parseFloat(value, options.exposure);
+        } else if (arg == "--threads") {
+            ok = parseInt(value, options.threads) && options.threads >= 0;
+        } else if (arg == "--steps") {
+            ok = parseInt(value, options.maxSteps) && options.maxSteps > 0;
+        } else if (arg == "--step-size") {
+            ok = parseFloat(value, options.stepSize) && options.stepSize > 0.0f;
+        } else if (arg == "--integrator") {
+            Rendering::GeodesicIntegrator integrator;
+            ok = Rendering::parseIntegratorName(value, integrator);
+            options.integrator = value;
+        } else if (arg == "--influence-radius") {
+            ok = parseFloat(value, options.influenceRadius) &&
+                 (options.influenceRadius == 0.0f ||
+                  (options.influenceRadius >= Rendering::MIN_INFLUENCE_RADIUS &&
+                   options.influenceRadius <= Rendering::MAX_INFLUENCE_RADIUS));
+        } else if (arg == "--tolerance") {
+            ok = parseFloat(value, options.tolerance) && options.tolerance > 0.0f;
+        } else if (arg == "--disk-inner") {
+            ok = parseFloat(value, options.diskInnerRadius) && options.diskInnerRadius >= 0.0f;
+        } else if (arg == "--disk-outer") {
+            ok = parseFloat(value, options.diskOuterRadius) && options.diskOuterRadius >= 0.0f;
+        } else if (arg == "--lensing-cache") {
+            options.lensingCacheDir = value;
+        } else if (arg == "--shader-cache") {
+            options.shaderCacheDir = value;
+        } else if (arg == "--profile") {
+            options.profilePath = value;
+        } else if (arg == "--quality") {
+            ok = parseInt(value, options.quality) && options.quality >= 1 && options.quality <= 4;
+        } else if (arg == "--sky") {
+            options.skyPath = value;
+        } else if (arg == "--sky-size") {
+            ok = parseInt(value, options.skyFaceSize) && options.skyFaceSize >= 64 &&
+                 (options.skyFaceSize & (options.skyFaceSize - 1)) == 0;
+        } else if (arg == "--benchmark") {
+            options.mode = RunMode::Benchmark;
+            options.benchmarkScenario = value;
+        } else if (arg == "--benchmark-output") {
+            options.benchmarkOutput = value;
+        } else if (arg == "--warmup") {
+            ok = parseInt(value, options.benchmarkWarmup) && options.benchmarkWarmup >= 0;
+        } else if (arg == "--batch") {
+            options.mode = RunMode::Batch;
+            options.jobPath = value;
+        }
+
+        if (!ok) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return false;
+        }
+    }
+
+    // 0 keeps the default radius, which depends on the hole
+    if (options.diskInnerRadius > 0.0f && options.diskOuterRadius > 0.0f &&
+        options.diskInnerRadius >= options.diskOuterRadius) {
+        std::cerr << "--disk-inner must be smaller than --disk-outer" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "\n"
+              << "Without options the interactive viewer is started.\n"
+              << "\n"
+              << "Headless rendering:\n"
+              << "  --render               Render one frame on the CPU and exit (no window)\n"
+              << "  -o, --output <path>    HDR output (.pfm); a tone-mapped .png is written next to it\n"
+              << "  --size <W>x<H>         Image size (default 1920x1080)\n"
+              << "  --exposure <f>         Exposure applied before tone mapping (default 1.0)\n"
+              << "  --threads <n>          Worker threads (default: all cores)\n"
+              << "  --batch <job.json>     Render every frame listed in a job file\n"
+              << "  --overwrite            Re-render batch frames whose outputs already exist\n"
+              << "  --lensing-cache <dir>  Store traced lensing maps in dir and reuse them across runs\n"
+              << "\n"
+              << "Viewer:\n"
+              << "  --shader-cache <dir>   Keep compiled shader programs in dir (default shader_cache)\n"
+              << "  --no-shader-cache      Compile every shader from source\n"
+              << "  --quality <1-4>        Starting quality tier, Low to Ultra (default 2)\n"
+              << "  --sky <image>          Equirectangular sky map (.hdr, .pfm, .png, .jpg), streamed in\n"
+              << "                         as a cubemap; .hdr and .pfm maps of any size are read in place\n"
+              << "  --sky-size <n>         Largest cube face size, a power of two >= 64 (default 2048)\n"
+              << "  --profile <trace.json> Record CPU profiler zones and write them as a Chrome trace\n"
+              << "                         at exit (F9 in the viewer writes it on demand)\n"
+              << "\n"
+              << "Benchmark:\n"
+              << "  --benchmark <scenario> Play orbit, zoom, spin-sweep or a job file's camera path\n"
+              << "                         with vsync off and write per-frame timings as JSON\n"
+              << "  --benchmark-output <p> Timing report path (default benchmark.json)\n"
+              << "  --warmup <frames>      Frames rendered before timing starts (default 60)\n"
+              << "\n"
+              << "Scene:\n"
+              << "  --mass <solar masses>  Black hole mass (default 4.31e6)\n"
+              << "  --spin <a>             Dimensionless spin in [0, 1) (default 0.9)\n"
+              << "  --cam <x,y,z>          Camera position (default 0,5,20)\n"
+              << "  --target <x,y,z>       Camera target (default 0,0,0)\n"
+              << "  --fov <degrees>        Vertical field of view (default 60)\n"
+              << "  --disk-inner <r>       Disk inner radius (default: ISCO)\n"
+              << "  --disk-outer <r>       Disk outer radius (default: 15 Rs)\n"
+              << "  --no-disk              Hide the accretion disk\n"
+              << "  --photon-sphere        Highlight the photon sphere\n"
+              << "\n"
+              << "Integration:\n"
+              << "  --tolerance <f>        Adaptive RK45 error tolerance (default 1e-4)\n"
+              << "  --integrator <name>    fixed, rk45 or kerr (exact Kerr geodesics, default)\n"
+              << "  --steps <n>            Maximum steps per ray (default 500)\n"
+              << "  --step-size <f>        Fixed-step march step size (default 0.1)\n"
+              << "  --influence-radius <r> Propagate rays in closed form beyond r Rs, 2 to 100\n"
+              << "                         (default 6, 0 = march all the way)\n"
+              << std::endl;
+}
+
+} // namespace Core
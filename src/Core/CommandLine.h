@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../Physics/Constants.h"
+#include "../Rendering/Integrator.h"
+#include <string>
+#include <glm/glm.hpp>
+
+namespace Core {
+
+enum class RunMode {
+    Interactive,  // Window + ImGui (default)
+    Render,       // Render a single frame headless and exit
+    Batch,        // Render every frame of a job file headless and exit
+    Benchmark,    // Play a scripted timeline in the GPU viewer and write timings
+    Help
+};
+
+// Settings gathered from the command line
+struct LaunchOptions {
+    RunMode mode = RunMode::Interactive;
+
+    // Scene
+    float mass = Physics::DEFAULT_MASS;       // Solar masses
+    float spin = 0.9f;
+    glm::vec3 cameraPosition = glm::vec3(0.0f, 5.0f, 20.0f);
+    glm::vec3 cameraTarget = glm::vec3(0.0f);
+    float fov = Physics::DEFAULT_FOV;
+    float diskInnerRadius = 0.0f;             // 0 = ISCO
+    float diskOuterRadius = 0.0f;             // 0 = 15 Rs
+    bool showAccretionDisk = true;
+    bool showPhotonSphere = false;
+
+    // Output
+    int width = Physics::DEFAULT_WIDTH;
+    int height = Physics::DEFAULT_HEIGHT;
+    std::string outputPath = "render.pfm";
+    float exposure = 1.0f;
+
+    // Batch
+    std::string jobPath;
+    bool overwrite = false;                   // Re-render frames whose outputs exist
+
+    // Tracer
+    int threads = 0;                          // 0 = all cores
+    int maxSteps = 500;                       // Steps (RK45: step attempts) per ray
+    float stepSize = 0.1f;                    // Fixed-step integrator only
+    std::string integrator = "kerr";          // fixed, rk45 or kerr
+    float tolerance = 1e-4f;                  // RK45 relative error tolerance
+    float influenceRadius = Rendering::DEFAULT_INFLUENCE_RADIUS;  // Far-field sphere in Rs (0 = off)
+    std::string lensingCacheDir;              // Disk store of traced lensing maps (empty = none)
+
+    // Viewer
+    std::string shaderCacheDir = "shader_cache";  // Linked program binaries (empty = none)
+    int quality = 2;                          // GPU quality tier, 1 (Low) to 4 (Ultra)
+    std::string skyPath;                      // Equirectangular sky image (empty = procedural)
+    int skyFaceSize = 2048;                   // Largest cubemap face of the streamed sky
+
+    // Benchmark
+    std::string benchmarkScenario;            // Built-in scenario name or job file
+    std::string benchmarkOutput = "benchmark.json";
+    int benchmarkWarmup = 60;                 // Frames rendered before timing starts
+
+    // Diagnostics
+    std::string profilePath;                  // Chrome trace of the CPU profiler zones (empty = off)
+};
+
+// Parse argv into options. Prints a message and returns false on bad input.
+bool parseCommandLine(int argc, char** argv, LaunchOptions& options);
+
+void printUsage(const char* program);
+
+} // namespace Core
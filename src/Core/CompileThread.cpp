@@ -0,0 +1,75 @@
+#include "CompileThread.h"
+#include "Profiler.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+namespace Core {
+
+CompileThread::CompileThread(GLFWwindow* shareWith)
+    : m_context(nullptr)
+    , m_stopping(false) {
+    // Same context hints as the window, which are still set; only hide it
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_context = glfwCreateWindow(1, 1, "Shader Compiler", nullptr, shareWith);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!m_context) {
+        std::cerr << "Failed to create shader compile context" << std::endl;
+        return;
+    }
+
+    m_thread = std::thread(&CompileThread::workerLoop, this);
+}
+
+CompileThread::~CompileThread() {
+    if (!m_context) {
+        return;
+    }
+
+    // Finish queued jobs, their futures are still waited on
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+    glfwDestroyWindow(m_context);
+}
+
+std::future<void> CompileThread::submit(std::function<void()> job) {
+    std::packaged_task<void()> task([job = std::move(job)]() {
+        job();
+        // Objects must be complete before another context uses them
+        glFinish();
+    });
+    std::future<void> result = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+    return result;
+}
+
+void CompileThread::workerLoop() {
+    PROFILE_THREAD_NAME("Shader compiler");
+    glfwMakeContextCurrent(m_context);
+
+    while (true) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                break;
+            }
+            task = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        task();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+} // namespace Core
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+struct GLFWwindow;
+
+namespace Core {
+
+// Worker thread with a hidden GL context that shares objects with the
+// window's. Shaders compiled and linked there can be used by the render
+// thread once the job has finished. Used when the driver offers no
+// parallel shader compile extension.
+class CompileThread {
+public:
+    explicit CompileThread(GLFWwindow* shareWith);
+    ~CompileThread();
+
+    CompileThread(const CompileThread&) = delete;
+    CompileThread& operator=(const CompileThread&) = delete;
+
+    // False if the shared context could not be created
+    bool isRunning() const { return m_context != nullptr; }
+
+    // Run job on the worker's context, in submission order. The future is
+    // ready once the job's GL commands have completed.
+    std::future<void> submit(std::function<void()> job);
+
+private:
+    void workerLoop();
+
+    GLFWwindow* m_context;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::packaged_task<void()>> m_jobs;
+    bool m_stopping;
+};
+
+} // namespace Core
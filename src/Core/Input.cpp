@@ -1,4 +1,5 @@
 #include "Input.h"
+#include "Profiler.h"
 #include <GLFW/glfw3.h>
 #include <cstring>
 
@@ -24,6 +25,7 @@ void Input::initialize(GLFWwindow* window) {
 }
 
 void Input::update() {
+    PROFILE_ZONE("Input::update");
     // Update previous states
     std::memcpy(s_keysLast, s_keys, sizeof(s_keys));
     std::memcpy(s_mouseButtonsLast, s_mouseButtons, sizeof(s_mouseButtons));
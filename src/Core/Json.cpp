@@ -0,0 +1,338 @@
+#include "Json.h"
+#include <cmath>
+#include <cstring>
+#include <locale>
+#include <sstream>
+
+namespace Core {
+
+// Recursive descent parser over an in-memory document
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text)
+        : m_text(text)
+        , m_pos(0) {
+    }
+
+    bool parseDocument(JsonValue& value, std::string& error) {
+        skipWhitespace();
+        if (!parseValue(value, 0)) {
+            error = m_error;
+            return false;
+        }
+        skipWhitespace();
+        if (m_pos != m_text.size()) {
+            fail("unexpected trailing characters");
+            error = m_error;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 64;
+
+    bool fail(const char* message) {
+        int line = 1;
+        for (size_t i = 0; i < m_pos && i < m_text.size(); ++i) {
+            if (m_text[i] == '\n') {
+                ++line;
+            }
+        }
+        m_error = "line " + std::to_string(line) + ": " + message;
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (m_pos < m_text.size()) {
+            char c = m_text[m_pos];
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+                break;
+            }
+            ++m_pos;
+        }
+    }
+
+    bool consume(const char* literal) {
+        size_t length = std::strlen(literal);
+        if (m_text.compare(m_pos, length, literal) != 0) {
+            return false;
+        }
+        m_pos += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+        if (m_pos >= m_text.size()) {
+            return fail("unexpected end of input");
+        }
+
+        char c = m_text[m_pos];
+        if (c == '{') {
+            return parseObject(value, depth);
+        }
+        if (c == '[') {
+            return parseArray(value, depth);
+        }
+        if (c == '"') {
+            value.m_type = JsonValue::Type::String;
+            return parseString(value.m_string);
+        }
+        if (consume("true")) {
+            value.m_type = JsonValue::Type::Bool;
+            value.m_bool = true;
+            return true;
+        }
+        if (consume("false")) {
+            value.m_type = JsonValue::Type::Bool;
+            value.m_bool = false;
+            return true;
+        }
+        if (consume("null")) {
+            value.m_type = JsonValue::Type::Null;
+            return true;
+        }
+        return parseNumber(value);
+    }
+
+    bool parseObject(JsonValue& value, int depth) {
+        value.m_type = JsonValue::Type::Object;
+        ++m_pos;  // '{'
+        skipWhitespace();
+        if (m_pos < m_text.size() && m_text[m_pos] == '}') {
+            ++m_pos;
+            return true;
+        }
+
+        while (true) {
+            skipWhitespace();
+            if (m_pos >= m_text.size() || m_text[m_pos] != '"') {
+                return fail("expected member name");
+            }
+            JsonValue::Member member;
+            if (!parseString(member.first)) {
+                return false;
+            }
+            skipWhitespace();
+            if (m_pos >= m_text.size() || m_text[m_pos] != ':') {
+                return fail("expected ':'");
+            }
+            ++m_pos;
+            skipWhitespace();
+            if (!parseValue(member.second, depth + 1)) {
+                return false;
+            }
+            value.m_object.push_back(std::move(member));
+
+            skipWhitespace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',') {
+                ++m_pos;
+                continue;
+            }
+            if (m_pos < m_text.size() && m_text[m_pos] == '}') {
+                ++m_pos;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+    bool parseArray(JsonValue& value, int depth) {
+        value.m_type = JsonValue::Type::Array;
+        ++m_pos;  // '['
+        skipWhitespace();
+        if (m_pos < m_text.size() && m_text[m_pos] == ']') {
+            ++m_pos;
+            return true;
+        }
+
+        while (true) {
+            skipWhitespace();
+            value.m_array.emplace_back();
+            if (!parseValue(value.m_array.back(), depth + 1)) {
+                return false;
+            }
+
+            skipWhitespace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',') {
+                ++m_pos;
+                continue;
+            }
+            if (m_pos < m_text.size() && m_text[m_pos] == ']') {
+                ++m_pos;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool parseHex4(unsigned int& code) {
+        if (m_pos + 4 > m_text.size()) {
+            return fail("truncated \\u escape");
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = m_text[m_pos++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= c - '0';
+            else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else return fail("invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned int code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        ++m_pos;  // opening quote
+        out.clear();
+
+        while (m_pos < m_text.size()) {
+            char c = m_text[m_pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return fail("control character in string");
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+
+            if (m_pos >= m_text.size()) {
+                break;
+            }
+            char escape = m_text[m_pos++];
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned int code = 0;
+                    if (!parseHex4(code)) {
+                        return false;
+                    }
+                    // Surrogate pair
+                    if (code >= 0xD800 && code <= 0xDBFF && consume("\\u")) {
+                        unsigned int low = 0;
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return fail("invalid escape sequence");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    bool isDigit() const {
+        return m_pos < m_text.size() && m_text[m_pos] >= '0' && m_text[m_pos] <= '9';
+    }
+
+    void skipDigits() {
+        while (isDigit()) {
+            ++m_pos;
+        }
+    }
+
+    bool parseNumber(JsonValue& value) {
+        // Scan the JSON number syntax exactly: strtod would also take
+        // nan, inf, hex floats, a leading '+' and locale decimal commas
+        size_t begin = m_pos;
+        if (m_pos < m_text.size() && m_text[m_pos] == '-') {
+            ++m_pos;
+        }
+        if (!isDigit()) {
+            m_pos = begin;
+            return fail("unexpected character");
+        }
+        if (m_text[m_pos] == '0') {
+            ++m_pos;
+        } else {
+            skipDigits();
+        }
+        if (m_pos < m_text.size() && m_text[m_pos] == '.') {
+            ++m_pos;
+            if (!isDigit()) {
+                return fail("expected digit after '.'");
+            }
+            skipDigits();
+        }
+        if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E')) {
+            ++m_pos;
+            if (m_pos < m_text.size() && (m_text[m_pos] == '+' || m_text[m_pos] == '-')) {
+                ++m_pos;
+            }
+            if (!isDigit()) {
+                return fail("expected digit in exponent");
+            }
+            skipDigits();
+        }
+
+        std::istringstream stream(m_text.substr(begin, m_pos - begin));
+        stream.imbue(std::locale::classic());
+        double number = 0.0;
+        if (!(stream >> number) || !std::isfinite(number)) {
+            return fail("number out of range");
+        }
+
+        value.m_type = JsonValue::Type::Number;
+        value.m_number = number;
+        return true;
+    }
+
+    const std::string& m_text;
+    size_t m_pos;
+    std::string m_error;
+};
+
+bool JsonValue::parse(const std::string& text, JsonValue& value, std::string& error) {
+    value = JsonValue();
+    JsonParser parser(text);
+    return parser.parseDocument(value, error);
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    if (m_type != Type::Object) {
+        return nullptr;
+    }
+    for (const auto& member : m_object) {
+        if (member.first == key) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace Core
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Core {
+
+// Minimal JSON document model for job files.
+// Supports the full JSON grammar; numbers are stored as double (numbers
+// outside its range are rejected) and object members keep their file order.
+class JsonValue {
+public:
+    enum class Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    using Member = std::pair<std::string, JsonValue>;
+
+    JsonValue() : m_type(Type::Null), m_bool(false), m_number(0.0) {}
+
+    // Parse a complete document. On failure returns false and sets error
+    // to a message including the line number.
+    static bool parse(const std::string& text, JsonValue& value, std::string& error);
+
+    Type getType() const { return m_type; }
+    bool isNull() const { return m_type == Type::Null; }
+    bool isBool() const { return m_type == Type::Bool; }
+    bool isNumber() const { return m_type == Type::Number; }
+    bool isString() const { return m_type == Type::String; }
+    bool isArray() const { return m_type == Type::Array; }
+    bool isObject() const { return m_type == Type::Object; }
+
+    bool asBool() const { return m_bool; }
+    double asNumber() const { return m_number; }
+    const std::string& asString() const { return m_string; }
+    const std::vector<JsonValue>& asArray() const { return m_array; }
+    const std::vector<Member>& asObject() const { return m_object; }
+
+    // Object member lookup (nullptr if missing or not an object)
+    const JsonValue* find(const std::string& key) const;
+
+private:
+    friend class JsonParser;
+
+    Type m_type;
+    bool m_bool;
+    double m_number;
+    std::string m_string;
+    std::vector<JsonValue> m_array;
+    std::vector<Member> m_object;
+};
+
+} // namespace Core
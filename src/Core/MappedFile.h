@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Core {
+
+// Read-only memory mapping of a whole file.
+// Pages are loaded on first access, so opening a large file is cheap and
+// only the parts that are read ever come off the disk.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map path. Returns false (and stays closed) if it cannot be opened.
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const void* getData() const { return m_data; }
+    size_t getSize() const { return m_size; }
+
+private:
+    const void* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    void* m_file;
+    void* m_mapping;
+#else
+    int m_fd;
+#endif
+};
+
+} // namespace Core
@@ -0,0 +1,203 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(BH_SIMD_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace Core {
+
+namespace {
+
+struct ZoneRecord {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// Ring of one thread; only the owner writes zones and the count
+struct ThreadBuffer {
+    std::unique_ptr<ZoneRecord[]> zones;
+    std::atomic<uint64_t> written;
+    int threadId;
+    std::string name;        // Guarded by the registry mutex
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::string exitPath;
+};
+
+// Never destroyed, so threads still recording during exit stay valid
+Registry& getRegistry() {
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+ThreadBuffer& getThreadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = registry.buffers.back().get();
+        buffer->zones.reset(new ZoneRecord[Profiler::RING_SIZE]);
+        buffer->written.store(0, std::memory_order_relaxed);
+        buffer->threadId = static_cast<int>(registry.buffers.size());
+        buffer->name = "Thread " + std::to_string(buffer->threadId);
+    }
+    return *buffer;
+}
+
+uint64_t steadyNanoseconds() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Trace timestamps are microseconds since startup. The tick rate is
+// measured against the steady clock over the whole run.
+const uint64_t START_TICKS = Profiler::now();
+const uint64_t START_NANOSECONDS = steadyNanoseconds();
+
+double getMicrosecondsPerTick() {
+#if defined(BH_SIMD_X86)
+    uint64_t ticks = Profiler::now() - START_TICKS;
+    uint64_t nanoseconds = steadyNanoseconds() - START_NANOSECONDS;
+    return ticks > 0 ? nanoseconds * 1e-3 / ticks : 1e-3;
+#else
+    return 1e-3;
+#endif
+}
+
+void writeJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+void writeExitTrace() {
+    Profiler::writeChromeTrace(getRegistry().exitPath);
+}
+
+} // namespace
+
+std::atomic<bool> Profiler::s_enabled(false);
+
+void Profiler::setThreadName(const std::string& name) {
+    // Threads only get a ring once they record
+    if (!isEnabled()) {
+        return;
+    }
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(getRegistry().mutex);
+    buffer.name = name;
+}
+
+uint64_t Profiler::now() {
+    // The counter is invariant on every x86 CPU this runs on and much
+    // cheaper to read than the steady clock
+#if defined(BH_SIMD_X86)
+    return __rdtsc();
+#else
+    return steadyNanoseconds();
+#endif
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = getThreadBuffer();
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    // Pairs with the fence in writeChromeTrace: the previous count is
+    // visible before this slot is overwritten
+    std::atomic_thread_fence(std::memory_order_release);
+    buffer.zones[index & (RING_SIZE - 1)] = { name, start, end };
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to open profile for writing: " << path << std::endl;
+        return false;
+    }
+
+    double usPerTick = getMicrosecondsPerTick();
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    size_t zoneCount = 0;
+    std::vector<ZoneRecord> zones;
+    for (const auto& buffer : registry.buffers) {
+        file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+             << buffer->threadId << ",\"args\":{\"name\":";
+        writeJsonString(file, buffer->name.c_str());
+        file << "}}";
+        first = false;
+
+        // Copy the ring, then drop whatever the owner overwrote meanwhile.
+        // Zone `after` may be half written, and it shares a slot with
+        // zone `after - RING_SIZE`, so that one is dropped as well.
+        uint64_t end = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = end > RING_SIZE ? end - RING_SIZE : 0;
+        zones.clear();
+        for (uint64_t i = begin; i < end; ++i) {
+            zones.push_back(buffer->zones[i & (RING_SIZE - 1)]);
+        }
+        // Seqlock-style re-check: the fence keeps the copies above from
+        // being reordered past the second load of written
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = buffer->written.load(std::memory_order_relaxed);
+        size_t skip = after + 1 > begin + RING_SIZE ? static_cast<size_t>(after + 1 - RING_SIZE - begin) : 0;
+
+        char times[64];
+        for (size_t i = skip; i < zones.size(); ++i) {
+            const ZoneRecord& zone = zones[i];
+            std::snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f",
+                          (static_cast<double>(zone.start) - START_TICKS) * usPerTick,
+                          (zone.end - zone.start) * usPerTick);
+            file << ",\n{\"name\":";
+            writeJsonString(file, zone.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << "," << times << "}";
+        }
+        zoneCount += zones.size() - std::min(skip, zones.size());
+    }
+    file << "\n]}\n";
+
+    if (!file) {
+        std::cerr << "Failed to write profile: " << path << std::endl;
+        return false;
+    }
+    std::cout << "Wrote " << zoneCount << " profile zones to " << path << std::endl;
+    return true;
+}
+
+void Profiler::writeAtExit(const std::string& path) {
+    Registry& registry = getRegistry();
+    bool registered = !registry.exitPath.empty();
+    registry.exitPath = path;
+    if (!registered) {
+        std::atexit(writeExitTrace);
+    }
+}
+
+} // namespace Core
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Core {
+
+// Scoped-zone CPU profiler with Chrome trace export (chrome://tracing or
+// ui.perfetto.dev). Each thread records into its own ring buffer that no
+// other thread writes, so recording takes no locks; once a ring is full
+// its oldest zones are overwritten. Zones are placed with PROFILE_ZONE,
+// which compiles to nothing unless BH_PROFILER is defined.
+class Profiler {
+public:
+    static constexpr size_t RING_SIZE = size_t(1) << 16;  // Zones kept per thread
+
+    // Recording is off until enabled (--profile)
+    static void setEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Name of the calling thread in the trace (ignored while disabled)
+    static void setThreadName(const std::string& name);
+
+    // Write the recorded zones of all threads as trace event JSON.
+    // May run while other threads record; zones they overwrite meanwhile
+    // are left out.
+    static bool writeChromeTrace(const std::string& path);
+    // Call writeChromeTrace(path) when the process exits
+    static void writeAtExit(const std::string& path);
+
+    // Timestamp in profiler ticks: the time stamp counter on x86, else
+    // steady clock nanoseconds. Converted to time when the trace is written.
+    static uint64_t now();
+    // Append a finished zone to the calling thread's ring. name must
+    // outlive the profiler (string literals).
+    static void record(const char* name, uint64_t start, uint64_t end);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// Records its own lifetime as a zone when the profiler is enabled
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name)
+        : m_name(Profiler::isEnabled() ? name : nullptr)
+        , m_start(m_name ? Profiler::now() : 0) {
+    }
+
+    ~ProfileZone() {
+        if (m_name) {
+            Profiler::record(m_name, m_start, Profiler::now());
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_start;
+};
+
+} // namespace Core
+
+#ifdef BH_PROFILER
+#define BH_PROFILE_CONCAT_INNER(a, b) a##b
+#define BH_PROFILE_CONCAT(a, b) BH_PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ::Core::ProfileZone BH_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) ::Core::Profiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
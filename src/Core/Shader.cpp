@@ -1,19 +1,109 @@
 #include "Shader.h"
+#include "CompileThread.h"
+#include "Profiler.h"
 #include <glad/glad.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 #include <glm/gtc/type_ptr.hpp>
 
 namespace Core {
 
+namespace {
+
+// Binary file layout: header, then length bytes from glGetProgramBinary
+struct BinaryFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t length;
+    uint64_t key;
+};
+
+constexpr char BINARY_FILE_MAGIC[4] = { 'B', 'H', 'S', 'B' };
+constexpr uint32_t BINARY_FILE_VERSION = 1;
+
+const char* shaderTypeName(unsigned int type) {
+    return type == GL_VERTEX_SHADER ? "Vertex" :
+           type == GL_FRAGMENT_SHADER ? "Fragment" : "Compute";
+}
+
+std::string getGLString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+} // namespace
+
+std::string Shader::s_binaryCacheDirectory;
+std::string Shader::s_driverId;
+int Shader::s_binaryCacheHits = 0;
+int Shader::s_binaryCacheMisses = 0;
+CompileThread* Shader::s_compileThread = nullptr;
+
+bool Shader::setBinaryCacheDirectory(const std::string& directory) {
+    s_binaryCacheDirectory.clear();
+    if (directory.empty()) {
+        return true;
+    }
+    
+    int formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0) {
+        std::cerr << "Driver has no program binary formats, shader cache disabled" << std::endl;
+        return false;
+    }
+    
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        std::cerr << "Failed to create shader cache directory " << directory << ": "
+                  << ec.message() << std::endl;
+        return false;
+    }
+    
+    // Binaries only load on the driver build that wrote them
+    s_driverId = getGLString(GL_VENDOR) + '\n' + getGLString(GL_RENDERER) + '\n' + getGLString(GL_VERSION);
+    s_binaryCacheDirectory = directory;
+    return true;
+}
+
 Shader::~Shader() {
+    if (m_workerCompile.valid()) {
+        m_workerCompile.wait();
+    }
+    for (unsigned int shader : m_pendingShaders) {
+        glDeleteShader(shader);
+    }
     if (m_program) {
         glDeleteProgram(m_program);
     }
 }
 
+bool Shader::enableParallelCompile() {
+    // Let the driver pick its own thread count
+#ifdef GL_KHR_parallel_shader_compile
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        return true;
+    }
+#endif
+#ifdef GL_ARB_parallel_shader_compile
+    if (GLAD_GL_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+        return true;
+    }
+#endif
+    return false;
+}
+
 bool Shader::loadFromFile(const std::string& vertexPath, const std::string& fragmentPath) {
+    PROFILE_ZONE("Shader::loadFromFile");
     std::string vertexSource = readFile(vertexPath);
     std::string fragmentSource = readFile(fragmentPath);
     
@@ -22,6 +112,11 @@ bool Shader::loadFromFile(const std::string& vertexPath, const std::string& frag
         return false;
     }
     
+    uint64_t key = binaryKey(vertexSource + '\0' + fragmentSource);
+    if (loadBinary(key)) {
+        return true;
+    }
+    
     unsigned int vertexShader = compileShader(vertexSource, GL_VERTEX_SHADER);
     unsigned int fragmentShader = compileShader(fragmentSource, GL_FRAGMENT_SHADER);
     
@@ -34,16 +129,26 @@ bool Shader::loadFromFile(const std::string& vertexPath, const std::string& frag
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
     
+    if (success) {
+        saveBinary(key);
+    }
     return success;
 }
 
-bool Shader::loadComputeShader(const std::string& computePath) {
+bool Shader::loadComputeShader(const std::string& computePath, const std::string& defines) {
+    PROFILE_ZONE("Shader::loadComputeShader");
     std::string computeSource = readFile(computePath);
     
     if (computeSource.empty()) {
         std::cerr << "Failed to read compute shader file" << std::endl;
         return false;
     }
+    computeSource = injectDefines(computeSource, defines);
+    
+    uint64_t key = binaryKey(computeSource);
+    if (loadBinary(key)) {
+        return true;
+    }
     
     unsigned int computeShader = compileShader(computeSource, GL_COMPUTE_SHADER);
     
@@ -55,9 +160,146 @@ bool Shader::loadComputeShader(const std::string& computePath) {
     
     glDeleteShader(computeShader);
     
+    if (success) {
+        saveBinary(key);
+    }
     return success;
 }
 
+bool Shader::beginFromFile(const std::string& vertexPath, const std::string& fragmentPath) {
+    std::string vertexSource = readFile(vertexPath);
+    std::string fragmentSource = readFile(fragmentPath);
+    
+    if (vertexSource.empty() || fragmentSource.empty()) {
+        std::cerr << "Failed to read shader files" << std::endl;
+        return false;
+    }
+    
+    return beginCompile({ { vertexSource, GL_VERTEX_SHADER }, { fragmentSource, GL_FRAGMENT_SHADER } });
+}
+
+bool Shader::beginComputeShader(const std::string& computePath, const std::string& defines) {
+    std::string computeSource = readFile(computePath);
+    
+    if (computeSource.empty()) {
+        std::cerr << "Failed to read compute shader file" << std::endl;
+        return false;
+    }
+    
+    return beginCompile({ { injectDefines(computeSource, defines), GL_COMPUTE_SHADER } });
+}
+
+bool Shader::beginCompile(const std::vector<ShaderSource>& sources) {
+    PROFILE_ZONE("Shader::beginCompile");
+    // Same key as the load calls, so both share cached binaries
+    std::string keySource = sources[0].first;
+    for (size_t i = 1; i < sources.size(); ++i) {
+        keySource += '\0' + sources[i].first;
+    }
+    
+    // A cached binary is ready at once, nothing is left pending
+    m_binaryKey = binaryKey(keySource);
+    if (loadBinary(m_binaryKey)) {
+        return true;
+    }
+    
+    m_compilePending = true;
+    if (s_compileThread && s_compileThread->isRunning()) {
+        m_workerCompile = s_compileThread->submit([this, sources]() { submitCompile(sources); });
+    } else {
+        submitCompile(sources);
+    }
+    return true;
+}
+
+void Shader::submitCompile(const std::vector<ShaderSource>& sources) {
+    PROFILE_ZONE("Shader::submitCompile");
+    // Compile and link without querying any status, which would block
+    m_program = glCreateProgram();
+    if (!s_binaryCacheDirectory.empty()) {
+        glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    for (const ShaderSource& source : sources) {
+        unsigned int shader = glCreateShader(source.second);
+        const char* src = source.first.c_str();
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+        glAttachShader(m_program, shader);
+        m_pendingShaders.push_back(shader);
+    }
+    glLinkProgram(m_program);
+}
+
+bool Shader::isCompileComplete() const {
+    if (!m_compilePending) {
+        return true;
+    }
+    if (m_workerCompile.valid()) {
+        return m_workerCompile.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+#ifdef GL_KHR_parallel_shader_compile
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+        int complete = 0;
+        glGetProgramiv(m_program, GL_COMPLETION_STATUS_KHR, &complete);
+        return complete != 0;
+    }
+#endif
+#ifdef GL_ARB_parallel_shader_compile
+    if (GLAD_GL_ARB_parallel_shader_compile) {
+        int complete = 0;
+        glGetProgramiv(m_program, GL_COMPLETION_STATUS_ARB, &complete);
+        return complete != 0;
+    }
+#endif
+    // Without the extensions the driver compiled synchronously
+    return true;
+}
+
+bool Shader::finishCompile() {
+    PROFILE_ZONE("Shader::finishCompile");
+    if (!m_compilePending) {
+        return m_program != 0;
+    }
+    if (m_workerCompile.valid()) {
+        m_workerCompile.get();
+    }
+    m_compilePending = false;
+    
+    int success = 1;
+    for (unsigned int shader : m_pendingShaders) {
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            char infoLog[1024];
+            int type = 0;
+            glGetShaderInfoLog(shader, 1024, nullptr, infoLog);
+            glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+            std::cerr << "Shader compilation error (" << shaderTypeName(type) << "):\n"
+                      << infoLog << std::endl;
+            break;
+        }
+    }
+    if (success) {
+        glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+        if (!success) {
+            char infoLog[1024];
+            glGetProgramInfoLog(m_program, 1024, nullptr, infoLog);
+            std::cerr << "Program linking error:\n" << infoLog << std::endl;
+        }
+    }
+    
+    for (unsigned int shader : m_pendingShaders) {
+        glDeleteShader(shader);
+    }
+    m_pendingShaders.clear();
+    if (!success) {
+        glDeleteProgram(m_program);
+        m_program = 0;
+        return false;
+    }
+    saveBinary(m_binaryKey);
+    return true;
+}
+
 void Shader::use() const {
     glUseProgram(m_program);
 }
@@ -77,9 +319,7 @@ unsigned int Shader::compileShader(const std::string& source, unsigned int type)
     if (!success) {
         char infoLog[1024];
         glGetShaderInfoLog(shader, 1024, nullptr, infoLog);
-        std::cerr << "Shader compilation error (" 
-                  << (type == GL_VERTEX_SHADER ? "Vertex" : 
-                      type == GL_FRAGMENT_SHADER ? "Fragment" : "Compute")
+        std::cerr << "Shader compilation error (" << shaderTypeName(type)
                   << "):\n" << infoLog << std::endl;
         glDeleteShader(shader);
         return 0;
@@ -90,6 +330,9 @@ unsigned int Shader::compileShader(const std::string& source, unsigned int type)
 
 bool Shader::linkProgram(unsigned int vertexShader, unsigned int fragmentShader) {
     m_program = glCreateProgram();
+    if (!s_binaryCacheDirectory.empty()) {
+        glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glAttachShader(m_program, vertexShader);
     glAttachShader(m_program, fragmentShader);
     glLinkProgram(m_program);
@@ -110,6 +353,9 @@ bool Shader::linkProgram(unsigned int vertexShader, unsigned int fragmentShader)
 
 bool Shader::linkComputeProgram(unsigned int computeShader) {
     m_program = glCreateProgram();
+    if (!s_binaryCacheDirectory.empty()) {
+        glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glAttachShader(m_program, computeShader);
     glLinkProgram(m_program);
     
@@ -139,6 +385,120 @@ std::string Shader::readFile(const std::string& path) {
     return buffer.str();
 }
 
+std::string Shader::injectDefines(const std::string& source, const std::string& defines) {
+    if (defines.empty()) {
+        return source;
+    }
+    
+    // #version must stay the first statement
+    size_t lineEnd = source.find('\n');
+    if (source.compare(0, 8, "#version") != 0 || lineEnd == std::string::npos) {
+        return defines + source;
+    }
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+bool Shader::loadBinary(uint64_t key) {
+    PROFILE_ZONE("Shader::loadBinary");
+    if (s_binaryCacheDirectory.empty()) {
+        return false;
+    }
+    
+    std::string path = binaryPath(key);
+    std::ifstream file(path, std::ios::binary);
+    BinaryFileHeader header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, BINARY_FILE_MAGIC, sizeof(BINARY_FILE_MAGIC)) != 0 ||
+        header.version != BINARY_FILE_VERSION ||
+        header.key != key) {
+        ++s_binaryCacheMisses;
+        return false;
+    }
+    
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size()))) {
+        ++s_binaryCacheMisses;
+        return false;
+    }
+    
+    // The driver may still reject a binary, e.g. after an update that kept
+    // the version string; the caller then compiles from source
+    m_program = glCreateProgram();
+    glProgramBinary(m_program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    int success;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+    if (!success) {
+        std::cerr << "Ignoring rejected program binary " << path << std::endl;
+        glDeleteProgram(m_program);
+        m_program = 0;
+        ++s_binaryCacheMisses;
+        return false;
+    }
+    
+    ++s_binaryCacheHits;
+    return true;
+}
+
+void Shader::saveBinary(uint64_t key) const {
+    PROFILE_ZONE("Shader::saveBinary");
+    if (s_binaryCacheDirectory.empty() || !m_program) {
+        return;
+    }
+    
+    int length = 0;
+    glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    glGetProgramBinary(m_program, length, &length, &format, binary.data());
+    
+    BinaryFileHeader header;
+    std::memcpy(header.magic, BINARY_FILE_MAGIC, sizeof(BINARY_FILE_MAGIC));
+    header.version = BINARY_FILE_VERSION;
+    header.format = format;
+    header.length = static_cast<uint32_t>(length);
+    header.key = key;
+    
+    // Write under a temporary name so a reader never loads a partial file
+    std::string path = binaryPath(key);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file) {
+            std::cerr << "Failed to write program binary: " << tempPath << std::endl;
+            return;
+        }
+    }
+    
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::cerr << "Failed to store program binary " << path << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+uint64_t Shader::binaryKey(const std::string& source) {
+    // FNV-1a over the driver strings and the complete source with its defines
+    std::string text = s_driverId + '\0' + source;
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string Shader::binaryPath(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bhsb", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(s_binaryCacheDirectory) / name).string();
+}
+
 int Shader::getUniformLocation(const std::string& name) {
     if (m_uniformCache.find(name) != m_uniformCache.end()) {
         return m_uniformCache[name];
@@ -1,19 +1,49 @@
 #pragma once
 
+#include <cstdint>
+#include <future>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <glm/glm.hpp>
 
 namespace Core {
 
+class CompileThread;
+
 class Shader {
 public:
-    Shader() : m_program(0) {}
+    Shader() : m_program(0), m_compilePending(false), m_binaryKey(0) {}
     ~Shader();
+    
+    // Directory of linked program binaries, keyed by the source (with its
+    // defines) and the driver; empty = always compile from source.
+    // Needs a current GL context, as it reads the driver strings.
+    static bool setBinaryCacheDirectory(const std::string& directory);
+    static const std::string& getBinaryCacheDirectory() { return s_binaryCacheDirectory; }
+    static int getBinaryCacheHits() { return s_binaryCacheHits; }
+    static int getBinaryCacheMisses() { return s_binaryCacheMisses; }
+    
+    // Let the driver compile on its own threads (GL_KHR_ or
+    // GL_ARB_parallel_shader_compile). Returns false if it cannot.
+    static bool enableParallelCompile();
+    // Without the extensions, begin*() compiles on this thread instead
+    static void setCompileThread(CompileThread* thread) { s_compileThread = thread; }
 
-    // Load and compile shaders
+    // Load and compile shaders. defines ("#define NAME value" lines) are
+    // inserted after the #version line to build variants of one source.
     bool loadFromFile(const std::string& vertexPath, const std::string& fragmentPath);
-    bool loadComputeShader(const std::string& computePath);
+    bool loadComputeShader(const std::string& computePath, const std::string& defines = "");
+    
+    // Start compiling without waiting: on driver threads with parallel
+    // compile, else on the compile thread if set, else synchronously.
+    // finishCompile() waits for it and reports errors like the load calls.
+    bool beginFromFile(const std::string& vertexPath, const std::string& fragmentPath);
+    bool beginComputeShader(const std::string& computePath, const std::string& defines = "");
+    bool isCompilePending() const { return m_compilePending; }
+    bool isCompileComplete() const;
+    bool finishCompile();
     
     // Use the shader
     void use() const;
@@ -32,14 +62,35 @@ public:
     unsigned int getProgram() const { return m_program; }
 
 private:
+    using ShaderSource = std::pair<std::string, unsigned int>;  // Source and shader type
+    
+    bool beginCompile(const std::vector<ShaderSource>& sources);
+    void submitCompile(const std::vector<ShaderSource>& sources);
     unsigned int compileShader(const std::string& source, unsigned int type);
     bool linkProgram(unsigned int vertexShader, unsigned int fragmentShader);
     bool linkComputeProgram(unsigned int computeShader);
     std::string readFile(const std::string& path);
+    static std::string injectDefines(const std::string& source, const std::string& defines);
+    
+    // Program binary cache; both are no-ops without a cache directory
+    bool loadBinary(uint64_t key);
+    void saveBinary(uint64_t key) const;
+    static uint64_t binaryKey(const std::string& source);
+    static std::string binaryPath(uint64_t key);
     int getUniformLocation(const std::string& name);
     
     unsigned int m_program;
+    bool m_compilePending;
+    std::vector<unsigned int> m_pendingShaders;  // Shaders of an unfinished begin*()
+    std::future<void> m_workerCompile;           // Set when compiled on the compile thread
+    uint64_t m_binaryKey;                        // Cache key of the pending program
     std::unordered_map<std::string, int> m_uniformCache;
+    
+    static std::string s_binaryCacheDirectory;
+    static std::string s_driverId;  // Vendor, renderer and version strings
+    static int s_binaryCacheHits;
+    static int s_binaryCacheMisses;
+    static CompileThread* s_compileThread;
 };
 
 } // namespace Core
@@ -1,4 +1,5 @@
 #include "Window.h"
+#include "Profiler.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <stdexcept>
@@ -8,6 +9,7 @@ namespace Core {
 
 Window::Window(int width, int height, const std::string& title)
     : m_width(width), m_height(height) {
+    PROFILE_ZONE("Window::Window");
     
     // Initialize GLFW
     if (!glfwInit()) {
@@ -72,10 +74,12 @@ bool Window::shouldClose() const {
 }
 
 void Window::pollEvents() {
+    PROFILE_ZONE("Window::pollEvents");
     glfwPollEvents();
 }
 
 void Window::swapBuffers() {
+    PROFILE_ZONE("Window::swapBuffers");
     glfwSwapBuffers(m_window);
 }
 
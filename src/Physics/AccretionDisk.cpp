@@ -1,6 +1,7 @@
 #include "AccretionDisk.h"
 #include "BlackHole.h"
 #include "Constants.h"
+#include "EmissionTables.h"
 #include <cmath>
 #include <algorithm>
 
@@ -47,7 +48,7 @@ glm::vec3 AccretionDisk::getVelocity(float radius, float phi) const {
 }
 
 glm::vec3 AccretionDisk::getEmission(float radius, float temperature) const {
-    // Convert temperature to color using blackbody approximation
+    // Blackbody colour from the precomputed table
     glm::vec3 color = temperatureToRGB(temperature);
     
     // Intensity falls off with radius
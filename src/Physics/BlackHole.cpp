@@ -1,10 +1,37 @@
 #include "BlackHole.h"
 #include "Constants.h"
+#include "KerrGeodesic.h"
+#include <glm/gtc/constants.hpp>
 #include <cmath>
 #include <algorithm>
 
 namespace Physics {
 
+namespace {
+
+// Below these the shadow is taken to be a circle about the direction to the hole
+constexpr double SHADOW_MIN_SPIN = 1e-3;
+constexpr double SHADOW_MIN_SIN_THETA = 1e-6;
+
+constexpr int SHADOW_SEARCH_ITERATIONS = 60;
+
+// Ring of directions at angle asin(sinAngle) around axis
+std::vector<glm::vec3> coneDirections(const glm::dvec3& axis, double sinAngle, int pointCount) {
+    glm::dvec3 helper = std::abs(axis.y) < 0.9 ? glm::dvec3(0.0, 1.0, 0.0) : glm::dvec3(1.0, 0.0, 0.0);
+    glm::dvec3 u = glm::normalize(glm::cross(axis, helper));
+    glm::dvec3 v = glm::cross(axis, u);
+    double cosAngle = std::sqrt(std::max(1.0 - sinAngle * sinAngle, 0.0));
+
+    std::vector<glm::vec3> directions(pointCount);
+    for (int i = 0; i < pointCount; ++i) {
+        double t = glm::two_pi<double>() * i / pointCount;
+        directions[i] = glm::vec3(cosAngle * axis + sinAngle * (std::cos(t) * u + std::sin(t) * v));
+    }
+    return directions;
+}
+
+} // namespace
+
 BlackHole::BlackHole(float mass, float spin)
     : m_mass(mass)
     , m_spin(std::clamp(spin, MIN_SPIN, MAX_SPIN))
@@ -101,6 +128,107 @@ float BlackHole::getFrameDraggingVelocity(float r, float theta) const {
     return numerator / denominator;
 }
 
+std::vector<glm::vec3> BlackHole::getShadowContour(const glm::vec3& cameraPosition, int pointCount) const {
+    const double M = m_schwarzschildRadius * 0.5;
+    const KerrGeodesic kerr(M, m_spin);
+    glm::vec3 rel = cameraPosition - m_position;
+    double r, theta, phi;
+    kerr.toBoyerLindquist(rel, r, theta, phi);
+
+    double r1, r2;
+    kerr.getPhotonOrbitRange(r1, r2);
+    if (r <= r2 || pointCount < 4) {
+        return {};
+    }
+    glm::dvec3 inward = -glm::normalize(glm::dvec3(rel));
+
+    // Static hole: impact parameter 3 sqrt(3) M, seen by a static observer
+    if (m_spin < SHADOW_MIN_SPIN) {
+        double sinAngle = 3.0 * std::sqrt(3.0) * M * std::sqrt(1.0 - 2.0 * M / r) / r;
+        return coneDirections(inward, sinAngle, pointCount);
+    }
+
+    double cosTheta = std::cos(theta);
+    double sinTheta = std::sin(theta);
+    double a2 = static_cast<double>(m_spinParameter) * m_spinParameter;
+
+    // On the spin axis only the orbit with L = 0 reaches the camera; L
+    // falls monotonically from r1 to r2
+    if (sinTheta < SHADOW_MIN_SIN_THETA) {
+        double lo = r1;
+        double hi = r2;
+        for (int i = 0; i < SHADOW_SEARCH_ITERATIONS; ++i) {
+            double mid = 0.5 * (lo + hi);
+            (kerr.getSphericalOrbit(mid).L > 0.0 ? lo : hi) = mid;
+        }
+        glm::vec3 direction;
+        if (!kerr.initialDirection(rel, kerr.getSphericalOrbit(0.5 * (lo + hi)), 1.0, direction)) {
+            return {};
+        }
+        double cosAngle = glm::dot(glm::dvec3(direction), inward);
+        return coneDirections(inward, std::sqrt(std::max(1.0 - cosAngle * cosAngle, 0.0)), pointCount);
+    }
+
+    // Orbits whose photons reach the camera's latitude: Theta(theta_o) >= 0,
+    // an interval of r around the orbit with the most room
+    double cot2 = cosTheta * cosTheta / (sinTheta * sinTheta);
+    auto latitudeRoom = [&](double orbit) {
+        KerrConstants constants = kerr.getSphericalOrbit(orbit);
+        return constants.Q + a2 * cosTheta * cosTheta - constants.L * constants.L * cot2;
+    };
+
+    const double goldenRatio = 0.5 * (std::sqrt(5.0) - 1.0);
+    double lo = r1;
+    double hi = r2;
+    for (int i = 0; i < SHADOW_SEARCH_ITERATIONS; ++i) {
+        double left = hi - goldenRatio * (hi - lo);
+        double right = lo + goldenRatio * (hi - lo);
+        if (latitudeRoom(left) < latitudeRoom(right)) {
+            lo = left;
+        } else {
+            hi = right;
+        }
+    }
+    double peak = 0.5 * (lo + hi);
+    if (latitudeRoom(peak) <= 0.0) {
+        return {};
+    }
+
+    // Ends of the interval, approached from the inside
+    auto edge = [&](double outside, double inside) {
+        if (latitudeRoom(outside) >= 0.0) {
+            return outside;
+        }
+        for (int i = 0; i < SHADOW_SEARCH_ITERATIONS; ++i) {
+            double mid = 0.5 * (outside + inside);
+            (latitudeRoom(mid) >= 0.0 ? inside : outside) = mid;
+        }
+        return inside;
+    };
+    double first = edge(r1, peak);
+    double last = edge(r2, peak);
+
+    // Across the interval with theta rising at the camera, then back with it
+    // falling; cosine spacing resolves the ends, where the curve turns fastest
+    std::vector<glm::vec3> contour;
+    contour.reserve(pointCount);
+    int half = pointCount / 2;
+    for (int side = 0; side < 2; ++side) {
+        for (int i = 0; i < half; ++i) {
+            double t = glm::pi<double>() * (side == 0 ? i : half - i) / half;
+            double orbit = first + (last - first) * 0.5 * (1.0 - std::cos(t));
+            glm::vec3 direction;
+            if (kerr.initialDirection(rel, kerr.getSphericalOrbit(orbit), side == 0 ? 1.0 : -1.0, direction)) {
+                contour.push_back(direction);
+            }
+        }
+    }
+    if (static_cast<int>(contour.size()) < half) {
+        return {};
+    }
+    return contour;
+}
+
 void BlackHole::updateDerivedQuantities() {
     // Calculate Schwarzschild radius in NORMALIZED units for visualization
     // Rs = 2GM/c^2, but we normalize for reasonable visualization scale
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <vector>
 
 namespace Physics {
 
@@ -36,6 +37,13 @@ public:
     // Frame dragging angular velocity
     float getFrameDraggingVelocity(float r, float theta) const;
     
+    // Edge of the shadow seen from cameraPosition: directions (unit, scene
+    // space) of pointCount rays around the critical curve, in order. They
+    // approach the spherical photon orbits, so every ray inside the curve
+    // falls in. Exact for the Kerr integrator's local observer; empty if the
+    // camera is not outside the photon orbits.
+    std::vector<glm::vec3> getShadowContour(const glm::vec3& cameraPosition, int pointCount = 256) const;
+    
 private:
     void updateDerivedQuantities();
     
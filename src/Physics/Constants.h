@@ -27,6 +27,7 @@ inline float schwarzschildRadius(float massInSolarMasses) {
 constexpr float DEFAULT_MASS = 4.31e6f;                   // M87 black hole in solar masses
 constexpr float MIN_SPIN = 0.0f;                          // Non-rotating (Schwarzschild)
 constexpr float MAX_SPIN = 0.998f;                        // Near-maximal rotation
+constexpr float SCHWARZSCHILD_SPIN_THRESHOLD = 0.01f;     // Below this the hole is treated as static
 
 // Accretion disk parameters
 constexpr float DISK_INNER_RADIUS_FACTOR = 3.0f;          // ISCO for Schwarzschild
@@ -48,42 +49,6 @@ constexpr float DEFAULT_FOV = 60.0f;
 constexpr float NEAR_PLANE = 0.1f;
 constexpr float FAR_PLANE = 1000.0f;
 
-// Color temperature to RGB conversion
-inline glm::vec3 temperatureToRGB(float temperature) {
-    // Simplified blackbody color approximation
-    temperature = glm::clamp(temperature / 1000.0f, 1.0f, 40.0f);
-    
-    glm::vec3 color;
-    
-    // Red
-    if (temperature <= 66.0f) {
-        color.r = 1.0f;
-    } else {
-        float t = temperature - 60.0f;
-        color.r = glm::clamp(1.292936186f * glm::pow(t, -0.1332047592f), 0.0f, 1.0f);
-    }
-    
-    // Green
-    if (temperature <= 66.0f) {
-        color.g = glm::clamp(0.39008157876f * glm::log(temperature) - 0.63184144378f, 0.0f, 1.0f);
-    } else {
-        float t = temperature - 60.0f;
-        color.g = glm::clamp(1.129890861f * glm::pow(t, -0.0755148492f), 0.0f, 1.0f);
-    }
-    
-    // Blue
-    if (temperature >= 66.0f) {
-        color.b = 1.0f;
-    } else if (temperature <= 19.0f) {
-        color.b = 0.0f;
-    } else {
-        float t = temperature - 10.0f;
-        color.b = glm::clamp(0.54320678911f * glm::log(t) - 1.19625408914f, 0.0f, 1.0f);
-    }
-    
-    return color;
-}
-
 // Doppler shift factor calculation
 inline float dopplerFactor(float velocity, float cosTheta) {
     float beta = velocity / SPEED_OF_LIGHT;
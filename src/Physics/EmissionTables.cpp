@@ -0,0 +1,152 @@
+#include "EmissionTables.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Physics {
+
+namespace {
+
+using Texel = EmissionTables::Texel;
+
+// Table coordinates (same constants in shade.comp): log T spans the table
+// width, D its height, both in texels
+constexpr float LOG_MIN_TEMPERATURE = 6.907755279f;    // ln(1000)
+constexpr float LOG_MAX_TEMPERATURE = 10.596634733f;   // ln(40000)
+constexpr float TEMPERATURE_SCALE = (EmissionTables::TEMPERATURE_SAMPLES - 1)
+                                    / (LOG_MAX_TEMPERATURE - LOG_MIN_TEMPERATURE);
+constexpr float DOPPLER_SCALE = (EmissionTables::DOPPLER_SAMPLES - 1)
+                                / (EmissionTables::MAX_DOPPLER - EmissionTables::MIN_DOPPLER);
+
+// Second radiation constant h c / k (m K)
+constexpr double PLANCK_C2 = 1.438776877e-2;
+
+// Visible range and step of the spectral integration (nm)
+constexpr double LAMBDA_MIN = 380.0;
+constexpr double LAMBDA_MAX = 780.0;
+constexpr double LAMBDA_STEP = 5.0;
+
+// Piecewise Gaussian lobe of the CIE fit
+double lobe(double lambda, double mu, double sigmaLow, double sigmaHigh) {
+    double t = (lambda - mu) / (lambda < mu ? sigmaLow : sigmaHigh);
+    return std::exp(-0.5 * t * t);
+}
+
+// CIE 1931 2-degree colour matching functions, multi-lobe fit of
+// Wyman, Sloan and Shirley (2013)
+glm::dvec3 colorMatching(double lambda) {
+    double x = 1.056 * lobe(lambda, 599.8, 37.9, 31.0)
+             + 0.362 * lobe(lambda, 442.0, 16.0, 26.7)
+             - 0.065 * lobe(lambda, 501.1, 20.4, 26.2);
+    double y = 0.821 * lobe(lambda, 568.8, 46.9, 40.5)
+             + 0.286 * lobe(lambda, 530.9, 16.3, 31.1);
+    double z = 1.217 * lobe(lambda, 437.0, 11.8, 36.0)
+             + 0.681 * lobe(lambda, 459.0, 26.0, 13.8);
+    return glm::dvec3(x, y, z);
+}
+
+// Colour matching functions at each integration wavelength
+const std::vector<glm::dvec3>& colorMatchingSamples() {
+    static const std::vector<glm::dvec3> samples = [] {
+        std::vector<glm::dvec3> result;
+        for (double lambda = LAMBDA_MIN; lambda <= LAMBDA_MAX; lambda += LAMBDA_STEP) {
+            result.push_back(colorMatching(lambda));
+        }
+        return result;
+    }();
+    return samples;
+}
+
+// Planck spectral radiance up to a constant factor
+double planck(double lambdaNm, double temperature) {
+    double lambda = lambdaNm * 1e-9;
+    return 1.0 / (lambda * lambda * lambda * lambda * lambda
+                  * (std::exp(PLANCK_C2 / (lambda * temperature)) - 1.0));
+}
+
+float temperatureCoordinate(float temperature) {
+    float x = (std::log(temperature) - LOG_MIN_TEMPERATURE) * TEMPERATURE_SCALE;
+    return std::clamp(x, 0.0f, float(EmissionTables::TEMPERATURE_SAMPLES - 1));
+}
+
+float dopplerCoordinate(float doppler) {
+    float y = (doppler - EmissionTables::MIN_DOPPLER) * DOPPLER_SCALE;
+    return std::clamp(y, 0.0f, float(EmissionTables::DOPPLER_SAMPLES - 1));
+}
+
+Texel toTexel(const glm::vec3& c) {
+    return Texel{c.r, c.g, c.b, 1.0f};
+}
+
+// a + (b - a) t, the same expression shade.comp uses (not glm::mix)
+glm::vec3 lerp(const glm::vec3& a, const glm::vec3& b, float t) {
+    return glm::vec3(a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t, a.b + (b.b - a.b) * t);
+}
+
+// Linear read along one table row, as sampleLutRow() in shade.comp
+glm::vec3 sampleRow(const Texel* row, float x) {
+    int x0 = std::min(int(x), EmissionTables::TEMPERATURE_SAMPLES - 2);
+    float t = x - float(x0);
+    const Texel& a = row[x0];
+    const Texel& b = row[x0 + 1];
+    return lerp(glm::vec3(a.r, a.g, a.b), glm::vec3(b.r, b.g, b.b), t);
+}
+
+} // namespace
+
+const EmissionTables& EmissionTables::get() {
+    static const EmissionTables tables;
+    return tables;
+}
+
+EmissionTables::EmissionTables()
+    : m_blackbody(TEMPERATURE_SAMPLES)
+    , m_doppler(static_cast<size_t>(TEMPERATURE_SAMPLES) * DOPPLER_SAMPLES) {
+    std::vector<double> temperatures(TEMPERATURE_SAMPLES);
+    for (int i = 0; i < TEMPERATURE_SAMPLES; ++i) {
+        temperatures[i] = std::exp(LOG_MIN_TEMPERATURE + i / double(TEMPERATURE_SCALE));
+        m_blackbody[i] = toTexel(integrateBlackbody(temperatures[i]));
+    }
+
+    for (int j = 0; j < DOPPLER_SAMPLES; ++j) {
+        double doppler = MIN_DOPPLER + j / double(DOPPLER_SCALE);
+        float beaming = static_cast<float>(doppler * doppler * doppler);
+        for (int i = 0; i < TEMPERATURE_SAMPLES; ++i) {
+            double observed = std::clamp(temperatures[i] * doppler,
+                                         double(MIN_TEMPERATURE), double(MAX_TEMPERATURE));
+            m_doppler[j * TEMPERATURE_SAMPLES + i] = toTexel(integrateBlackbody(observed) * beaming);
+        }
+    }
+}
+
+glm::vec3 EmissionTables::blackbody(float temperature) const {
+    return sampleRow(m_blackbody.data(), temperatureCoordinate(temperature));
+}
+
+glm::vec3 EmissionTables::shifted(float temperature, float doppler) const {
+    // Bilinear, in the same order as sampleDopplerLut() in shade.comp
+    float x = temperatureCoordinate(temperature);
+    float y = dopplerCoordinate(doppler);
+    int y0 = std::min(int(y), DOPPLER_SAMPLES - 2);
+    const Texel* row = m_doppler.data() + y0 * TEMPERATURE_SAMPLES;
+    return lerp(sampleRow(row, x), sampleRow(row + TEMPERATURE_SAMPLES, x), y - float(y0));
+}
+
+glm::vec3 EmissionTables::integrateBlackbody(double temperature) {
+    const std::vector<glm::dvec3>& cmf = colorMatchingSamples();
+    glm::dvec3 xyz(0.0);
+    for (size_t i = 0; i < cmf.size(); ++i) {
+        xyz += cmf[i] * planck(LAMBDA_MIN + i * LAMBDA_STEP, temperature);
+    }
+
+    // XYZ to linear sRGB (D65); colours outside the gamut lose their negative part
+    glm::dvec3 rgb(
+         3.2406 * xyz.x - 1.5372 * xyz.y - 0.4986 * xyz.z,
+        -0.9689 * xyz.x + 1.8758 * xyz.y + 0.0415 * xyz.z,
+         0.0557 * xyz.x - 0.2040 * xyz.y + 1.0570 * xyz.z);
+    rgb = glm::max(rgb, glm::dvec3(0.0));
+
+    double peak = std::max(rgb.r, std::max(rgb.g, rgb.b));
+    return glm::vec3(rgb / peak);
+}
+
+} // namespace Physics
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Physics {
+
+// Precomputed emission colours shared by the CPU tracer and shade.comp.
+//
+// The blackbody table maps temperature to the linear sRGB colour of a
+// Planck spectrum, integrated against the CIE 1931 colour matching
+// functions and scaled so the brightest channel is 1. The Doppler table
+// adds the disk's velocity shift: a source at temperature T seen with
+// Doppler factor D looks like a blackbody at D T, brightened by D^3
+// (relativistic beaming of specific intensity).
+//
+// Both tables are built once, spaced logarithmically in temperature and
+// read with the same bilinear interpolation on both paths; the GPU fetches
+// the texels with texelFetch, so the two paths see identical numbers.
+class EmissionTables {
+public:
+    static constexpr int TEMPERATURE_SAMPLES = 256;   // Log-spaced in T
+    static constexpr int DOPPLER_SAMPLES = 64;        // Linear in D
+
+    static constexpr float MIN_TEMPERATURE = 1000.0f;   // K; outside the range colours clamp
+    static constexpr float MAX_TEMPERATURE = 40000.0f;
+    static constexpr float MIN_DOPPLER = 0.5f;
+    static constexpr float MAX_DOPPLER = 1.5f;
+
+    // One RGBA32F texel, the layout uploaded to the GPU
+    struct alignas(16) Texel {
+        float r, g, b, a;
+    };
+
+    // Tables are built on first use (thread-safe)
+    static const EmissionTables& get();
+
+    // Blackbody colour at temperature (K)
+    glm::vec3 blackbody(float temperature) const;
+
+    // Colour of a blackbody at temperature seen with Doppler factor doppler
+    glm::vec3 shifted(float temperature, float doppler) const;
+
+    // TEMPERATURE_SAMPLES texels
+    const std::vector<Texel>& getBlackbodyData() const { return m_blackbody; }
+
+    // DOPPLER_SAMPLES rows of TEMPERATURE_SAMPLES texels, one row per Doppler factor
+    const std::vector<Texel>& getDopplerData() const { return m_doppler; }
+
+    // Spectral integration used to build the tables (slow)
+    static glm::vec3 integrateBlackbody(double temperature);
+
+private:
+    EmissionTables();
+
+    std::vector<Texel> m_blackbody;
+    std::vector<Texel> m_doppler;
+};
+
+// Blackbody colour lookup (brightest channel 1)
+inline glm::vec3 temperatureToRGB(float temperature) {
+    return EmissionTables::get().blackbody(temperature);
+}
+
+} // namespace Physics
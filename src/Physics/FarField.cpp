@@ -0,0 +1,148 @@
+#include "FarField.h"
+#include "Quadrature.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Physics {
+
+namespace {
+
+constexpr int TURNING_POINT_ITERATIONS = 8;
+
+// e(u) of the model law
+double modelFactor(double mass, double u) {
+    return std::exp(-mass * u - 1.5 * mass * mass * u * u);
+}
+
+// d(w^2)/du
+double potentialSlope(FarFieldLaw law, double mass, double u) {
+    if (law == FarFieldLaw::Model) {
+        double e = modelFactor(mass, u);
+        return 2.0 * u * e * e * (1.0 - mass * u - 3.0 * mass * mass * u * u);
+    }
+    return 2.0 * u * (1.0 - 3.0 * mass * u);
+}
+
+// (psi - sin(psi) cos(psi)) / sin^2(psi)
+double sweepShape(double psi) {
+    if (psi < 1e-2) {
+        return (2.0 / 3.0) * psi;
+    }
+    double sinPsi = std::sin(psi);
+    return (psi - sinPsi * std::cos(psi)) / (sinPsi * sinPsi);
+}
+
+// Photon sphere: where w^2 peaks
+double potentialPeak(FarFieldLaw law, double mass) {
+    if (law == FarFieldLaw::Model) {
+        return (std::sqrt(13.0) - 1.0) / (6.0 * mass);
+    }
+    return 1.0 / (3.0 * mass);
+}
+
+} // namespace
+
+double orbitPotential(FarFieldLaw law, double mass, double u) {
+    if (law == FarFieldLaw::Model) {
+        double e = modelFactor(mass, u);
+        return u * u * e * e;
+    }
+    return u * u * (1.0 - 2.0 * mass * u);
+}
+
+double orbitSweep(FarFieldLaw law, double mass, double u, double slope2) {
+    // Substituting s^2 = slope2 + (u - u') dw^2/du(u) makes the integrand
+    // smooth on [slope, S], also when the path starts at its periapsis
+    double slope = std::sqrt(std::max(slope2, 0.0));
+    double potential = orbitPotential(law, mass, u);
+    double qEnd = potentialSlope(law, mass, u);
+    double end = std::sqrt(slope2 + u * qEnd);
+
+    return detail::integrate(slope, end, 1, [&](double s) {
+        double v = u - (s * s - slope2) / qEnd;
+        double e = law == FarFieldLaw::Model ? modelFactor(mass, v) : 1.0;
+        double y = slope2 + potential - orbitPotential(law, mass, v);
+        return e * (2.0 * s / qEnd) / std::sqrt(y);
+    });
+}
+
+double orbitTurningPoint(FarFieldLaw law, double mass, double invL2) {
+    // Newton from the flat-space periapsis, which lies just before the root
+    double lo = std::sqrt(invL2);
+    double hi = potentialPeak(law, mass);
+    double u = lo;
+    for (int i = 0; i < TURNING_POINT_ITERATIONS; ++i) {
+        double f = invL2 - orbitPotential(law, mass, u);
+        u = std::clamp(u + f / potentialSlope(law, mass, u), lo, hi);
+    }
+    return u;
+}
+
+glm::dvec3 spinDeflection(FarFieldLaw law, double mass, double spin, const glm::dvec3& rel,
+                          const glm::dvec3& dir, double entryRadius) {
+    // Along the line rel + x dir, with impact vector b = rel - x0 dir, the
+    // integrals below are closed forms in x0 and x1 (the entry point, or
+    // infinity), written so that near-radial lines do not cancel
+    double x0 = glm::dot(rel, dir);
+    glm::dvec3 impact = rel - x0 * dir;
+    double b = glm::length(impact);
+    double r0 = glm::length(rel);
+    if (b < 1e-6 * r0) {
+        return glm::dvec3(0.0);
+    }
+    glm::dvec3 bHat = impact / b;
+    bool toInfinity = entryRadius <= 0.0;
+    double x1 = toInfinity ? 0.0 : -std::sqrt(std::max(entryRadius * entryRadius - b * b, 0.0));
+    double r1 = std::sqrt(b * b + x1 * x1);
+    glm::dvec3 axis(0.0, 1.0, 0.0);
+
+    glm::dvec3 turn;
+    if (law == FarFieldLaw::Model) {
+        // a = K (axis x r) / r^4 with K = 2 M a Rs |spin|:
+        //   K ((axis x b) int dx / r^4 + (axis x dir) int x dx / r^4)
+        if (std::abs(spin) <= 0.01) {
+            return glm::dvec3(0.0);
+        }
+        const double pi = 3.14159265358979323846;
+        double k = 4.0 * mass * mass * mass * spin * std::abs(spin);
+        double psi0 = std::acos(std::clamp(x0 / r0, -1.0, 1.0));
+        double along;    // b int dx / r^4
+        double outward;  // int x dx / r^4
+        if (toInfinity) {
+            along = 0.5 * sweepShape(psi0) / (r0 * r0);
+            outward = 0.5 / (r0 * r0);
+        } else {
+            double psi1 = std::acos(std::clamp(x1 / r1, -1.0, 1.0));
+            along = 0.5 * (sweepShape(pi - psi1) / (r1 * r1) - sweepShape(pi - psi0) / (r0 * r0));
+            outward = 0.5 / (r0 * r0) - 0.5 / (r1 * r1);
+        }
+        turn = k * (glm::cross(axis, bHat) * along + glm::cross(axis, dir) * outward);
+    } else {
+        // Acceleration 2 B x dir in the dipole field B = (3 (J.n) n - J) / r^3,
+        // J = a M axis. With s = x / r:
+        //   d1 = [s] / b^2, d2 = [2s - s^3] / b^2, d3 = [1 / r^3]
+        double d1, d2, d3;
+        if (toInfinity) {
+            double kInf = 1.0 / (r0 * (r0 + x0));  // (1 - s0) / b^2
+            double k0 = 1.0 - x0 / r0;
+            d1 = kInf;
+            d2 = kInf * (-1.0 + 3.0 * k0 - k0 * k0);
+            d3 = -1.0 / (r0 * r0 * r0);
+        } else {
+            double g0 = 1.0 + x0 / r0;
+            double g1 = 1.0 + x1 / r1;
+            double gInv0 = 1.0 / (r0 * (r0 - x0));  // (1 + s) / b^2
+            double gInv1 = 1.0 / (r1 * (r1 - x1));
+            d1 = gInv1 - gInv0;
+            d2 = gInv1 * (-g1 * g1 + 3.0 * g1 - 1.0) - gInv0 * (-g0 * g0 + 3.0 * g0 - 1.0);
+            d3 = 1.0 / (r1 * r1 * r1) - 1.0 / (r0 * r0 * r0);
+        }
+        glm::dvec3 mHat = glm::cross(dir, bHat);
+        glm::dvec3 spinVector = (spin * mass * mass) * axis;
+        turn = (-2.0 * glm::dot(spinVector, bHat) * d2 + 2.0 * b * glm::dot(spinVector, dir) * d3) * mHat -
+               2.0 * glm::dot(spinVector, mHat) * d1 * bHat;
+    }
+    return turn - glm::dot(turn, dir) * dir;
+}
+
+} // namespace Physics
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Physics {
+
+// Closed-form ray propagation far from the black hole.
+//
+// Outside a sphere of influence the tracers stop marching and take the
+// rest of a ray's path from these expressions (mirrored in raytracer.comp).
+// Both laws keep a ray in a plane through the hole. With u = 1 / r and
+// alpha the angle between the ray and the outward radial,
+// w(u) / sin(alpha) is conserved, and along the path
+//   dphi = e(u) du / sqrt(Y(u)),   Y(u) = 1/L^2 - w^2(u),   L = sin(alpha) / w(u)
+//
+// Model:         law of the fixed-step and RK45 integrators (acceleration
+//                M / r^2 (1 + 3M / r) towards the hole, only its part
+//                perpendicular to the ray bends it); alpha in coordinates,
+//                w = u e(u), e(u) = exp(-M u - 3/2 M^2 u^2)
+// Schwarzschild: photon orbits; alpha as seen by a static observer,
+//                w^2 = u^2 (1 - 2M u), e = 1 (Y is (du/dphi)^2, L the
+//                impact parameter)
+//
+// Frame dragging is added on top, to first order (see spinDeflection).
+enum class FarFieldLaw {
+    Model,
+    Schwarzschild
+};
+
+// w^2(u)
+double orbitPotential(FarFieldLaw law, double mass, double u);
+
+// In-plane angle swept between u and infinity by a path with Y = slope2
+// at u, on a branch without turning point. Holds outside the law's photon
+// sphere; 4-point Gauss-Legendre after a substitution that removes the
+// endpoint singularity of grazing rays.
+double orbitSweep(FarFieldLaw law, double mass, double u, double slope2);
+
+// Periapsis u of a path with 1/L^2 = invL2 that passes outside the photon
+// sphere: the smallest root of Y
+double orbitTurningPoint(FarFieldLaw law, double mass, double invL2);
+
+// Turn of a ray by the hole's spin (axis +y, spin in [-1, 1]), integrated
+// along the straight line through rel (relative to the hole) along the
+// unit direction dir: to infinity, or with entryRadius > 0 only up to
+// where the line comes within entryRadius on its way in. Model: the
+// integrators' frame-dragging acceleration; Schwarzschild: the
+// gravitomagnetic bending of Kerr, 4 a M / b^2 for an equatorial pass.
+// Perpendicular to dir; add it to the direction.
+glm::dvec3 spinDeflection(FarFieldLaw law, double mass, double spin, const glm::dvec3& rel,
+                          const glm::dvec3& dir, double entryRadius);
+
+} // namespace Physics
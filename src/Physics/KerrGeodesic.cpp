@@ -0,0 +1,273 @@
+#include "KerrGeodesic.h"
+#include "Quadrature.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Physics {
+
+namespace {
+
+// Keeps 1 / sin(theta) finite for rays that start exactly on the spin axis
+constexpr double MIN_SIN_THETA = 1e-8;
+
+// Panels of the Mino-time quadratures
+constexpr int RADIAL_PANELS = 4;
+constexpr int POLAR_PANELS = 4;
+
+} // namespace
+
+KerrGeodesic::KerrGeodesic(double mass, double spin)
+    : m_mass(mass)
+    , m_a(spin * mass) {
+    m_horizon = m_mass + std::sqrt(std::max(m_mass * m_mass - m_a * m_a, 0.0));
+}
+
+bool KerrGeodesic::initialize(const glm::vec3& position, const glm::vec3& direction,
+                              KerrConstants& constants, KerrState& state) const {
+    double r, theta, phi;
+    toBoyerLindquist(position, r, theta, phi);
+    if (r <= m_horizon) {
+        return false;
+    }
+
+    Observer observer = observerAt(r, theta, phi);
+    glm::dvec3 dir = glm::normalize(glm::dvec3(direction));
+    double nR = glm::dot(dir, observer.eR);
+    double nTheta = glm::dot(dir, observer.eTheta);
+    double nPhi = glm::dot(dir, observer.ePhi);
+
+    // Covariant momentum for unit energy measured by the ZAMO
+    double L = observer.cylindricalRadius * nPhi;
+    double E = observer.lapse + observer.omega * L;
+    double pr = std::sqrt(observer.sigma / observer.delta) * nR;
+    double ptheta = std::sqrt(observer.sigma) * nTheta;
+
+    // Rescale to E = 1
+    L /= E;
+    pr /= E;
+    ptheta /= E;
+
+    double a2 = m_a * m_a;
+    double sinTheta = std::sin(theta);
+    double cosTheta = std::cos(theta);
+    double sin2 = std::max(sinTheta * sinTheta, MIN_SIN_THETA * MIN_SIN_THETA);
+    constants.L = L;
+    constants.Q = ptheta * ptheta + cosTheta * cosTheta * (L * L / sin2 - a2);
+
+    // Mino time: dr/dlambda = Delta p_r, dtheta/dlambda = p_theta
+    state.r = r;
+    state.theta = theta;
+    state.phi = phi;
+    state.pr = observer.delta * pr;
+    state.ptheta = ptheta;
+    return true;
+}
+
+bool KerrGeodesic::initialDirection(const glm::vec3& position, const KerrConstants& constants,
+                                    double thetaSign, glm::vec3& direction) const {
+    double r, theta, phi;
+    toBoyerLindquist(position, r, theta, phi);
+    if (r <= m_horizon) {
+        return false;
+    }
+
+    double a = m_a;
+    double a2 = a * a;
+    double L = constants.L;
+    double sinTheta = std::max(std::sin(theta), MIN_SIN_THETA);
+    double cosTheta = std::cos(theta);
+    Observer observer = observerAt(r, theta, phi);
+
+    double P = r * r + a2 - a * L;
+    double R = P * P - observer.delta * (constants.Q + (L - a) * (L - a));
+    double Theta = constants.Q + cosTheta * cosTheta * (a2 - L * L / (sinTheta * sinTheta));
+    double E = observer.lapse / (1.0 - observer.omega * L);  // ZAMO energy of the E = 1 photon
+    if (R < 0.0 || Theta < 0.0 || E <= 0.0) {
+        return false;
+    }
+
+    double nR = -std::sqrt(R) * E / std::sqrt(observer.sigma * observer.delta);
+    double nTheta = std::copysign(std::sqrt(Theta), thetaSign) * E / std::sqrt(observer.sigma);
+    double nPhi = L * E / observer.cylindricalRadius;
+    direction = glm::vec3(glm::normalize(nR * observer.eR + nTheta * observer.eTheta + nPhi * observer.ePhi));
+    return true;
+}
+
+void KerrGeodesic::getPhotonOrbitRange(double& r1, double& r2) const {
+    double spin = std::min(std::abs(m_a) / m_mass, 1.0);
+    r1 = 2.0 * m_mass * (1.0 + std::cos(2.0 / 3.0 * std::acos(-spin)));
+    r2 = 2.0 * m_mass * (1.0 + std::cos(2.0 / 3.0 * std::acos(spin)));
+}
+
+KerrConstants KerrGeodesic::getSphericalOrbit(double r) const {
+    // Double root of R(r); a must not be zero
+    double M = m_mass;
+    double a = m_a;
+    double a2 = a * a;
+    double rm = r - M;
+    KerrConstants constants;
+    constants.L = (r * r * (3.0 * M - r) - a2 * (r + M)) / (a * rm);
+    constants.Q = r * r * r * (4.0 * a2 * M - r * (r - 3.0 * M) * (r - 3.0 * M)) / (a2 * rm * rm);
+    return constants;
+}
+
+double KerrGeodesic::radialMinoTime(const KerrConstants& constants, double r0, double r1) const {
+    // dlambda = du / sqrt(R u^4) with u = 1 / r, where
+    //   R u^4 = (1 + (a^2 - aL) u^2)^2 - (u^2 - 2M u^3 + a^2 u^4) (Q + (L - a)^2)
+    // stays away from zero for photons that fall in
+    double a = m_a;
+    double a2 = a * a;
+    double K = constants.Q + (constants.L - a) * (constants.L - a);
+    bool turns = false;
+    double time = detail::integrate(1.0 / r0, 1.0 / r1, RADIAL_PANELS, [&](double u) {
+        double u2 = u * u;
+        double p = 1.0 + (a2 - a * constants.L) * u2;
+        double ru4 = p * p - u2 * (1.0 - 2.0 * m_mass * u + a2 * u2) * K;
+        if (ru4 <= 0.0) {
+            turns = true;
+            return 0.0;
+        }
+        return 1.0 / std::sqrt(ru4);
+    });
+    return turns ? std::numeric_limits<double>::infinity() : time;
+}
+
+double KerrGeodesic::equatorMinoTime(const KerrConstants& constants, const KerrState& state,
+                                     double& period) const {
+    double Q = constants.Q;
+    if (Q <= 0.0) {
+        period = std::numeric_limits<double>::infinity();
+        return period;
+    }
+
+    // With mu = cos(theta), (dmu/dlambda)^2 = (mu+^2 - mu^2)(a^2 mu^2 + Q / mu+^2),
+    // mu+^2 the positive root of a^2 mu^4 + (Q + L^2 - a^2) mu^2 - Q. Then
+    // mu = mu+ sin(chi) gives dlambda = dchi / sqrt(a^2 mu+^2 sin^2 chi + Q / mu+^2).
+    double a2 = m_a * m_a;
+    double b = Q + constants.L * constants.L - a2;
+    double turning2 = 2.0 * Q / (b + std::sqrt(b * b + 4.0 * a2 * Q));
+    auto rate = [&](double chi) {
+        double s = std::sin(chi);
+        return 1.0 / std::sqrt(a2 * turning2 * s * s + Q / turning2);
+    };
+
+    double mu = std::cos(state.theta);
+    double chi = std::asin(std::min(std::abs(mu) / std::sqrt(turning2), 1.0));
+    double toTurning = detail::integrate(0.0, glm::half_pi<double>(), POLAR_PANELS, rate);
+    double toEquator = detail::integrate(0.0, chi, POLAR_PANELS, rate);
+    period = 2.0 * toTurning;
+
+    // Heading away from the plane first: out to the turning point and back.
+    // A photon on the plane counts as crossing it now.
+    bool approaching = mu * state.ptheta >= 0.0;
+    return approaching ? toEquator : period - toEquator;
+}
+
+KerrGeodesic::Observer KerrGeodesic::observerAt(double r, double theta, double phi) const {
+    double rho = std::sqrt(r * r + m_a * m_a);
+    double sinTheta = std::sin(theta);
+    double cosTheta = std::cos(theta);
+    double sinPhi = std::sin(phi);
+    double cosPhi = std::cos(phi);
+
+    Observer observer;
+    glm::dvec3 dr(r / rho * sinTheta * cosPhi, cosTheta, -r / rho * sinTheta * sinPhi);
+    glm::dvec3 dtheta(rho * cosTheta * cosPhi, -r * sinTheta, -rho * cosTheta * sinPhi);
+    observer.eR = glm::normalize(dr);
+    observer.eTheta = glm::normalize(dtheta - glm::dot(dtheta, observer.eR) * observer.eR);
+    observer.ePhi = glm::cross(observer.eR, observer.eTheta);
+
+    double a2 = m_a * m_a;
+    double A = (r * r + a2) * (r * r + a2) - a2 * (r * r - 2.0 * m_mass * r + a2) * sinTheta * sinTheta;
+    observer.sigma = r * r + a2 * cosTheta * cosTheta;
+    observer.delta = r * r - 2.0 * m_mass * r + a2;
+    observer.omega = 2.0 * m_mass * m_a * r / A;
+    observer.lapse = std::sqrt(observer.sigma * observer.delta / A);
+    observer.cylindricalRadius = std::sqrt(A / observer.sigma) * sinTheta;
+    return observer;
+}
+
+KerrState KerrGeodesic::derivative(const KerrConstants& constants, const KerrState& state) const {
+    double r = state.r;
+    double a = m_a;
+    double a2 = a * a;
+    double L = constants.L;
+    double Q = constants.Q;
+
+    double sinTheta = std::sin(state.theta);
+    double cosTheta = std::cos(state.theta);
+    if (std::abs(sinTheta) < MIN_SIN_THETA) {
+        sinTheta = sinTheta < 0.0 ? -MIN_SIN_THETA : MIN_SIN_THETA;
+    }
+    double sin2 = sinTheta * sinTheta;
+
+    double delta = r * r - 2.0 * m_mass * r + a2;
+    double P = r * r + a2 - a * L;
+    double K = Q + (L - a) * (L - a);
+
+    KerrState rate;
+    rate.r = state.pr;
+    rate.theta = state.ptheta;
+    rate.phi = L / sin2 - a + a * P / delta;
+    rate.pr = 2.0 * r * P - (r - m_mass) * K;                                   // R'(r) / 2
+    rate.ptheta = cosTheta * (L * L / (sin2 * sinTheta) - a2 * sinTheta);       // Theta'(theta) / 2
+    return rate;
+}
+
+void KerrGeodesic::project(const KerrConstants& constants, KerrState& state) const {
+    double r = state.r;
+    double a = m_a;
+    double a2 = a * a;
+    double L = constants.L;
+
+    double sinTheta = std::max(std::abs(std::sin(state.theta)), MIN_SIN_THETA);
+    double cosTheta = std::cos(state.theta);
+
+    double delta = r * r - 2.0 * m_mass * r + a2;
+    double P = r * r + a2 - a * L;
+    double R = P * P - delta * (constants.Q + (L - a) * (L - a));
+    double Theta = constants.Q + cosTheta * cosTheta * (a2 - L * L / (sinTheta * sinTheta));
+
+    // Past a turning point R or Theta is slightly negative; the momentum is
+    // then zero and the second-order equations turn the ray around
+    state.pr = std::copysign(std::sqrt(std::max(R, 0.0)), state.pr);
+    state.ptheta = std::copysign(std::sqrt(std::max(Theta, 0.0)), state.ptheta);
+}
+
+void KerrGeodesic::toBoyerLindquist(const glm::vec3& position, double& r, double& theta, double& phi) const {
+    glm::dvec3 p(position);
+    double a2 = m_a * m_a;
+    double rho2 = glm::dot(p, p);
+
+    // r^4 - (rho^2 - a^2) r^2 - a^2 y^2 = 0
+    double b = rho2 - a2;
+    r = std::sqrt(0.5 * (b + std::sqrt(b * b + 4.0 * a2 * p.y * p.y)));
+    theta = r > 0.0 ? std::acos(std::clamp(p.y / r, -1.0, 1.0)) : glm::half_pi<double>();
+    phi = std::atan2(-p.z, p.x);
+}
+
+glm::vec3 KerrGeodesic::toCartesian(double r, double theta, double phi) const {
+    double rho = std::sqrt(r * r + m_a * m_a);
+    return glm::vec3(rho * std::sin(theta) * std::cos(phi),
+                     r * std::cos(theta),
+                     -rho * std::sin(theta) * std::sin(phi));
+}
+
+glm::vec3 KerrGeodesic::cartesianVelocity(const KerrState& state, const KerrState& rate) const {
+    double r = state.r;
+    double rho = std::sqrt(r * r + m_a * m_a);
+    double sinTheta = std::sin(state.theta);
+    double cosTheta = std::cos(state.theta);
+    double sinPhi = std::sin(state.phi);
+    double cosPhi = std::cos(state.phi);
+
+    glm::dvec3 dr(r / rho * sinTheta * cosPhi, cosTheta, -r / rho * sinTheta * sinPhi);
+    glm::dvec3 dtheta(rho * cosTheta * cosPhi, -r * sinTheta, -rho * cosTheta * sinPhi);
+    glm::dvec3 dphi(-rho * sinTheta * sinPhi, 0.0, -rho * sinTheta * cosPhi);
+
+    return glm::vec3(dr * rate.r + dtheta * rate.theta + dphi * rate.phi);
+}
+
+} // namespace Physics
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Physics {
+
+// Boyer-Lindquist position and Mino-time momenta of a photon
+struct KerrState {
+    double r;
+    double theta;
+    double phi;
+    double pr;      // dr/dlambda
+    double ptheta;  // dtheta/dlambda
+};
+
+inline KerrState operator+(const KerrState& a, const KerrState& b) {
+    return KerrState{ a.r + b.r, a.theta + b.theta, a.phi + b.phi, a.pr + b.pr, a.ptheta + b.ptheta };
+}
+
+inline KerrState operator*(double s, const KerrState& a) {
+    return KerrState{ s * a.r, s * a.theta, s * a.phi, s * a.pr, s * a.ptheta };
+}
+
+// Conserved quantities of a photon, scaled so that the energy E is 1
+struct KerrConstants {
+    double L;  // Axial angular momentum
+    double Q;  // Carter constant
+};
+
+// Null geodesics of a Kerr black hole in Boyer-Lindquist coordinates.
+//
+// With E, L and Q fixed per ray the geodesic equations in Mino time
+// (dlambda = dtau / Sigma) separate into
+//   (dr/dlambda)^2     = R(r)     = ((r^2 + a^2) - aL)^2 - Delta (Q + (L - a)^2)
+//   (dtheta/dlambda)^2 = Theta(t) = Q + a^2 cos^2 t - L^2 cot^2 t
+//   dphi/dlambda       = L / sin^2 theta - a + a ((r^2 + a^2) - aL) / Delta
+// r and theta are integrated in second-order form (d2r/dlambda2 = R'/2),
+// which passes through radial and polar turning points without sign
+// bookkeeping.
+//
+// Scene coordinates map to Boyer-Lindquist through oblate spheroidal
+// coordinates with the spin axis along +y and the black hole rotating
+// the same way as the frame dragging term in raytracer.comp:
+//   x = sqrt(r^2 + a^2) sin(theta) cos(phi)
+//   y = r cos(theta)
+//   z = -sqrt(r^2 + a^2) sin(theta) sin(phi)
+class KerrGeodesic {
+public:
+    // mass is M in scene units (Rs / 2), spin is dimensionless a / M
+    KerrGeodesic(double mass, double spin);
+
+    double getMass() const { return m_mass; }
+    double getSpinParameter() const { return m_a; }
+    double getHorizonRadius() const { return m_horizon; }
+
+    // Conserved quantities and initial state of a photon leaving position
+    // (relative to the black hole) along direction, as seen by the
+    // zero-angular-momentum observer there. Returns false inside the horizon.
+    bool initialize(const glm::vec3& position, const glm::vec3& direction,
+                    KerrConstants& constants, KerrState& state) const;
+
+    // Inverse of initialize: scene-space direction at position of an inbound
+    // photon with the given constants, moving towards larger theta if
+    // thetaSign > 0. Returns false where the constants allow no photon.
+    bool initialDirection(const glm::vec3& position, const KerrConstants& constants,
+                          double thetaSign, glm::vec3& direction) const;
+
+    // Spherical photon orbits exist for r in [r1, r2] (prograde to retrograde).
+    // Constants of the orbit at r; rays with them approach it asymptotically
+    // and outline the shadow.
+    void getPhotonOrbitRange(double& r1, double& r2) const;
+    KerrConstants getSphericalOrbit(double r) const;
+
+    // Mino time an inbound photon takes from r0 down to r1 < r0, for constants
+    // without a radial turning point in between (infinity if there is one)
+    double radialMinoTime(const KerrConstants& constants, double r0, double r1) const;
+
+    // Mino time until the photon in state first reaches the equatorial plane,
+    // with the time between later crossings in period. Infinity if it never
+    // does (Q <= 0).
+    double equatorMinoTime(const KerrConstants& constants, const KerrState& state, double& period) const;
+
+    // Mino-time derivative of state
+    KerrState derivative(const KerrConstants& constants, const KerrState& state) const;
+
+    // Put the momenta back on the constraint surface dr/dlambda = +-sqrt(R),
+    // dtheta/dlambda = +-sqrt(Theta), keeping their signs. Rays that start
+    // far away carry |dr/dlambda| ~ r^2, so a tiny relative error there
+    // would otherwise become a large one close to the hole.
+    void project(const KerrConstants& constants, KerrState& state) const;
+
+    // Boyer-Lindquist <-> scene coordinates (relative to the black hole)
+    void toBoyerLindquist(const glm::vec3& position, double& r, double& theta, double& phi) const;
+    glm::vec3 toCartesian(double r, double theta, double phi) const;
+
+    // Scene-space velocity of a state moving with derivative rate
+    glm::vec3 cartesianVelocity(const KerrState& state, const KerrState& rate) const;
+
+private:
+    // Orthonormal spatial triad of the zero-angular-momentum observer,
+    // aligned with the coordinate directions, and the metric functions there
+    struct Observer {
+        glm::dvec3 eR;
+        glm::dvec3 eTheta;
+        glm::dvec3 ePhi;
+        double sigma;
+        double delta;
+        double omega;              // Frame dragging angular velocity
+        double lapse;
+        double cylindricalRadius;  // sqrt(g_phiphi)
+    };
+    Observer observerAt(double r, double theta, double phi) const;
+
+    double m_mass;
+    double m_a;
+    double m_horizon;
+};
+
+} // namespace Physics
@@ -0,0 +1,29 @@
+#pragma once
+
+namespace Physics {
+namespace detail {
+
+// Gauss-Legendre nodes and weights on [-1, 1], shared by the far-field and
+// Kerr Mino-time integrals (raytracer.comp keeps its own float copy)
+constexpr int GAUSS_POINTS = 4;
+constexpr double GAUSS_NODE[GAUSS_POINTS] = { -0.8611363115940526, -0.3399810435848563,
+                                               0.3399810435848563, 0.8611363115940526 };
+constexpr double GAUSS_WEIGHT[GAUSS_POINTS] = { 0.3478548451374538, 0.6521451548625461,
+                                                 0.6521451548625461, 0.3478548451374538 };
+
+// Composite Gauss-Legendre integral of f over [lo, hi]
+template <typename F>
+double integrate(double lo, double hi, int panels, F f) {
+    double width = (hi - lo) / panels;
+    double sum = 0.0;
+    for (int panel = 0; panel < panels; ++panel) {
+        double mid = lo + (panel + 0.5) * width;
+        for (int i = 0; i < GAUSS_POINTS; ++i) {
+            sum += GAUSS_WEIGHT[i] * f(mid + 0.5 * width * GAUSS_NODE[i]);
+        }
+    }
+    return 0.5 * width * sum;
+}
+
+} // namespace detail
+} // namespace Physics
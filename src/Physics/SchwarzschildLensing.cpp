@@ -0,0 +1,214 @@
+#include "SchwarzschildLensing.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace Physics {
+
+namespace {
+
+constexpr int HEADER_FLOATS = sizeof(SchwarzschildLensing::RowInfo) / sizeof(float);
+
+// Same capture radius as the Kerr integrator at a = 0
+constexpr double CAPTURE_RADIUS_FACTOR = 1.01;
+
+// Orbits still circling the photon sphere after this many turns are
+// treated as captured
+constexpr double MAX_WINDING = 6.0 * glm::pi<double>();
+
+// Step control of the Binet integration: at most MAX_DPHI per step and
+// about U_CHANGE relative change of u
+constexpr double MAX_DPHI = 0.01;
+constexpr double U_CHANGE = 0.02;
+
+// d/dphi (u, du/dphi) for the Binet equation u'' = 3 M u^2 - u
+glm::dvec2 binet(const glm::dvec2& y, double M) {
+    return glm::dvec2(y.y, 3.0 * M * y.x * y.x - y.x);
+}
+
+} // namespace
+
+SchwarzschildLensing::SchwarzschildLensing()
+    : m_mass(0.0f)
+    , m_cameraRadius(0.0f)
+    , m_criticalAngle(0.0f)
+    , m_lastBuildTime(0.0) {
+}
+
+bool SchwarzschildLensing::build(float mass, float cameraRadius) {
+    if (mass == m_mass && matchesCameraRadius(cameraRadius)) {
+        return false;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    m_mass = mass;
+    m_cameraRadius = cameraRadius;
+
+    // Rays at the critical impact parameter 3 sqrt(3) M approach the photon
+    // sphere asymptotically. Seen from r0 by a static observer:
+    //   sin(alpha_c) = 3 sqrt(3) M sqrt(1 - 2M / r0) / r0
+    // on the inward side outside the photon sphere, outward side inside it
+    double M = mass;
+    double r0 = cameraRadius;
+    double s = 3.0 * std::sqrt(3.0) * M * std::sqrt(std::max(1.0 - 2.0 * M / r0, 0.0)) / r0;
+    double asinS = std::asin(std::min(s, 1.0));
+    m_criticalAngle = static_cast<float>(r0 >= 3.0 * M ? glm::pi<double>() - asinS : asinS);
+
+    m_data.assign(static_cast<size_t>(ROWS) * (HEADER_FLOATS + SAMPLES), 0.0f);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for (int row = 0; row < ROWS; ++row) {
+        buildRow(row);
+    }
+
+    m_lastBuildTime = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+bool SchwarzschildLensing::matchesCameraRadius(float cameraRadius) const {
+    return isValid() && std::abs(cameraRadius - m_cameraRadius) <= RADIUS_TOLERANCE * m_cameraRadius;
+}
+
+float SchwarzschildLensing::rowCoordinate(float alpha) const {
+    const float pi = glm::pi<float>();
+    float tc = m_criticalAngle / pi;
+    if (alpha < m_criticalAngle) {
+        return tc - tc * std::sqrt(std::max((m_criticalAngle - alpha) / m_criticalAngle, 0.0f));
+    }
+    return tc + (1.0f - tc) * std::sqrt(std::max((alpha - m_criticalAngle) / (pi - m_criticalAngle), 0.0f));
+}
+
+float SchwarzschildLensing::rowAngle(float t) const {
+    const float pi = glm::pi<float>();
+    float tc = m_criticalAngle / pi;
+    if (t < tc) {
+        float x = (tc - t) / tc;
+        return m_criticalAngle - m_criticalAngle * x * x;
+    }
+    float x = (t - tc) / (1.0f - tc);
+    return m_criticalAngle + (pi - m_criticalAngle) * x * x;
+}
+
+const SchwarzschildLensing::RowInfo& SchwarzschildLensing::getRow(int row) const {
+    return *reinterpret_cast<const RowInfo*>(&m_data[static_cast<size_t>(row) * HEADER_FLOATS]);
+}
+
+const float* SchwarzschildLensing::getSamples(int row) const {
+    return &m_data[static_cast<size_t>(ROWS) * HEADER_FLOATS + static_cast<size_t>(row) * SAMPLES];
+}
+
+float SchwarzschildLensing::sampleU(int row, float phi) const {
+    const RowInfo& info = getRow(row);
+    const float* samples = getSamples(row);
+    if (info.phiEnd <= 0.0f) {
+        return samples[0];
+    }
+
+    float x = glm::clamp(phi / info.phiEnd, 0.0f, 1.0f) * (SAMPLES - 1);
+    int i = std::min(static_cast<int>(x), SAMPLES - 2);
+    float f = x - static_cast<float>(i);
+    return samples[i] + (samples[i + 1] - samples[i]) * f;
+}
+
+void SchwarzschildLensing::buildRow(int row) {
+    RowInfo& info = *reinterpret_cast<RowInfo*>(&m_data[static_cast<size_t>(row) * HEADER_FLOATS]);
+    float* samples = &m_data[static_cast<size_t>(ROWS) * HEADER_FLOATS + static_cast<size_t>(row) * SAMPLES];
+
+    const double M = m_mass;
+    const double u0 = 1.0 / m_cameraRadius;
+    const double uCapture = 1.0 / (2.0 * M * CAPTURE_RADIUS_FACTOR);
+    const double uPhotonSphere = 1.0 / (3.0 * M + 0.1);
+
+    double alpha = rowAngle(static_cast<float>(row) / (ROWS - 1));
+    double sinAlpha = std::sin(alpha);
+    double cosAlpha = std::cos(alpha);
+
+    info.phiPhotonSphere = -1.0f;
+    info.padding = 0.0f;
+    std::fill(samples, samples + SAMPLES, static_cast<float>(u0));
+
+    // Camera inside the capture radius, or a purely radial ray
+    if (u0 >= uCapture || sinAlpha < 1e-6) {
+        bool captured = u0 >= uCapture || cosAlpha < 0.0;
+        info.phiEnd = 0.0f;
+        info.fate = static_cast<float>(captured ? Captured : Escaped);
+        if (captured && u0 < uPhotonSphere) {
+            info.phiPhotonSphere = 0.0f;
+        }
+        return;
+    }
+
+    // Static observer at r0: du/dphi = -u0 sqrt(1 - 2 M u0) cot(alpha)
+    glm::dvec2 y(u0, -u0 * std::sqrt(1.0 - 2.0 * M * u0) * cosAlpha / sinAlpha);
+    double phi = 0.0;
+    Fate fate = Escaped;
+
+    // Dense (phi, u) trace, resampled uniformly once the end is known
+    std::vector<glm::dvec2> trace;
+    trace.reserve(1024);
+    trace.emplace_back(0.0, y.x);
+
+    if (y.x >= uPhotonSphere) {
+        info.phiPhotonSphere = 0.0f;
+    }
+
+    while (true) {
+        double h = std::min(MAX_DPHI, U_CHANGE * std::max(y.x, 0.2 * u0) / std::max(std::abs(y.y), 1e-12));
+
+        glm::dvec2 k1 = binet(y, M);
+        glm::dvec2 k2 = binet(y + 0.5 * h * k1, M);
+        glm::dvec2 k3 = binet(y + 0.5 * h * k2, M);
+        glm::dvec2 k4 = binet(y + h * k3, M);
+        glm::dvec2 next = y + (h / 6.0) * (k1 + 2.0 * k2 + 2.0 * k3 + k4);
+
+        if (next.x <= 0.0) {
+            // Escaped: u reaches zero at the asymptote
+            phi += h * y.x / (y.x - next.x);
+            trace.emplace_back(phi, 0.0);
+            fate = Escaped;
+            break;
+        }
+        if (next.x >= uCapture) {
+            phi += h * (uCapture - y.x) / (next.x - y.x);
+            trace.emplace_back(phi, uCapture);
+            fate = Captured;
+            break;
+        }
+
+        phi += h;
+        y = next;
+        trace.emplace_back(phi, y.x);
+
+        if (info.phiPhotonSphere < 0.0f && y.x >= uPhotonSphere) {
+            info.phiPhotonSphere = static_cast<float>(phi);
+        }
+        if (phi > MAX_WINDING) {
+            fate = Captured;
+            break;
+        }
+    }
+
+    info.phiEnd = static_cast<float>(phi);
+    info.fate = static_cast<float>(fate);
+
+    // Resample onto SAMPLES uniform angles in [0, phiEnd]
+    size_t j = 0;
+    for (int i = 0; i < SAMPLES; ++i) {
+        double target = phi * i / (SAMPLES - 1);
+        while (j + 2 < trace.size() && trace[j + 1].x < target) {
+            ++j;
+        }
+        const glm::dvec2& a = trace[j];
+        const glm::dvec2& b = trace[j + 1];
+        double f = b.x > a.x ? glm::clamp((target - a.x) / (b.x - a.x), 0.0, 1.0) : 0.0;
+        samples[i] = static_cast<float>(a.y + (b.y - a.y) * f);
+    }
+}
+
+} // namespace Physics
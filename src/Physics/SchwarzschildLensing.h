@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+
+namespace Physics {
+
+// Precomputed photon orbits of a non-rotating black hole seen from one
+// camera radius.
+//
+// Around a Schwarzschild hole every ray stays in the plane spanned by the
+// camera position and its direction, and its path only depends on the
+// angle alpha between the ray and the outward radial direction (i.e. on
+// the impact parameter). Each table row solves the Binet equation
+//   d2u/dphi2 = 3 M u^2 - u,   u = 1 / r
+// once for one alpha and stores u at uniformly spaced in-plane angles phi
+// up to the angle where the orbit escapes (u = 0) or is captured. A ray is
+// then traced by looking up its row; disk crossings and the escape
+// direction follow from phi without any marching.
+//
+// Rows are spaced quadratically around the critical angle of the photon
+// sphere, where orbits change fastest.
+class SchwarzschildLensing {
+public:
+    static constexpr int ROWS = 2048;
+    static constexpr int SAMPLES = 256;
+
+    enum Fate {
+        Escaped = 0,
+        Captured = 1
+    };
+
+    // Per-row summary, stored ahead of the samples in getData()
+    struct RowInfo {
+        float phiEnd;            // In-plane angle at escape (u = 0) or capture
+        float fate;              // Fate as float so the table is one float array
+        float phiPhotonSphere;   // First angle inside the photon sphere indicator, or -1
+        float padding;
+    };
+
+    SchwarzschildLensing();
+
+    // Camera radii within this relative distance of the table's share it:
+    // an orbiting camera's radius jitters in the last bits from rounding
+    static constexpr float RADIUS_TOLERANCE = 1e-4f;
+
+    // Rebuild for mass M (scene units, Rs / 2) and camera radius r0.
+    // Returns false if the table already matches (nothing to do).
+    bool build(float mass, float cameraRadius);
+
+    // Whether rays from cameraRadius can be looked up in the table
+    bool matchesCameraRadius(float cameraRadius) const;
+
+    bool isValid() const { return m_cameraRadius > 0.0f; }
+    float getMass() const { return m_mass; }
+    float getCameraRadius() const { return m_cameraRadius; }
+    float getCriticalAngle() const { return m_criticalAngle; }
+    double getLastBuildTime() const { return m_lastBuildTime; }
+
+    // Row coordinate t in [0, 1] of a ray at angle alpha from the radial direction
+    float rowCoordinate(float alpha) const;
+    float rowAngle(float t) const;
+
+    const RowInfo& getRow(int row) const;
+    const float* getSamples(int row) const;
+
+    // u = 1/r of row at in-plane angle phi (clamped to the sampled range)
+    float sampleU(int row, float phi) const;
+
+    // ROWS RowInfo entries followed by ROWS * SAMPLES values of u, as uploaded
+    // to raytracer.comp
+    const std::vector<float>& getData() const { return m_data; }
+
+private:
+    void buildRow(int row);
+
+    float m_mass;
+    float m_cameraRadius;
+    float m_criticalAngle;
+    double m_lastBuildTime;
+    std::vector<float> m_data;
+};
+
+} // namespace Physics
@@ -0,0 +1,486 @@
+#include "BatchRenderer.h"
+#include "OfflineRenderer.h"
+#include "ImageWriter.h"
+#include "Integrator.h"
+#include "../Core/Json.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace Rendering {
+
+namespace {
+
+// Frames generated from one keyframe list; guards against typos like
+// "frame": 2000000000 allocating billions of frames
+constexpr int MAX_KEYFRAME_SPAN = 1000000;
+
+bool readVec3(const Core::JsonValue& value, glm::vec3& out) {
+    if (!value.isArray() || value.asArray().size() != 3) {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        if (!value.asArray()[i].isNumber()) {
+            return false;
+        }
+        out[i] = static_cast<float>(value.asArray()[i].asNumber());
+    }
+    return true;
+}
+
+bool readFloat(const Core::JsonValue& value, float& out) {
+    if (!value.isNumber()) {
+        return false;
+    }
+    out = static_cast<float>(value.asNumber());
+    return true;
+}
+
+// Whole numbers in int range only: 2.7 or 1e10 are errors, not 2 or UB
+bool readInt(const Core::JsonValue& value, int& out) {
+    if (!value.isNumber()) {
+        return false;
+    }
+    double number = value.asNumber();
+    if (number != std::floor(number) ||
+        number < static_cast<double>(std::numeric_limits<int>::min()) ||
+        number > static_cast<double>(std::numeric_limits<int>::max())) {
+        return false;
+    }
+    out = static_cast<int>(number);
+    return true;
+}
+
+bool readBool(const Core::JsonValue& value, bool& out) {
+    if (!value.isBool()) {
+        return false;
+    }
+    out = value.asBool();
+    return true;
+}
+
+bool readIntegrator(const Core::JsonValue& value, std::string& out) {
+    GeodesicIntegrator integrator;
+    if (!value.isString() || !parseIntegratorName(value.asString(), integrator)) {
+        return false;
+    }
+    out = value.asString();
+    return true;
+}
+
+// Apply one scene key. Returns false if the key is unknown or has the wrong type.
+bool applySceneKey(const std::string& key, const Core::JsonValue& value, Core::LaunchOptions& options) {
+    if (key == "mass") return readFloat(value, options.mass) && options.mass > 0.0f;
+    if (key == "spin") return readFloat(value, options.spin) && options.spin >= 0.0f && options.spin < 1.0f;
+    if (key == "camera") return readVec3(value, options.cameraPosition);
+    if (key == "target") return readVec3(value, options.cameraTarget);
+    if (key == "fov") return readFloat(value, options.fov) && options.fov > 0.0f && options.fov < 180.0f;
+    if (key == "diskInner") return readFloat(value, options.diskInnerRadius) && options.diskInnerRadius >= 0.0f;
+    if (key == "diskOuter") return readFloat(value, options.diskOuterRadius) && options.diskOuterRadius >= 0.0f;
+    if (key == "showDisk") return readBool(value, options.showAccretionDisk);
+    if (key == "showPhotonSphere") return readBool(value, options.showPhotonSphere);
+    if (key == "exposure") return readFloat(value, options.exposure);
+    if (key == "steps") return readInt(value, options.maxSteps) && options.maxSteps > 0;
+    if (key == "stepSize") return readFloat(value, options.stepSize) && options.stepSize > 0.0f;
+    if (key == "integrator") return readIntegrator(value, options.integrator);
+    if (key == "tolerance") return readFloat(value, options.tolerance) && options.tolerance > 0.0f;
+    if (key == "influenceRadius") {
+        return readFloat(value, options.influenceRadius) &&
+               (options.influenceRadius == 0.0f ||
+                (options.influenceRadius >= MIN_INFLUENCE_RADIUS && options.influenceRadius <= MAX_INFLUENCE_RADIUS));
+    }
+    return false;
+}
+
+// Apply every member of object except the structural keys listed in skip
+bool applySceneObject(const Core::JsonValue& object, std::initializer_list<const char*> skip,
+                      Core::LaunchOptions& options, const std::string& context) {
+    for (const auto& member : object.asObject()) {
+        bool structural = std::any_of(skip.begin(), skip.end(),
+                                      [&](const char* key) { return member.first == key; });
+        if (structural) {
+            continue;
+        }
+        if (!applySceneKey(member.first, member.second, options)) {
+            std::cerr << "Job file: invalid or unknown key \"" << member.first << "\" in " << context << std::endl;
+            return false;
+        }
+    }
+    if (options.diskInnerRadius > 0.0f && options.diskOuterRadius > 0.0f &&
+        options.diskInnerRadius >= options.diskOuterRadius) {
+        std::cerr << "Job file: \"diskInner\" must be smaller than \"diskOuter\" in " << context << std::endl;
+        return false;
+    }
+    return true;
+}
+
+float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+// Interpolate the camera on a sphere around the target so that orbits
+// given as a few keyframes stay circular instead of cutting chords
+glm::vec3 interpolateCamera(const Core::LaunchOptions& a, const Core::LaunchOptions& b,
+                            const glm::vec3& target, float t) {
+    glm::vec3 offsetA = a.cameraPosition - a.cameraTarget;
+    glm::vec3 offsetB = b.cameraPosition - b.cameraTarget;
+    float radiusA = glm::length(offsetA);
+    float radiusB = glm::length(offsetB);
+    if (radiusA < 1e-6f || radiusB < 1e-6f) {
+        return glm::mix(a.cameraPosition, b.cameraPosition, t);
+    }
+
+    float azimuthA = std::atan2(offsetA.z, offsetA.x);
+    float azimuthB = std::atan2(offsetB.z, offsetB.x);
+    float elevationA = std::asin(glm::clamp(offsetA.y / radiusA, -1.0f, 1.0f));
+    float elevationB = std::asin(glm::clamp(offsetB.y / radiusB, -1.0f, 1.0f));
+
+    // Shortest way around
+    float deltaAzimuth = azimuthB - azimuthA;
+    if (deltaAzimuth > glm::pi<float>()) deltaAzimuth -= glm::two_pi<float>();
+    if (deltaAzimuth < -glm::pi<float>()) deltaAzimuth += glm::two_pi<float>();
+
+    float radius = lerp(radiusA, radiusB, t);
+    float azimuth = azimuthA + deltaAzimuth * t;
+    float elevation = lerp(elevationA, elevationB, t);
+
+    return target + radius * glm::vec3(std::cos(elevation) * std::cos(azimuth),
+                                       std::sin(elevation),
+                                       std::cos(elevation) * std::sin(azimuth));
+}
+
+Core::LaunchOptions interpolate(const Core::LaunchOptions& a, const Core::LaunchOptions& b, float t) {
+    Core::LaunchOptions result = a;
+
+    // Mass sweeps span orders of magnitude, so interpolate geometrically
+    result.mass = std::exp(lerp(std::log(a.mass), std::log(b.mass), t));
+    result.spin = lerp(a.spin, b.spin, t);
+    result.cameraTarget = glm::mix(a.cameraTarget, b.cameraTarget, t);
+    result.cameraPosition = interpolateCamera(a, b, result.cameraTarget, t);
+    result.fov = lerp(a.fov, b.fov, t);
+    result.exposure = lerp(a.exposure, b.exposure, t);
+    result.stepSize = lerp(a.stepSize, b.stepSize, t);
+    result.tolerance = std::exp(lerp(std::log(a.tolerance), std::log(b.tolerance), t));
+
+    // 0 means "derive from the black hole", which cannot be blended
+    if (a.diskInnerRadius > 0.0f && b.diskInnerRadius > 0.0f) {
+        result.diskInnerRadius = lerp(a.diskInnerRadius, b.diskInnerRadius, t);
+    }
+    if (a.diskOuterRadius > 0.0f && b.diskOuterRadius > 0.0f) {
+        result.diskOuterRadius = lerp(a.diskOuterRadius, b.diskOuterRadius, t);
+    }
+
+    return result;
+}
+
+std::string formatDuration(double seconds) {
+    int total = static_cast<int>(seconds + 0.5);
+    std::ostringstream out;
+    if (total >= 3600) {
+        out << total / 3600 << "h ";
+    }
+    if (total >= 60) {
+        out << (total / 60) % 60 << "m ";
+    }
+    out << total % 60 << "s";
+    return out.str();
+}
+
+} // namespace
+
+BatchRenderer::BatchRenderer(const Core::LaunchOptions& defaults)
+    : m_defaults(defaults) {
+}
+
+bool BatchRenderer::loadJobFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open job file: " << path << std::endl;
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return loadJobText(buffer.str(), path);
+}
+
+bool BatchRenderer::loadJobText(const std::string& text, const std::string& name) {
+    Core::JsonValue root;
+    std::string error;
+    if (!Core::JsonValue::parse(text, root, error)) {
+        std::cerr << "Failed to parse job file " << name << ": " << error << std::endl;
+        return false;
+    }
+
+    m_frames.clear();
+    if (!parseJob(root)) {
+        m_frames.clear();
+        return false;
+    }
+
+    std::cout << "Loaded job file " << name << ": " << m_frames.size() << " frames" << std::endl;
+    return true;
+}
+
+bool BatchRenderer::parseJob(const Core::JsonValue& root) {
+    if (!root.isObject()) {
+        std::cerr << "Job file: top level must be an object" << std::endl;
+        return false;
+    }
+
+    // Job-wide settings
+    if (const Core::JsonValue* size = root.find("size")) {
+        char trailing = 0;
+        if (!size->isString() ||
+            std::sscanf(size->asString().c_str(), "%dx%d%c", &m_defaults.width, &m_defaults.height, &trailing) != 2) {
+            std::cerr << "Job file: \"size\" must be a string like \"1920x1080\"" << std::endl;
+            return false;
+        }
+    }
+    if (const Core::JsonValue* width = root.find("width")) {
+        if (!readInt(*width, m_defaults.width) || m_defaults.width <= 0) {
+            std::cerr << "Job file: invalid or unknown key \"width\" in job" << std::endl;
+            return false;
+        }
+    }
+    if (const Core::JsonValue* height = root.find("height")) {
+        if (!readInt(*height, m_defaults.height) || m_defaults.height <= 0) {
+            std::cerr << "Job file: invalid or unknown key \"height\" in job" << std::endl;
+            return false;
+        }
+    }
+    if (m_defaults.width <= 0 || m_defaults.height <= 0) {
+        std::cerr << "Job file: image size must be positive" << std::endl;
+        return false;
+    }
+    if (const Core::JsonValue* threads = root.find("threads")) {
+        if (!readInt(*threads, m_defaults.threads) || m_defaults.threads < 0) {
+            std::cerr << "Job file: invalid or unknown key \"threads\" in job" << std::endl;
+            return false;
+        }
+    }
+    if (const Core::JsonValue* output = root.find("output")) {
+        if (!output->isString()) {
+            std::cerr << "Job file: \"output\" must be a string" << std::endl;
+            return false;
+        }
+        m_defaults.outputPath = output->asString();
+    }
+
+    // Top-level scene keys are defaults for every frame
+    if (!applySceneObject(root, { "size", "width", "height", "threads", "output", "frames", "keyframes" },
+                          m_defaults, "job")) {
+        return false;
+    }
+
+    const Core::JsonValue* frames = root.find("frames");
+    const Core::JsonValue* keyframes = root.find("keyframes");
+    if (frames && keyframes) {
+        std::cerr << "Job file: use either \"frames\" or \"keyframes\", not both" << std::endl;
+        return false;
+    }
+
+    if (keyframes) {
+        return buildKeyframes(*keyframes);
+    }
+
+    if (!frames) {
+        // A job without a frame list renders the defaults once
+        m_frames.push_back({ 0, m_defaults });
+        return true;
+    }
+
+    if (!frames->isArray()) {
+        std::cerr << "Job file: \"frames\" must be an array" << std::endl;
+        return false;
+    }
+
+    int count = static_cast<int>(frames->asArray().size());
+    for (int i = 0; i < count; ++i) {
+        const Core::JsonValue& entry = frames->asArray()[i];
+        if (!entry.isObject()) {
+            std::cerr << "Job file: frame " << i << " must be an object" << std::endl;
+            return false;
+        }
+
+        Frame frame{ i, m_defaults };
+        frame.options.outputPath = formatOutputPath(m_defaults.outputPath, i);
+        if (const Core::JsonValue* output = entry.find("output")) {
+            if (!output->isString()) {
+                std::cerr << "Job file: \"output\" of frame " << i << " must be a string" << std::endl;
+                return false;
+            }
+            frame.options.outputPath = output->asString();
+        }
+
+        if (!applySceneObject(entry, { "output" }, frame.options, "frame " + std::to_string(i))) {
+            return false;
+        }
+        m_frames.push_back(frame);
+    }
+
+    return true;
+}
+
+bool BatchRenderer::buildKeyframes(const Core::JsonValue& keyframes) {
+    if (!keyframes.isArray() || keyframes.asArray().empty()) {
+        std::cerr << "Job file: \"keyframes\" must be a non-empty array" << std::endl;
+        return false;
+    }
+
+    // Resolve each keyframe on top of the previous one
+    std::vector<std::pair<int, Core::LaunchOptions>> keys;
+    Core::LaunchOptions current = m_defaults;
+    for (const auto& entry : keyframes.asArray()) {
+        int frameIndex = -1;
+        const Core::JsonValue* frameValue = entry.find("frame");
+        if (!frameValue || !readInt(*frameValue, frameIndex) || frameIndex < 0) {
+            std::cerr << "Job file: every keyframe needs a non-negative \"frame\"" << std::endl;
+            return false;
+        }
+        if (!keys.empty() && frameIndex <= keys.back().first) {
+            std::cerr << "Job file: keyframes must be in increasing frame order" << std::endl;
+            return false;
+        }
+        if (!applySceneObject(entry, { "frame" }, current, "keyframe " + std::to_string(frameIndex))) {
+            return false;
+        }
+        keys.emplace_back(frameIndex, current);
+    }
+
+    int lastFrame = keys.back().first;
+    if (lastFrame - keys.front().first >= MAX_KEYFRAME_SPAN) {
+        std::cerr << "Job file: keyframes may span at most " << MAX_KEYFRAME_SPAN << " frames" << std::endl;
+        return false;
+    }
+    size_t segment = 0;
+    for (int i = keys.front().first; i <= lastFrame; ++i) {
+        while (segment + 1 < keys.size() && keys[segment + 1].first <= i) {
+            ++segment;
+        }
+
+        Frame frame{ i, keys[segment].second };
+        if (segment + 1 < keys.size()) {
+            const auto& from = keys[segment];
+            const auto& to = keys[segment + 1];
+            float t = static_cast<float>(i - from.first) / static_cast<float>(to.first - from.first);
+            frame.options = interpolate(from.second, to.second, t);
+        }
+        frame.options.outputPath = formatOutputPath(m_defaults.outputPath, i);
+        m_frames.push_back(frame);
+    }
+
+    return true;
+}
+
+std::string BatchRenderer::formatOutputPath(const std::string& pattern, int index) const {
+    // Expand a printf-style "%d" / "%04d" frame number
+    size_t percent = pattern.find('%');
+    if (percent != std::string::npos) {
+        size_t pos = percent + 1;
+        bool zeroPad = pos < pattern.size() && pattern[pos] == '0';
+        int width = 0;
+        while (pos < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[pos]))) {
+            width = width * 10 + (pattern[pos] - '0');
+            ++pos;
+        }
+        if (pos < pattern.size() && pattern[pos] == 'd') {
+            std::string number = std::to_string(index);
+            if (static_cast<int>(number.size()) < width) {
+                number.insert(0, width - number.size(), zeroPad ? '0' : ' ');
+            }
+            return pattern.substr(0, percent) + number + pattern.substr(pos + 1);
+        }
+    }
+
+    // No pattern: number frames before the extension
+    std::string number = std::to_string(index);
+    number.insert(0, number.size() < 4 ? 4 - number.size() : 0, '0');
+    std::string base = replaceExtension(pattern, "");
+    std::string extension = pattern.substr(base.size());
+    return base + "_" + number + extension;
+}
+
+int BatchRenderer::run() {
+    namespace fs = std::filesystem;
+
+    // One renderer for the whole job: worker threads, scratch and pixel
+    // buffers stay allocated between frames
+    OfflineRenderer renderer(m_defaults.width, m_defaults.height);
+
+    int rendered = 0;
+    int skipped = 0;
+    int failed = 0;
+    int total = static_cast<int>(m_frames.size());
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < total; ++i) {
+        const Frame& frame = m_frames[i];
+        std::string pfmPath = replaceExtension(frame.options.outputPath, ".pfm");
+        std::string pngPath = replaceExtension(frame.options.outputPath, ".png");
+
+        // Images are renamed into place once complete, so existing files
+        // are never the truncated output of an interrupted run
+        std::error_code ec;
+        if (!m_defaults.overwrite && fs::exists(pfmPath, ec) && fs::exists(pngPath, ec)) {
+            ++skipped;
+            continue;
+        }
+
+        fs::path directory = fs::path(pfmPath).parent_path();
+        if (!directory.empty()) {
+            fs::create_directories(directory, ec);
+        }
+
+        renderer.configure(frame.options);
+        renderer.renderScene(frame.options);
+        if (renderer.save(frame.options.outputPath)) {
+            ++rendered;
+        } else {
+            ++failed;
+        }
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double framesPerHour = rendered > 0 ? rendered * 3600.0 / elapsed : 0.0;
+        int remaining = total - i - 1;
+        double eta = rendered > 0 ? remaining * elapsed / rendered : 0.0;
+
+        std::cout << "[" << (i + 1) << "/" << total << "] " << pfmPath << "  "
+                  << static_cast<int>(renderer.getTracer().getLastFrameTime()) << " ms"
+                  << (renderer.getTracer().getLensingMapResult() == LensingMapResult::Cached ? " re-shaded" : "")
+                  << "  ("
+                  << static_cast<int>(framesPerHour) << " frames/hour, ETA "
+                  << formatDuration(eta) << ")" << std::endl;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "\nBatch finished in " << formatDuration(elapsed) << ": "
+              << rendered << " rendered, " << skipped << " skipped (already on disk), "
+              << failed << " failed" << std::endl;
+    if (rendered > 0) {
+        std::cout << "Throughput: " << static_cast<int>(rendered * 3600.0 / elapsed) << " frames/hour ("
+                  << renderer.getTracer().getThreadCount() << " threads, "
+                  << m_defaults.width << "x" << m_defaults.height << ")" << std::endl;
+    }
+
+    return failed;
+}
+
+int runBatchRender(const Core::LaunchOptions& options) {
+    BatchRenderer batch(options);
+    if (!batch.loadJobFile(options.jobPath)) {
+        return -1;
+    }
+    return batch.run() == 0 ? 0 : -1;
+}
+
+} // namespace Rendering
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../Core/CommandLine.h"
+#include <string>
+#include <vector>
+
+namespace Core {
+    class JsonValue;
+}
+
+namespace Rendering {
+
+// Job-file driven frame sequences for parameter sweeps and camera paths.
+//
+// A job file is a JSON object. Top-level keys set the image size, output
+// pattern and scene defaults; frames are given either explicitly or as
+// keyframes that are interpolated:
+//
+//   {
+//     "size": "1920x1080",
+//     "output": "frames/orbit_%04d.pfm",
+//     "spin": 0.9,
+//     "keyframes": [
+//       { "frame": 0,   "camera": [20, 5, 0] },
+//       { "frame": 120, "camera": [0, 5, 20] }
+//     ]
+//   }
+//
+// Scene keys: mass, spin, camera, target, fov, diskInner, diskOuter,
+// showDisk, showPhotonSphere, exposure, steps, stepSize, integrator,
+// tolerance. Entries of
+// "frames" may also set "output". Frames whose .pfm and .png both exist
+// are skipped so interrupted runs can be resumed.
+class BatchRenderer {
+public:
+    // Options from the command line act as defaults for every frame
+    explicit BatchRenderer(const Core::LaunchOptions& defaults);
+
+    bool loadJobFile(const std::string& path);
+    // Parse a job held in memory; name is used in messages
+    bool loadJobText(const std::string& text, const std::string& name);
+
+    // Render all frames; returns the number of frames that failed
+    int run();
+
+    size_t getFrameCount() const { return m_frames.size(); }
+    int getFrameIndex(size_t i) const { return m_frames[i].index; }
+    const Core::LaunchOptions& getFrameOptions(size_t i) const { return m_frames[i].options; }
+
+private:
+    struct Frame {
+        int index;
+        Core::LaunchOptions options;
+    };
+
+    bool parseJob(const Core::JsonValue& root);
+    bool buildKeyframes(const Core::JsonValue& keyframes);
+    std::string formatOutputPath(const std::string& pattern, int index) const;
+
+    Core::LaunchOptions m_defaults;
+    std::vector<Frame> m_frames;
+};
+
+// Headless entry point used by main() for --batch
+int runBatchRender(const Core::LaunchOptions& options);
+
+} // namespace Rendering
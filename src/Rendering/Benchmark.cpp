@@ -0,0 +1,421 @@
+#include "Benchmark.h"
+#include "Renderer.h"
+#include "SkyMap.h"
+#include "GpuProfiler.h"
+#include "BatchRenderer.h"
+#include "Integrator.h"
+#include "../Core/Window.h"
+#include "../Core/Camera.h"
+#include "../Core/Shader.h"
+#include "../Core/CompileThread.h"
+#include "../Core/Profiler.h"
+#include "../Physics/BlackHole.h"
+#include "../Physics/AccretionDisk.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Rendering {
+
+namespace {
+
+// Fixed animation step so disk rotation is identical on every run
+constexpr double FRAME_TIME = 1.0 / 60.0;
+
+// A frame counts as a stutter when it takes this much longer than the median
+constexpr double STUTTER_FACTOR = 2.0;
+
+// Keyframe jobs in the --batch format. Radii assume the default mass,
+// where Rs is about 4.25 and the photon sphere about 6.4.
+const char* ORBIT_SCENARIO = R"({
+  "keyframes": [
+    { "frame": 0,   "camera": [12, 1.5, 0] },
+    { "frame": 120, "camera": [0, 1.5, 12] },
+    { "frame": 240, "camera": [-12, 1.5, 0] },
+    { "frame": 360, "camera": [0, 1.5, -12] },
+    { "frame": 480, "camera": [12, 1.5, 0] }
+  ]
+})";
+
+const char* ZOOM_SCENARIO = R"({
+  "keyframes": [
+    { "frame": 0,   "camera": [0, 2, 40] },
+    { "frame": 200, "camera": [0, 1, 10] },
+    { "frame": 300, "camera": [0, 0.5, 5] }
+  ]
+})";
+
+// The presets of Interface::renderPresets, held for 30 frames each
+const char* SPIN_SWEEP_SCENARIO = R"({
+  "keyframes": [
+    { "frame": 0,   "mass": 10,    "spin": 0.0 },
+    { "frame": 30,  "mass": 10,    "spin": 0.0 },
+    { "frame": 90,  "mass": 10,    "spin": 0.5 },
+    { "frame": 120, "mass": 10,    "spin": 0.5 },
+    { "frame": 180, "mass": 10,    "spin": 0.95 },
+    { "frame": 210, "mass": 10,    "spin": 0.95 },
+    { "frame": 270, "mass": 6.5e9, "spin": 0.9 },
+    { "frame": 300, "mass": 6.5e9, "spin": 0.9 },
+    { "frame": 360, "mass": 5,     "spin": 0.7 },
+    { "frame": 390, "mass": 5,     "spin": 0.7 }
+  ]
+})";
+
+const char* getScenarioText(const std::string& name) {
+    if (name == "orbit") return ORBIT_SCENARIO;
+    if (name == "zoom") return ZOOM_SCENARIO;
+    if (name == "spin-sweep") return SPIN_SWEEP_SCENARIO;
+    return nullptr;
+}
+
+struct FrameSample {
+    int index;
+    unsigned long long gpuFrame;   // GpuProfiler frame the render ran in
+    double cpuMs;                  // Start of frame to buffer swap
+    double frameMs;                // Swap to swap
+    bool gpuTimed;
+    GpuFrameTimes gpu;
+};
+
+struct Summary {
+    size_t samples = 0;
+    double minMs = 0.0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+// Nearest-rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+Summary summarize(std::vector<double> values) {
+    Summary summary;
+    if (values.empty()) {
+        return summary;
+    }
+    std::sort(values.begin(), values.end());
+    double total = 0.0;
+    for (double value : values) {
+        total += value;
+    }
+    summary.samples = values.size();
+    summary.minMs = values.front();
+    summary.meanMs = total / values.size();
+    summary.p50Ms = percentile(values, 50.0);
+    summary.p95Ms = percentile(values, 95.0);
+    summary.p99Ms = percentile(values, 99.0);
+    summary.maxMs = values.back();
+    return summary;
+}
+
+std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+std::string getGLString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+std::string getCompilerName() {
+#if defined(__clang__)
+    return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+    return "unknown";
+#endif
+}
+
+void writeSummary(std::ostream& out, const char* name, const Summary& summary) {
+    out << "    " << jsonString(name) << ": { \"samples\": " << summary.samples
+        << ", \"min\": " << summary.minMs << ", \"mean\": " << summary.meanMs
+        << ", \"p50\": " << summary.p50Ms << ", \"p95\": " << summary.p95Ms
+        << ", \"p99\": " << summary.p99Ms << ", \"max\": " << summary.maxMs << " }";
+}
+
+double millisecondsBetween(std::chrono::steady_clock::time_point start,
+                           std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Scene objects for one timeline frame, built the way OfflineRenderer does
+struct Scene {
+    explicit Scene(const Core::LaunchOptions& options)
+        : camera(options.cameraPosition, options.cameraTarget, options.fov)
+        , blackHole(options.mass, options.spin)
+        , disk(&blackHole) {
+        if (options.diskInnerRadius > 0.0f) {
+            disk.setInnerRadius(options.diskInnerRadius);
+        }
+        if (options.diskOuterRadius > 0.0f) {
+            disk.setOuterRadius(options.diskOuterRadius);
+        }
+    }
+
+    Core::Camera camera;
+    Physics::BlackHole blackHole;
+    Physics::AccretionDisk disk;
+};
+
+void renderTimelineFrame(Renderer& renderer, const Core::LaunchOptions& options, int index) {
+    PROFILE_ZONE("Benchmark::renderFrame");
+    GeodesicIntegrator integrator;
+    if (parseIntegratorName(options.integrator, integrator)) {
+        renderer.setIntegrator(integrator);
+    }
+    renderer.setInfluenceRadius(options.influenceRadius);
+    renderer.setExposure(options.exposure);
+    renderer.setShowAccretionDisk(options.showAccretionDisk);
+    renderer.setShowPhotonSphere(options.showPhotonSphere);
+    renderer.setAnimationTime(static_cast<float>(index * FRAME_TIME));
+
+    Scene scene(options);
+    renderer.render(scene.camera, scene.blackHole, scene.disk);
+}
+
+} // namespace
+
+int runBenchmark(const Core::LaunchOptions& options) {
+    BatchRenderer timeline(options);
+    const char* builtIn = getScenarioText(options.benchmarkScenario);
+    bool loaded = builtIn ? timeline.loadJobText(builtIn, options.benchmarkScenario)
+                          : timeline.loadJobFile(options.benchmarkScenario);
+    if (!loaded || timeline.getFrameCount() == 0) {
+        std::cerr << "Unknown benchmark scenario: " << options.benchmarkScenario
+                  << " (built in: orbit, zoom, spin-sweep; or a job file)" << std::endl;
+        return -1;
+    }
+
+    Core::Window window(options.width, options.height, "Black Hole Simulation - Benchmark");
+    window.setVSync(false);
+
+    Core::Shader::setBinaryCacheDirectory(options.shaderCacheDir);
+    std::unique_ptr<Core::CompileThread> compileThread;
+    if (!Core::Shader::enableParallelCompile()) {
+        compileThread = std::make_unique<Core::CompileThread>(window.getHandle());
+        Core::Shader::setCompileThread(compileThread.get());
+    }
+
+    Renderer renderer(window.getWidth(), window.getHeight());
+    renderer.initialize(options.quality);
+    renderer.setDynamicResolution(false);
+    renderer.setProgressive(false);
+    if (!options.skyPath.empty()) {
+        renderer.loadSkyMap(options.skyPath, options.skyFaceSize);
+    }
+
+    // Compiles finishing mid-run would show up as stutters
+    auto compileStart = std::chrono::steady_clock::now();
+    while (renderer.getPendingShaderCount() > 0 && !window.shouldClose()) {
+        window.pollEvents();
+        renderTimelineFrame(renderer, timeline.getFrameOptions(0), timeline.getFrameIndex(0));
+        window.swapBuffers();
+    }
+    double compileMs = millisecondsBetween(compileStart, std::chrono::steady_clock::now());
+
+    // So would sky uploads
+    while (renderer.getSkyMap().isLoading() && !window.shouldClose()) {
+        window.pollEvents();
+        renderTimelineFrame(renderer, timeline.getFrameOptions(0), timeline.getFrameIndex(0));
+        window.swapBuffers();
+    }
+
+    // Warm-up plays the start of the timeline so caches and clocks settle
+    size_t frameCount = timeline.getFrameCount();
+    size_t warmupFrames = std::min(static_cast<size_t>(options.benchmarkWarmup), frameCount);
+    for (size_t i = 0; i < warmupFrames && !window.shouldClose(); ++i) {
+        window.pollEvents();
+        renderTimelineFrame(renderer, timeline.getFrameOptions(i), timeline.getFrameIndex(i));
+        window.swapBuffers();
+    }
+    glFinish();
+
+    std::cout << "Benchmark " << options.benchmarkScenario << ": " << frameCount << " frames at "
+              << window.getWidth() << "x" << window.getHeight() << ", " << renderer.getQualityName()
+              << " quality (" << warmupFrames << " warm-up)" << std::endl;
+
+    // GPU results arrive a few frames late; collect them before the
+    // profiler's frame history wraps
+    GpuProfiler& profiler = renderer.getProfiler();
+    std::vector<FrameSample> samples;
+    samples.reserve(frameCount);
+    size_t nextGpuSample = 0;
+    auto collectGpuTimes = [&](bool all) {
+        for (; nextGpuSample < samples.size(); ++nextGpuSample) {
+            FrameSample& sample = samples[nextGpuSample];
+            if (!all && sample.gpuFrame + GpuProfiler::FRAME_HISTORY / 2 > profiler.getFrame()) {
+                break;
+            }
+            sample.gpuTimed = profiler.getFrameTimes(sample.gpuFrame, sample.gpu);
+        }
+    };
+
+    auto previousSwap = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frameCount && !window.shouldClose(); ++i) {
+        auto frameStart = std::chrono::steady_clock::now();
+        window.pollEvents();
+        renderTimelineFrame(renderer, timeline.getFrameOptions(i), timeline.getFrameIndex(i));
+        auto submitted = std::chrono::steady_clock::now();
+        window.swapBuffers();
+        auto swapped = std::chrono::steady_clock::now();
+
+        FrameSample sample = {};
+        sample.index = timeline.getFrameIndex(i);
+        sample.gpuFrame = profiler.getFrame();
+        sample.cpuMs = millisecondsBetween(frameStart, submitted);
+        sample.frameMs = millisecondsBetween(previousSwap, swapped);
+        samples.push_back(sample);
+        previousSwap = swapped;
+
+        collectGpuTimes(false);
+    }
+
+    // Read back the queries of the last frames
+    glFinish();
+    profiler.beginFrame();
+    collectGpuTimes(true);
+
+    if (samples.size() < frameCount) {
+        std::cerr << "Benchmark interrupted after " << samples.size() << " frames" << std::endl;
+        return -1;
+    }
+
+    std::vector<double> cpuTimes;
+    std::vector<double> frameTimes;
+    std::vector<double> gpuTimes;
+    std::vector<double> passTimes[static_cast<int>(GpuPass::Count)];
+    for (const FrameSample& sample : samples) {
+        cpuTimes.push_back(sample.cpuMs);
+        frameTimes.push_back(sample.frameMs);
+        if (sample.gpuTimed) {
+            gpuTimes.push_back(sample.gpu.totalMs);
+            for (int pass = 0; pass < static_cast<int>(GpuPass::Count); ++pass) {
+                passTimes[pass].push_back(sample.gpu.passMs[pass]);
+            }
+        }
+    }
+    Summary frameSummary = summarize(frameTimes);
+    Summary cpuSummary = summarize(cpuTimes);
+    Summary gpuSummary = summarize(gpuTimes);
+
+    double stutterThreshold = frameSummary.p50Ms * STUTTER_FACTOR;
+    std::vector<int> stutters;
+    for (const FrameSample& sample : samples) {
+        if (sample.frameMs > stutterThreshold) {
+            stutters.push_back(sample.index);
+        }
+    }
+
+    std::ofstream out(options.benchmarkOutput);
+    if (!out) {
+        std::cerr << "Failed to open benchmark output for writing: " << options.benchmarkOutput << std::endl;
+        return -1;
+    }
+
+    out << "{\n";
+    out << "  \"scenario\": " << jsonString(options.benchmarkScenario) << ",\n";
+    out << "  \"fingerprint\": {\n";
+#ifdef BH_GIT_COMMIT
+    out << "    \"commit\": " << jsonString(BH_GIT_COMMIT) << ",\n";
+#endif
+    out << "    \"built\": " << jsonString(__DATE__ " " __TIME__) << ",\n";
+    out << "    \"compiler\": " << jsonString(getCompilerName()) << ",\n";
+#ifdef NDEBUG
+    out << "    \"config\": \"release\",\n";
+#else
+    out << "    \"config\": \"debug\",\n";
+#endif
+#ifdef BH_PROFILER
+    out << "    \"profiler\": true,\n";
+#else
+    out << "    \"profiler\": false,\n";
+#endif
+    out << "    \"glVendor\": " << jsonString(getGLString(GL_VENDOR)) << ",\n";
+    out << "    \"glRenderer\": " << jsonString(getGLString(GL_RENDERER)) << ",\n";
+    out << "    \"glVersion\": " << jsonString(getGLString(GL_VERSION)) << ",\n";
+    out << "    \"glslVersion\": " << jsonString(getGLString(GL_SHADING_LANGUAGE_VERSION)) << "\n";
+    out << "  },\n";
+    out << "  \"settings\": { \"width\": " << window.getWidth() << ", \"height\": " << window.getHeight()
+        << ", \"quality\": " << jsonString(renderer.getQualityName())
+        << ", \"frames\": " << samples.size() << ", \"warmupFrames\": " << warmupFrames
+        << ", \"shaderCompileMs\": " << compileMs << " },\n";
+    out << "  \"summary\": {\n";
+    writeSummary(out, "frame", frameSummary);
+    out << ",\n";
+    writeSummary(out, "cpu", cpuSummary);
+    out << ",\n";
+    writeSummary(out, "gpu", gpuSummary);
+    for (int pass = 0; pass < static_cast<int>(GpuPass::Count); ++pass) {
+        out << ",\n";
+        writeSummary(out, GpuProfiler::getPassName(static_cast<GpuPass>(pass)), summarize(passTimes[pass]));
+    }
+    out << "\n  },\n";
+    out << "  \"stutters\": { \"factor\": " << STUTTER_FACTOR << ", \"thresholdMs\": " << stutterThreshold
+        << ", \"count\": " << stutters.size() << ", \"frames\": [";
+    for (size_t i = 0; i < stutters.size(); ++i) {
+        out << (i ? ", " : "") << stutters[i];
+    }
+    out << "] },\n";
+
+    // Per-frame rows; gpu is null for frames whose queries were skipped
+    out << "  \"frames\": [";
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const FrameSample& sample = samples[i];
+        out << (i ? "," : "") << "\n    { \"frame\": " << sample.index << ", \"frameMs\": " << sample.frameMs
+            << ", \"cpuMs\": " << sample.cpuMs << ", \"gpuMs\": ";
+        if (sample.gpuTimed) {
+            out << sample.gpu.totalMs;
+        } else {
+            out << "null";
+        }
+        out << " }";
+    }
+    out << "\n  ]\n}\n";
+
+    if (!out) {
+        std::cerr << "Failed to write benchmark output: " << options.benchmarkOutput << std::endl;
+        return -1;
+    }
+
+    std::cout << "  Frame: p50 " << frameSummary.p50Ms << " ms, p95 " << frameSummary.p95Ms
+              << " ms, p99 " << frameSummary.p99Ms << " ms" << std::endl;
+    std::cout << "  CPU:   p50 " << cpuSummary.p50Ms << " ms, p95 " << cpuSummary.p95Ms
+              << " ms, p99 " << cpuSummary.p99Ms << " ms" << std::endl;
+    std::cout << "  GPU:   p50 " << gpuSummary.p50Ms << " ms, p95 " << gpuSummary.p95Ms
+              << " ms, p99 " << gpuSummary.p99Ms << " ms (" << gpuSummary.samples << " of "
+              << samples.size() << " frames timed)" << std::endl;
+    std::cout << "  Stutters: " << stutters.size() << " frames over " << stutterThreshold << " ms" << std::endl;
+    std::cout << "  Output: " << options.benchmarkOutput << std::endl;
+    return 0;
+}
+
+} // namespace Rendering
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "../Core/CommandLine.h"
+#include <string>
+
+namespace Rendering {
+
+// Deterministic playback of a camera and parameter timeline in the GPU
+// viewer for repeatable performance numbers (--benchmark).
+//
+// Built-in scenarios:
+//   orbit       close orbit at 12 units, just outside the photon sphere
+//   zoom        fly in from 40 units through the photon sphere to 5
+//   spin-sweep  mass and spin of each UI preset in turn
+// Any other name is read as a job file in the --batch format, so recorded
+// or hand-written camera paths can be replayed the same way.
+//
+// VSync, dynamic resolution and progressive refinement are off, animation
+// time advances a fixed 1/60 s per frame and the UI is not drawn. After
+// shaders are ready and warm-up frames have run, the timeline is played
+// once and per-frame CPU, GPU and frame times are written as JSON with
+// percentiles, stutter counts and a build/driver fingerprint.
+
+// Entry point used by main() for --benchmark; returns 0 on success
+int runBenchmark(const Core::LaunchOptions& options);
+
+} // namespace Rendering
@@ -0,0 +1,1473 @@
+#include "CpuRayTracer.h"
+#include "LensingMapCache.h"
+#include "../Core/Profiler.h"
+#include "../Core/Camera.h"
+#include "../Physics/BlackHole.h"
+#include "../Physics/AccretionDisk.h"
+#include "../Physics/Constants.h"
+#include "../Physics/EmissionTables.h"
+#include "../Physics/KerrGeodesic.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Rendering {
+
+namespace {
+
+// Dormand-Prince 5(4) tableau (same constants as raytracer.comp)
+constexpr float DP_A21 = 1.0f / 5.0f;
+constexpr float DP_A31 = 3.0f / 40.0f, DP_A32 = 9.0f / 40.0f;
+constexpr float DP_A41 = 44.0f / 45.0f, DP_A42 = -56.0f / 15.0f, DP_A43 = 32.0f / 9.0f;
+constexpr float DP_A51 = 19372.0f / 6561.0f, DP_A52 = -25360.0f / 2187.0f,
+                DP_A53 = 64448.0f / 6561.0f, DP_A54 = -212.0f / 729.0f;
+constexpr float DP_A61 = 9017.0f / 3168.0f, DP_A62 = -355.0f / 33.0f, DP_A63 = 46732.0f / 5247.0f,
+                DP_A64 = 49.0f / 176.0f, DP_A65 = -5103.0f / 18656.0f;
+// Fifth-order weights (also the last stage, so k7 = f(y1) is reused as k1)
+constexpr float DP_B1 = 35.0f / 384.0f, DP_B3 = 500.0f / 1113.0f, DP_B4 = 125.0f / 192.0f,
+                DP_B5 = -2187.0f / 6784.0f, DP_B6 = 11.0f / 84.0f;
+// Difference between the fifth- and embedded fourth-order solutions
+constexpr float DP_E1 = 71.0f / 57600.0f, DP_E3 = -71.0f / 16695.0f, DP_E4 = 71.0f / 1920.0f,
+                DP_E5 = -17253.0f / 339200.0f, DP_E6 = 22.0f / 525.0f, DP_E7 = -1.0f / 40.0f;
+
+// Step size controller limits
+constexpr float RK_MIN_STEP = 1e-3f;
+constexpr float RK_MAX_STEP_FRACTION = 0.5f;  // Step never exceeds this fraction of r
+constexpr float RK_SAFETY = 0.9f;
+constexpr float RK_MIN_SCALE = 0.2f;
+constexpr float RK_MAX_SCALE = 5.0f;
+
+// Orbiting disk hotspots (same constants as shade.comp): radius as a
+// fraction of the disk width, starting phase, and a shared angular size
+constexpr int HOTSPOT_COUNT = 4;
+constexpr float HOTSPOT_RADIUS[HOTSPOT_COUNT] = { 0.1f, 0.25f, 0.45f, 0.7f };
+constexpr float HOTSPOT_PHASE[HOTSPOT_COUNT] = { 0.0f, 2.1f, 4.0f, 5.3f };
+constexpr float HOTSPOT_SIZE = 0.25f;
+constexpr float HOTSPOT_BRIGHTNESS = 1.5f;
+constexpr float DISK_TIME_SCALE = 20.0f;  // Orbital time units per second at speed 1
+
+// Relative widening of the Mino-time window in which a culled ray could
+// still cross the disk (same constant as raytracer.comp)
+constexpr double SHADOW_DISK_MARGIN = 0.05;
+
+// Cubic Hermite interpolation of the ray between two accepted steps
+glm::vec3 hermitePosition(const glm::vec3& p0, const glm::vec3& d0,
+                          const glm::vec3& p1, const glm::vec3& d1, float h, float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return (2.0f * t3 - 3.0f * t2 + 1.0f) * p0 + (t3 - 2.0f * t2 + t) * h * d0 +
+           (-2.0f * t3 + 3.0f * t2) * p1 + (t3 - t2) * h * d1;
+}
+
+double hermiteScalar(double p0, double d0, double p1, double d1, double h, double t) {
+    double t2 = t * t;
+    double t3 = t2 * t;
+    return (2.0 * t3 - 3.0 * t2 + 1.0) * p0 + (t3 - 2.0 * t2 + t) * h * d0 +
+           (-2.0 * t3 + 3.0 * t2) * p1 + (t3 - t2) * h * d1;
+}
+
+glm::vec3 hermiteTangent(const glm::vec3& p0, const glm::vec3& d0,
+                         const glm::vec3& p1, const glm::vec3& d1, float h, float t) {
+    float t2 = t * t;
+    return (6.0f * t2 - 6.0f * t) * p0 + (3.0f * t2 - 4.0f * t + 1.0f) * h * d0 +
+           (-6.0f * t2 + 6.0f * t) * p1 + (3.0f * t2 - 2.0f * t) * h * d1;
+}
+
+// Bound on the bending still ahead of an outbound ray at r beyond the sphere
+// of influence, in units of Rs / r (same constant in raytracer.comp). The
+// Kerr orbits bend about twice as much as the model law; 1.5 covers them
+// from 6 Rs out.
+constexpr float FAR_FIELD_BEND = 1.5f;
+
+// Distance along the line to where it enters the sphere of the given radius
+// around the hole (rel = start - hole), or -1 if it never does
+float sphereEntryDistance(const glm::vec3& rel, const glm::vec3& dir, float radius) {
+    float along = glm::dot(rel, dir);
+    float closest2 = std::max(glm::dot(rel, rel) - along * along, 0.0f);
+    if (along >= 0.0f || closest2 >= radius * radius) {
+        return -1.0f;
+    }
+    return -along - std::sqrt(radius * radius - closest2);
+}
+
+} // namespace
+
+CpuRayTracer::CpuRayTracer(int width, int height)
+    : m_width(width)
+    , m_height(height)
+    , m_threadCount(0)
+    , m_scheduling(CpuScheduling::WorkStealing)
+    , m_scheduler(0)
+    , m_usePackets(true)
+    , m_simdLevel(detectSimdLevel())
+    , m_maxSteps(500)
+    , m_stepSize(0.1f)
+    , m_integrator(GeodesicIntegrator::Kerr)
+    , m_tolerance(getToleranceForQuality(2))
+    , m_influenceRadius(DEFAULT_INFLUENCE_RADIUS)
+    , m_stepStats{ 0.0, 0, 0 }
+    , m_useSchwarzschildFastPath(true)
+    , m_useShadowCulling(true)
+    , m_lensingMapCache(nullptr)
+    , m_lensingMapPreview(false)
+    , m_lensingMapResult(LensingMapResult::Disabled)
+    , m_recordSamples(nullptr)
+    , m_showPhotonSphere(false)
+    , m_showAccretionDisk(true)
+    , m_time(0.0f)
+    , m_jitter(0.0f)
+    , m_scene()
+    , m_forward(0.0f)
+    , m_right(0.0f)
+    , m_up(0.0f)
+    , m_tanHalfFov(1.0f)
+    , m_cameraAzimuth(0.0f)
+    , m_azimuthRotation(1.0f, 0.0f)
+    , m_lastFrameTime(0.0) {
+
+    m_pixels.resize(static_cast<size_t>(width) * height * 4, 0.0f);
+}
+
+void CpuRayTracer::resize(int width, int height) {
+    m_width = width;
+    m_height = height;
+    m_pixels.assign(static_cast<size_t>(width) * height * 4, 0.0f);
+}
+
+void CpuRayTracer::setThreadCount(int count) {
+    m_threadCount = count;
+    m_scheduler.setThreadCount(count);
+}
+
+int CpuRayTracer::getThreadCount() const {
+    return m_threadCount > 0 ? m_threadCount : getMaxThreads();
+}
+
+int CpuRayTracer::getMaxThreads() {
+    return TileScheduler::getHardwareThreads();
+}
+
+void CpuRayTracer::render(const Core::Camera& camera,
+                          const Physics::BlackHole& blackHole,
+                          const Physics::AccretionDisk& disk) {
+    PROFILE_ZONE("CpuRayTracer::render");
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Capture scene state
+    m_scene.cameraPos = camera.getPosition();
+    m_scene.cameraTarget = camera.getTarget();
+    m_scene.cameraUp = camera.getUp();
+    m_scene.fov = camera.getFOV();
+    m_scene.aspectRatio = static_cast<float>(m_width) / m_height;
+    m_scene.blackHoleSpin = blackHole.getSpin();
+    m_scene.blackHolePos = blackHole.getPosition();
+    m_scene.schwarzschildRadius = blackHole.getSchwarzschildRadius();
+    m_scene.diskInnerRadius = disk.getInnerRadius();
+    m_scene.diskOuterRadius = disk.getOuterRadius();
+    m_scene.diskRotationSpeed = disk.getRotationSpeed();
+    m_scene.time = m_time;
+
+    // Camera setup
+    m_forward = glm::normalize(m_scene.cameraTarget - m_scene.cameraPos);
+    m_right = glm::normalize(glm::cross(m_forward, m_scene.cameraUp));
+    m_up = glm::cross(m_right, m_forward);
+    m_tanHalfFov = std::tan(glm::radians(m_scene.fov) * 0.5f);
+
+    // Azimuth of the camera about the spin axis, factored out of lensing maps
+    glm::vec3 cameraOffset = m_scene.cameraPos - m_scene.blackHolePos;
+    m_cameraAzimuth = std::atan2(cameraOffset.z, cameraOffset.x);
+    m_azimuthRotation = glm::vec2(std::cos(m_cameraAzimuth), std::sin(m_cameraAzimuth));
+
+    // Shadow of the hole for this camera, for culling captured pixels
+    m_shadowProfile.clear();
+    if (isShadowCullingActive()) {
+        m_shadowProfile.build(blackHole.getShadowContour(m_scene.cameraPos), m_forward, m_right, m_up,
+                              2.0f * m_tanHalfFov / m_height);
+    }
+
+    // Lensing maps are keyed on the unjittered pixel grid
+    std::shared_ptr<LensingMap> recordMap;
+    bool useLensingMap = m_lensingMapCache && m_jitter == glm::vec2(0.0f);
+    if (useLensingMap && reshadeFromLensingMap(recordMap)) {
+        m_stepStats = StepStats{ 0.0, 0, 0 };
+    } else {
+        m_lensingMapResult = m_lensingMapCache ? LensingMapResult::Traced : LensingMapResult::Disabled;
+        m_recordSamples = recordMap ? recordMap->getMutableSamples() : nullptr;
+        traceFrame();
+        m_recordSamples = nullptr;
+        if (recordMap) {
+            m_lensingMapCache->insert(recordMap);
+        }
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    m_lastFrameTime = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+void CpuRayTracer::traceFrame() {
+    // Orbits only depend on the camera radius, so the table survives
+    // camera rotation and all disk/display changes
+    if (isSchwarzschildFastPathActive()) {
+        m_lensing.build(m_scene.schwarzschildRadius * 0.5f,
+                        glm::length(m_scene.cameraPos - m_scene.blackHolePos));
+    }
+
+    const PacketParams packetParams = makePacketParams();
+
+    int threadCount = getThreadCount();
+    if (static_cast<int>(m_scratch.size()) < threadCount) {
+        m_scratch.resize(threadCount);
+    }
+    for (auto& scratch : m_scratch) {
+        scratch.stepSum = 0;
+        scratch.stepMax = 0;
+    }
+
+    if (m_scheduling == CpuScheduling::WorkStealing) {
+        m_scheduler.run(m_width, m_height, [&](const TileScheduler::Tile& tile, int threadIndex) {
+            for (int y = tile.y; y < tile.y + tile.height; ++y) {
+                traceSpan(tile.x, y, tile.width, packetParams, m_scratch[threadIndex]);
+            }
+        });
+    } else {
+        const int height = m_height;
+
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(threadCount)
+#endif
+        for (int y = 0; y < height; ++y) {
+#ifdef _OPENMP
+            RowScratch& scratch = m_scratch[omp_get_thread_num()];
+#else
+            RowScratch& scratch = m_scratch[0];
+#endif
+            traceSpan(0, y, m_width, packetParams, scratch);
+        }
+    }
+
+    m_stepStats = StepStats{ 0.0, 0, 0 };
+    for (const auto& scratch : m_scratch) {
+        m_stepStats.totalSteps += scratch.stepSum;
+        m_stepStats.maxSteps = std::max(m_stepStats.maxSteps, scratch.stepMax);
+    }
+    m_stepStats.averageSteps = static_cast<double>(m_stepStats.totalSteps) /
+                               (static_cast<double>(m_width) * m_height);
+}
+
+void CpuRayTracer::traceSpan(int x0, int y, int count, const PacketParams& packetParams,
+                             RowScratch& scratch) {
+    if (static_cast<int>(scratch.hits.size()) < count) {
+        scratch.dirX.resize(count);
+        scratch.dirY.resize(count);
+        scratch.dirZ.resize(count);
+        scratch.hits.resize(count);
+        scratch.originX.resize(count);
+        scratch.originY.resize(count);
+        scratch.originZ.resize(count);
+        scratch.marchPixel.resize(count);
+        scratch.marchHits.resize(count);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        // Same mapping as raytracer.comp: uv in [-1, 1]
+        glm::vec2 uv = (glm::vec2(static_cast<float>(x0 + i), static_cast<float>(y)) + m_jitter) /
+                       glm::vec2(static_cast<float>(m_width), static_cast<float>(m_height));
+        uv = uv * 2.0f - 1.0f;
+        uv.x *= m_scene.aspectRatio;
+
+        glm::vec3 rayDir = glm::normalize(
+            m_forward +
+            m_right * uv.x * m_tanHalfFov +
+            m_up * uv.y * m_tanHalfFov
+        );
+
+        scratch.dirX[i] = rayDir.x;
+        scratch.dirY[i] = rayDir.y;
+        scratch.dirZ[i] = rayDir.z;
+    }
+
+    float* out = m_pixels.data() + (static_cast<size_t>(y) * m_width + x0) * 4;
+
+    if (m_recordSamples) {
+        // Trace every ray to its end, keeping the disk-independent parts
+        LensingSample* samples = m_recordSamples + static_cast<size_t>(y) * m_width + x0;
+        for (int i = 0; i < count; ++i) {
+            LensingSample& sample = samples[i];
+            sample.crossingCount = 0;
+            sample.photonSphereCrossings = -1;
+
+            RayHit hit = marchRay(m_scene.cameraPos,
+                                  glm::vec3(scratch.dirX[i], scratch.dirY[i], scratch.dirZ[i]), &sample);
+            glm::vec3 direction = toCanonical(hit.direction);
+            sample.direction[0] = direction.x;
+            sample.direction[1] = direction.y;
+            sample.direction[2] = direction.z;
+            sample.type = static_cast<int32_t>(hit.type);
+
+            glm::vec4 color = shadeSample(sample);
+            scratch.stepSum += hit.steps;
+            scratch.stepMax = std::max(scratch.stepMax, hit.steps);
+            out[i * 4 + 0] = color.r;
+            out[i * 4 + 1] = color.g;
+            out[i * 4 + 2] = color.b;
+            out[i * 4 + 3] = color.a;
+        }
+        return;
+    }
+
+    if (m_usePackets && m_integrator == GeodesicIntegrator::FixedStep) {
+        // Cross the far field per ray, then march only the rays left in packets
+        int marchCount = 0;
+        for (int i = 0; i < count; ++i) {
+            glm::vec3 pos = m_scene.cameraPos;
+            glm::vec3 dir(scratch.dirX[i], scratch.dirY[i], scratch.dirZ[i]);
+            if (enterFarField(pos, dir, false, Physics::FarFieldLaw::Model) == FarFieldEntry::Escaped) {
+                RayHit& hit = scratch.hits[i];
+                hit.type = RayHitType::Escaped;
+                hit.position = pos;
+                hit.direction = dir;
+                hit.steps = 0;
+                continue;
+            }
+            scratch.originX[marchCount] = pos.x;
+            scratch.originY[marchCount] = pos.y;
+            scratch.originZ[marchCount] = pos.z;
+            scratch.dirX[marchCount] = dir.x;
+            scratch.dirY[marchCount] = dir.y;
+            scratch.dirZ[marchCount] = dir.z;
+            scratch.marchPixel[marchCount] = i;
+            ++marchCount;
+        }
+
+        tracePackets(m_simdLevel, packetParams, scratch.originX.data(), scratch.originY.data(),
+                     scratch.originZ.data(), scratch.dirX.data(), scratch.dirY.data(),
+                     scratch.dirZ.data(), marchCount, scratch.marchHits.data());
+
+        for (int i = 0; i < marchCount; ++i) {
+            RayHit hit = scratch.marchHits[i];
+            if (hit.type == RayHitType::Escaped) {
+                hit.direction = getFarFieldDirection(hit.position, hit.direction, Physics::FarFieldLaw::Model);
+            }
+            scratch.hits[scratch.marchPixel[i]] = hit;
+        }
+    } else {
+        for (int i = 0; i < count; ++i) {
+            glm::vec3 dir(scratch.dirX[i], scratch.dirY[i], scratch.dirZ[i]);
+            if (m_shadowProfile.isValid() && isCulledByShadow(dir)) {
+                RayHit& hit = scratch.hits[i];
+                hit.type = RayHitType::Absorbed;
+                hit.position = m_scene.cameraPos;
+                hit.direction = dir;
+                hit.steps = 0;
+                continue;
+            }
+            scratch.hits[i] = marchRay(m_scene.cameraPos, dir);
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        glm::vec4 color = shadeHit(scratch.hits[i]);
+        scratch.stepSum += scratch.hits[i].steps;
+        scratch.stepMax = std::max(scratch.stepMax, scratch.hits[i].steps);
+        out[i * 4 + 0] = color.r;
+        out[i * 4 + 1] = color.g;
+        out[i * 4 + 2] = color.b;
+        out[i * 4 + 3] = color.a;
+    }
+}
+
+glm::vec3 CpuRayTracer::integrateGeodesic(const glm::vec3& pos, const glm::vec3& dir,
+                                          float step, bool& absorbed) const {
+    absorbed = false;
+
+    glm::vec3 relPos = pos - m_scene.blackHolePos;
+    float r = glm::length(relPos);
+
+    float Rs = m_scene.schwarzschildRadius;
+    float M = Rs * 0.5f;  // Mass in geometric units
+    float a = m_scene.blackHoleSpin * M;  // Spin parameter
+
+    // Kerr event horizon: r+ = M + sqrt(M^2 - a^2)
+    float eventHorizon = M + std::sqrt(std::max(M * M - a * a, 0.01f));
+
+    // Check if inside event horizon
+    if (r < eventHorizon * 1.1f) {
+        absorbed = true;
+        return dir;
+    }
+
+    return glm::normalize(dir + gravitationalAcceleration(pos) * step);
+}
+
+glm::vec3 CpuRayTracer::gravitationalAcceleration(const glm::vec3& pos) const {
+    glm::vec3 relPos = pos - m_scene.blackHolePos;
+    float r = glm::length(relPos);
+
+    float Rs = m_scene.schwarzschildRadius;
+    float M = Rs * 0.5f;
+    float a = m_scene.blackHoleSpin * M;
+
+    glm::vec3 toCenter = glm::normalize(relPos);
+
+    // Gravitational acceleration with GR correction term
+    float factor = 1.0f / (r * r);
+    float grCorrection = 1.0f + 1.5f * Rs / r;
+
+    glm::vec3 acceleration = -toCenter * (Rs * 0.5f) * factor * grCorrection;
+
+    // Kerr frame dragging (Lense-Thirring effect)
+    if (std::abs(m_scene.blackHoleSpin) > 0.01f) {
+        float r2 = r * r;
+        float a2 = a * a;
+        float omega = (2.0f * M * a * r) / (r2 * r + a2 * r + 2.0f * M * a2);
+
+        float dragStrength = omega * Rs / r;
+
+        // Spin axis aligned with y-axis
+        glm::vec3 spinAxis(0.0f, m_scene.blackHoleSpin > 0.0f ? 1.0f : -1.0f, 0.0f);
+        glm::vec3 tangent = glm::cross(spinAxis, toCenter);
+
+        acceleration += tangent * dragStrength * std::abs(m_scene.blackHoleSpin);
+    }
+
+    return acceleration;
+}
+
+void CpuRayTracer::geodesicDerivative(const glm::vec3& pos, const glm::vec3& vel,
+                                      glm::vec3& dPos, glm::vec3& dVel) const {
+    // Continuous form of the fixed-step update: the ray moves along its
+    // direction and only the acceleration perpendicular to it bends the ray
+    glm::vec3 dir = glm::normalize(vel);
+    glm::vec3 acceleration = gravitationalAcceleration(pos);
+
+    dPos = dir;
+    dVel = acceleration - glm::dot(acceleration, dir) * dir;
+}
+
+bool CpuRayTracer::intersectDisk(const glm::vec3& origin, const glm::vec3& dir,
+                                 float& t, float& radius, glm::vec2& diskCoord) const {
+    // Disk in XZ plane (y = 0)
+    if (std::abs(dir.y) < 1e-6f) return false;
+
+    t = -origin.y / dir.y;
+    if (t < 0.0f) return false;
+
+    glm::vec3 hitPoint = origin + t * dir;
+    radius = glm::length(glm::vec2(hitPoint.x, hitPoint.z));
+
+    if (radius < m_scene.diskInnerRadius || radius > m_scene.diskOuterRadius) {
+        return false;
+    }
+
+    float phi = std::atan2(hitPoint.z, hitPoint.x);
+    diskCoord = glm::vec2(radius, phi);
+
+    return true;
+}
+
+float CpuRayTracer::getFarFieldRadius(Physics::FarFieldLaw law) const {
+    if (m_influenceRadius <= 0.0f) {
+        return std::numeric_limits<float>::max();
+    }
+    float radius = std::max(m_influenceRadius, MIN_INFLUENCE_RADIUS) * m_scene.schwarzschildRadius;
+    if (law == Physics::FarFieldLaw::Schwarzschild) {
+        radius *= 1.0f + std::abs(m_scene.blackHoleSpin);
+    }
+    return radius;
+}
+
+bool CpuRayTracer::isFarFieldClear(const glm::vec3& pos, const glm::vec3& dir, float r, bool recording) const {
+    if (!m_showAccretionDisk && !recording) {
+        return true;
+    }
+    // Past the disk edge (lensing maps keep every crossing of the plane,
+    // whatever the disk radii), or leaving the plane faster than the
+    // remaining bending could turn the ray back. Same expression as the
+    // packet kernel.
+    if (!recording && r >= m_scene.diskOuterRadius) {
+        return true;
+    }
+    return pos.y * dir.y * r > std::abs(pos.y) * (FAR_FIELD_BEND * m_scene.schwarzschildRadius);
+}
+
+bool CpuRayTracer::isFarFieldPathClear(const glm::vec3& pos, const glm::vec3& dir, float length,
+                                       float nearest, bool recording) const {
+    if (!m_showAccretionDisk && !recording) {
+        return true;
+    }
+    if (!recording && nearest >= m_scene.diskOuterRadius) {
+        return true;
+    }
+
+    float bend = FAR_FIELD_BEND * m_scene.schwarzschildRadius / nearest;
+    if (length < 0.0f) {
+        // Passes the hole and leaves, bent on the way in and out
+        return pos.y * dir.y > std::abs(pos.y) * 2.0f * bend;
+    }
+    // Both ends on the same side of the plane, with room for the bending
+    float endY = pos.y + length * dir.y;
+    return pos.y * endY > 0.0f && std::abs(endY) > bend * length;
+}
+
+bool CpuRayTracer::isLeavingFarField(const glm::vec3& pos, const glm::vec3& dir, float r,
+                                     bool recording) const {
+    return r >= getFarFieldRadius(Physics::FarFieldLaw::Model) &&
+           glm::dot(pos - m_scene.blackHolePos, dir) > 0.0f && isFarFieldClear(pos, dir, r, recording);
+}
+
+CpuRayTracer::FarFieldEntry CpuRayTracer::planFarFieldEntry(const glm::vec3& pos, const glm::vec3& dir,
+                                                            bool recording, Physics::FarFieldLaw law,
+                                                            float& radius) const {
+    glm::vec3 rel = pos - m_scene.blackHolePos;
+    float r = glm::length(rel);
+    radius = getFarFieldRadius(law);
+    if (r <= radius) {
+        return FarFieldEntry::Inside;
+    }
+
+    float along = glm::dot(rel, dir);
+    float closest = std::sqrt(std::max(r * r - along * along, 0.0f));
+    float t = sphereEntryDistance(rel, dir, radius);
+    if (t < 0.0f) {
+        bool clear = along < 0.0f ? isFarFieldPathClear(pos, dir, -1.0f, closest, recording)
+                                  : isFarFieldClear(pos, dir, r, recording);
+        if (clear) {
+            return FarFieldEntry::Escaped;
+        }
+    } else if (isFarFieldPathClear(pos, dir, t, radius, recording)) {
+        return FarFieldEntry::Entered;
+    }
+
+    // The path may meet the disk: start marching where it enters the
+    // sphere around the disk instead
+    radius = m_scene.diskOuterRadius + FAR_FIELD_BEND * m_scene.schwarzschildRadius;
+    if (recording || r <= radius || sphereEntryDistance(rel, dir, radius) < 0.0f) {
+        return FarFieldEntry::Inside;
+    }
+    return FarFieldEntry::Entered;
+}
+
+CpuRayTracer::FarFieldEntry CpuRayTracer::enterFarField(glm::vec3& pos, glm::vec3& dir, bool recording,
+                                                        Physics::FarFieldLaw law) const {
+    float radius;
+    if (planFarFieldEntry(pos, dir, recording, law, radius) == FarFieldEntry::Inside) {
+        return FarFieldEntry::Inside;
+    }
+
+    // In-plane basis: e1 points from the hole to the camera, e2 along the ray
+    const double M = m_scene.schwarzschildRadius * 0.5;
+    glm::dvec3 rel = glm::dvec3(pos - m_scene.blackHolePos);
+    double r = glm::length(rel);
+    glm::dvec3 e1 = rel / r;
+    glm::dvec3 direction = glm::normalize(glm::dvec3(dir));
+    double cosAlpha = glm::dot(direction, e1);
+    glm::dvec3 perp = direction - cosAlpha * e1;
+    double sinAlpha = glm::length(perp);
+
+    if (sinAlpha < 1e-6) {
+        // Radial: straight out, or straight in to the sphere
+        if (cosAlpha >= 0.0) {
+            return FarFieldEntry::Escaped;
+        }
+        pos = m_scene.blackHolePos + glm::vec3(static_cast<double>(radius) * e1);
+        return FarFieldEntry::Entered;
+    }
+    glm::dvec3 e2 = perp / sinAlpha;
+
+    double u = 1.0 / r;
+    double invL2 = Physics::orbitPotential(law, M, u) / (sinAlpha * sinAlpha);
+    double sweep = Physics::orbitSweep(law, M, u, invL2 * cosAlpha * cosAlpha);
+
+    double entryU = 1.0 / radius;
+    double entrySlope2 = invL2 - Physics::orbitPotential(law, M, entryU);
+    double phi;
+    if (cosAlpha >= 0.0) {
+        phi = sweep;
+    } else if (entrySlope2 <= 0.0) {
+        // Passes outside the sphere: in to periapsis, then out to infinity
+        double periapsis = Physics::orbitTurningPoint(law, M, invL2);
+        phi = 2.0 * Physics::orbitSweep(law, M, periapsis, 0.0) - sweep;
+    } else {
+        // Enters the sphere: continue from there in the same frame as the camera ray
+        phi = Physics::orbitSweep(law, M, entryU, entrySlope2) - sweep;
+        glm::dvec3 radial = std::cos(phi) * e1 + std::sin(phi) * e2;
+        glm::dvec3 tangent = -std::sin(phi) * e1 + std::cos(phi) * e2;
+        double sinEntry = std::min(std::sqrt(Physics::orbitPotential(law, M, entryU) / invL2), 1.0);
+        double cosEntry = -std::sqrt(1.0 - sinEntry * sinEntry);
+        glm::dvec3 entryDir = cosEntry * radial + sinEntry * tangent +
+                              Physics::spinDeflection(law, M, m_scene.blackHoleSpin, rel, direction, radius);
+
+        pos = m_scene.blackHolePos + glm::vec3(static_cast<double>(radius) * radial);
+        dir = glm::vec3(glm::normalize(entryDir));
+        return FarFieldEntry::Entered;
+    }
+
+    glm::dvec3 escapeDir = std::cos(phi) * e1 + std::sin(phi) * e2 +
+                           Physics::spinDeflection(law, M, m_scene.blackHoleSpin, rel, direction, 0.0);
+    dir = glm::vec3(glm::normalize(escapeDir));
+    return FarFieldEntry::Escaped;
+}
+
+glm::vec3 CpuRayTracer::getFarFieldDirection(const glm::vec3& pos, const glm::vec3& dir,
+                                             Physics::FarFieldLaw law) const {
+    if (m_influenceRadius <= 0.0f) {
+        return dir;
+    }
+
+    const double M = m_scene.schwarzschildRadius * 0.5;
+    glm::dvec3 rel = glm::dvec3(pos - m_scene.blackHolePos);
+    double r = glm::length(rel);
+    glm::dvec3 e1 = rel / r;
+    glm::dvec3 direction = glm::normalize(glm::dvec3(dir));
+    double cosPsi = glm::dot(direction, e1);
+    glm::dvec3 perp = direction - cosPsi * e1;
+    double sinPsi = glm::length(perp);
+    if (sinPsi < 1e-6) {
+        return dir;
+    }
+
+    // The Kerr integrator's direction is in coordinates, where the orbit has
+    // (du/dphi)^2 = u^2 cot^2(psi)
+    double u = 1.0 / r;
+    double w2 = law == Physics::FarFieldLaw::Model ? Physics::orbitPotential(law, M, u) : u * u;
+    double phi = Physics::orbitSweep(law, M, u, w2 * cosPsi * cosPsi / (sinPsi * sinPsi));
+    glm::dvec3 escapeDir = std::cos(phi) * e1 + std::sin(phi) * (perp / sinPsi) +
+                           Physics::spinDeflection(law, M, m_scene.blackHoleSpin, rel, direction, 0.0);
+    return glm::vec3(glm::normalize(escapeDir));
+}
+
+glm::vec3 CpuRayTracer::getDiskEmission(float radius, const glm::vec2& diskCoord) const {
+    // Temperature profile: T ~ r^(-3/4)
+    float tempRatio = m_scene.diskInnerRadius / radius;
+    float temperature = 100000.0f * std::pow(tempRatio, 0.75f);
+
+    // Add some variation
+    temperature *= (0.9f + 0.2f * std::sin(radius * 10.0f));
+
+    // Intensity falloff
+    float intensity = glm::clamp(tempRatio * tempRatio, 0.0f, 10.0f);
+    intensity *= 1.0f + getDiskHotspots(radius, diskCoord.y);
+
+    // Doppler factor of the orbiting gas (simplified); colour shift and
+    // beaming come from the same table shade.comp samples
+    float phi = diskCoord.y;
+    float velocity = std::sqrt(m_scene.schwarzschildRadius * 0.5f / radius);
+    float dopplerShift = 1.0f + velocity * std::cos(phi) * 0.3f;
+    glm::vec3 color = Physics::EmissionTables::get().shifted(temperature, dopplerShift);
+
+    return color * intensity * 3.0f;
+}
+
+float CpuRayTracer::getDiskHotspots(float radius, float phi) const {
+    // Each spot moves on a Keplerian orbit, prograde with the hole (decreasing phi)
+    const float pi = glm::pi<float>();
+    float M = m_scene.schwarzschildRadius * 0.5f;
+    float width = m_scene.diskOuterRadius - m_scene.diskInnerRadius;
+    float boost = 0.0f;
+
+    for (int i = 0; i < HOTSPOT_COUNT; ++i) {
+        float spotRadius = m_scene.diskInnerRadius + HOTSPOT_RADIUS[i] * width;
+        float omega = std::sqrt(M / (spotRadius * spotRadius * spotRadius));
+        float spotPhi = HOTSPOT_PHASE[i] - omega * m_scene.diskRotationSpeed * m_scene.time * DISK_TIME_SCALE;
+
+        float dr = (radius - spotRadius) / (HOTSPOT_SIZE * spotRadius);
+        float dphi = phi - spotPhi + pi;
+        dphi = (dphi - 2.0f * pi * std::floor(dphi / (2.0f * pi)) - pi) / HOTSPOT_SIZE;
+        boost += std::exp(-(dr * dr + dphi * dphi));
+    }
+    return HOTSPOT_BRIGHTNESS * boost;
+}
+
+glm::vec3 CpuRayTracer::sampleStarfield(const glm::vec3& dir) const {
+    // Convert direction to spherical coordinates
+    float phi = std::atan2(dir.z, dir.x);
+    float theta = std::acos(glm::clamp(dir.y, -1.0f, 1.0f));
+
+    glm::vec2 uv(phi / glm::two_pi<float>() + 0.5f, theta / glm::pi<float>());
+
+    glm::vec3 stars(0.0f);
+
+    // Hash function for random stars
+    glm::vec2 cell(std::floor(uv.x * 1000.0f), std::floor(uv.y * 1000.0f));
+    float hash = glm::fract(std::sin(glm::dot(cell, glm::vec2(12.9898f, 78.233f))) * 43758.5453f);
+    if (hash > 0.995f) {
+        float brightness = hash * 2.0f;
+        stars = glm::vec3(brightness);
+
+        if (hash > 0.998f) {
+            stars = glm::vec3(0.7f, 0.9f, 1.0f) * brightness;  // Blue stars
+        } else if (hash < 0.996f) {
+            stars = glm::vec3(1.0f, 0.8f, 0.6f) * brightness;  // Red stars
+        }
+    }
+
+    // Nebula-like background
+    float nebula = 0.05f * std::sin(uv.x * 20.0f) * std::cos(uv.y * 15.0f);
+    stars += glm::vec3(0.1f, 0.05f, 0.15f) * std::max(nebula, 0.0f);
+
+    return stars;
+}
+
+PacketParams CpuRayTracer::makePacketParams() const {
+    PacketParams params;
+    params.blackHolePos = m_scene.blackHolePos;
+    params.schwarzschildRadius = m_scene.schwarzschildRadius;
+    params.blackHoleSpin = m_scene.blackHoleSpin;
+    params.diskInnerRadius = m_scene.diskInnerRadius;
+    params.diskOuterRadius = m_scene.diskOuterRadius;
+    params.maxDistance = Physics::RAY_MAX_RADIUS;
+    params.influenceRadius = getFarFieldRadius(Physics::FarFieldLaw::Model);
+    params.farFieldBend = FAR_FIELD_BEND * m_scene.schwarzschildRadius;
+    params.stepSize = m_stepSize;
+    params.maxSteps = m_maxSteps;
+    params.showAccretionDisk = m_showAccretionDisk;
+    params.showPhotonSphere = m_showPhotonSphere;
+    return params;
+}
+
+glm::vec4 CpuRayTracer::traceRay(const glm::vec3& origin, const glm::vec3& direction) const {
+    return shadeHit(marchRay(origin, direction));
+}
+
+RayHit CpuRayTracer::marchRay(const glm::vec3& origin, const glm::vec3& direction,
+                              LensingSample* sample) const {
+    if (m_integrator == GeodesicIntegrator::RK45) {
+        return marchRayAdaptive(origin, direction, sample);
+    }
+    if (m_integrator == GeodesicIntegrator::Kerr) {
+        if (isSchwarzschildFastPathActive() &&
+            m_lensing.matchesCameraRadius(glm::length(origin - m_scene.blackHolePos))) {
+            return marchRaySchwarzschild(origin, direction, sample);
+        }
+        return marchRayKerr(origin, direction, sample);
+    }
+    return marchRayFixedStep(origin, direction, sample);
+}
+
+RayHit CpuRayTracer::marchRayFixedStep(const glm::vec3& origin, const glm::vec3& direction,
+                                       LensingSample* sample) const {
+    glm::vec3 pos = origin;
+    glm::vec3 dir = direction;
+
+    RayHit hit;
+    hit.type = RayHitType::None;
+    hit.steps = m_maxSteps;
+
+    // Cross the far field in closed form
+    if (enterFarField(pos, dir, sample != nullptr, Physics::FarFieldLaw::Model) == FarFieldEntry::Escaped) {
+        hit.type = RayHitType::Escaped;
+        hit.position = pos;
+        hit.direction = dir;
+        hit.steps = 0;
+        return hit;
+    }
+
+    bool absorbed = false;
+
+    for (int step = 0; step < m_maxSteps; ++step) {
+        // Check accretion disk intersection
+        if (m_showAccretionDisk && !sample) {
+            float t;
+            float radius;
+            glm::vec2 diskCoord;
+
+            if (intersectDisk(pos, dir, t, radius, diskCoord) && t < m_stepSize * 2.0f) {
+                hit.type = RayHitType::Disk;
+                hit.position = pos + t * dir;
+                hit.steps = step;
+                break;
+            }
+        }
+
+        // Integrate geodesic
+        glm::vec3 newDir = integrateGeodesic(pos, dir, m_stepSize, absorbed);
+
+        if (absorbed) {
+            hit.type = RayHitType::Absorbed;
+            hit.steps = step;
+            break;
+        }
+
+        dir = newDir;
+        glm::vec3 prevPos = pos;
+        pos += dir * m_stepSize;
+
+        if (sample && (prevPos.y > 0.0f) != (pos.y > 0.0f)) {
+            recordDiskCrossing(*sample, glm::mix(prevPos, pos, prevPos.y / (prevPos.y - pos.y)));
+        }
+
+        float r = glm::length(pos - m_scene.blackHolePos);
+
+        // Check if escaped
+        if (r > Physics::RAY_MAX_RADIUS || isLeavingFarField(pos, dir, r, sample != nullptr)) {
+            hit.type = RayHitType::Escaped;
+            hit.steps = step + 1;
+            break;
+        }
+
+        // Visual indicators
+        if (m_showPhotonSphere || sample) {
+            float photonSphereRadius = m_scene.schwarzschildRadius * 1.5f;
+            if (std::abs(r - photonSphereRadius) < 0.1f) {
+                if (sample) {
+                    recordPhotonSphere(*sample);
+                } else {
+                    hit.type = RayHitType::PhotonSphere;
+                    hit.steps = step + 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    hit.position = hit.type == RayHitType::Disk ? hit.position : pos;
+    hit.direction = dir;
+    if (hit.type == RayHitType::Escaped) {
+        hit.direction = getFarFieldDirection(pos, dir, Physics::FarFieldLaw::Model);
+    }
+    return hit;
+}
+
+RayHit CpuRayTracer::marchRayAdaptive(const glm::vec3& origin, const glm::vec3& direction,
+                                      LensingSample* sample) const {
+    float Rs = m_scene.schwarzschildRadius;
+    float M = Rs * 0.5f;
+    float a = m_scene.blackHoleSpin * M;
+    float absorbRadius = (M + std::sqrt(std::max(M * M - a * a, 0.01f))) * 1.1f;
+    float photonSphereRadius = Rs * 1.5f;
+
+    glm::vec3 pos = origin;
+    glm::vec3 vel = direction;
+
+    RayHit hit;
+    hit.type = RayHitType::None;
+
+    if (enterFarField(pos, vel, sample != nullptr, Physics::FarFieldLaw::Model) == FarFieldEntry::Escaped) {
+        hit.type = RayHitType::Escaped;
+        hit.position = pos;
+        hit.direction = vel;
+        hit.steps = 0;
+        return hit;
+    }
+    float r = glm::length(pos - m_scene.blackHolePos);
+
+    glm::vec3 kx1, kv1;
+    geodesicDerivative(pos, vel, kx1, kv1);
+
+    float h = std::max(0.1f * r, RK_MIN_STEP);
+    int attempts = 0;
+
+    while (attempts < m_maxSteps) {
+        if (r < absorbRadius) {
+            hit.type = RayHitType::Absorbed;
+            break;
+        }
+
+        h = glm::clamp(h, RK_MIN_STEP, std::max(RK_MAX_STEP_FRACTION * r, RK_MIN_STEP));
+        ++attempts;
+
+        glm::vec3 kx2, kv2, kx3, kv3, kx4, kv4, kx5, kv5, kx6, kv6, kx7, kv7;
+        geodesicDerivative(pos + h * (DP_A21 * kx1),
+                           vel + h * (DP_A21 * kv1), kx2, kv2);
+        geodesicDerivative(pos + h * (DP_A31 * kx1 + DP_A32 * kx2),
+                           vel + h * (DP_A31 * kv1 + DP_A32 * kv2), kx3, kv3);
+        geodesicDerivative(pos + h * (DP_A41 * kx1 + DP_A42 * kx2 + DP_A43 * kx3),
+                           vel + h * (DP_A41 * kv1 + DP_A42 * kv2 + DP_A43 * kv3), kx4, kv4);
+        geodesicDerivative(pos + h * (DP_A51 * kx1 + DP_A52 * kx2 + DP_A53 * kx3 + DP_A54 * kx4),
+                           vel + h * (DP_A51 * kv1 + DP_A52 * kv2 + DP_A53 * kv3 + DP_A54 * kv4), kx5, kv5);
+        geodesicDerivative(pos + h * (DP_A61 * kx1 + DP_A62 * kx2 + DP_A63 * kx3 + DP_A64 * kx4 + DP_A65 * kx5),
+                           vel + h * (DP_A61 * kv1 + DP_A62 * kv2 + DP_A63 * kv3 + DP_A64 * kv4 + DP_A65 * kv5),
+                           kx6, kv6);
+
+        glm::vec3 newPos = pos + h * (DP_B1 * kx1 + DP_B3 * kx3 + DP_B4 * kx4 + DP_B5 * kx5 + DP_B6 * kx6);
+        glm::vec3 newVel = vel + h * (DP_B1 * kv1 + DP_B3 * kv3 + DP_B4 * kv4 + DP_B5 * kv5 + DP_B6 * kv6);
+        geodesicDerivative(newPos, newVel, kx7, kv7);
+
+        // Error of the embedded fourth-order solution, relative to r for
+        // the position so that far-field steps can grow freely
+        glm::vec3 errPos = h * (DP_E1 * kx1 + DP_E3 * kx3 + DP_E4 * kx4 + DP_E5 * kx5 + DP_E6 * kx6 + DP_E7 * kx7);
+        glm::vec3 errVel = h * (DP_E1 * kv1 + DP_E3 * kv3 + DP_E4 * kv4 + DP_E5 * kv5 + DP_E6 * kv6 + DP_E7 * kv7);
+        float error = std::max(glm::length(errPos) / (m_tolerance * std::max(r, 1.0f)),
+                               glm::length(errVel) / m_tolerance);
+
+        float scale = error > 0.0f ? RK_SAFETY * std::pow(error, -0.2f) : RK_MAX_SCALE;
+
+        if (error > 1.0f && h > RK_MIN_STEP) {
+            // Reject and retry with a smaller step
+            h *= std::max(scale, RK_MIN_SCALE);
+            continue;
+        }
+
+        // Accretion disk crossing (plane y = 0) within this step
+        if ((m_showAccretionDisk || sample) && ((pos.y > 0.0f) != (newPos.y > 0.0f))) {
+            float lo = 0.0f;
+            float hi = 1.0f;
+            for (int i = 0; i < 12; ++i) {
+                float mid = 0.5f * (lo + hi);
+                float y = hermitePosition(pos, kx1, newPos, kx7, h, mid).y;
+                if ((y > 0.0f) == (pos.y > 0.0f)) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            float t = 0.5f * (lo + hi);
+            glm::vec3 crossing = hermitePosition(pos, kx1, newPos, kx7, h, t);
+            float radius = glm::length(glm::vec2(crossing.x, crossing.z));
+
+            if (sample) {
+                recordDiskCrossing(*sample, crossing);
+            } else if (radius >= m_scene.diskInnerRadius && radius <= m_scene.diskOuterRadius) {
+                hit.type = RayHitType::Disk;
+                hit.position = crossing;
+                hit.direction = glm::normalize(hermiteTangent(pos, kx1, newPos, kx7, h, t));
+                hit.steps = attempts;
+                return hit;
+            }
+        }
+
+        float newR = glm::length(newPos - m_scene.blackHolePos);
+
+        // Photon sphere shell crossed during this step
+        bool onPhotonSphere = (m_showPhotonSphere || sample) &&
+            ((r - photonSphereRadius) * (newR - photonSphereRadius) <= 0.0f ||
+             std::abs(newR - photonSphereRadius) < 0.1f);
+
+        // Accept: first-same-as-last, so k7 becomes the next k1
+        pos = newPos;
+        vel = glm::normalize(newVel);
+        kx1 = kx7;
+        kv1 = kv7;
+        r = newR;
+        h *= glm::clamp(scale, RK_MIN_SCALE, RK_MAX_SCALE);
+
+        if (r > Physics::RAY_MAX_RADIUS || isLeavingFarField(pos, vel, r, sample != nullptr)) {
+            hit.type = RayHitType::Escaped;
+            break;
+        }
+        if (onPhotonSphere) {
+            if (sample) {
+                recordPhotonSphere(*sample);
+            } else {
+                hit.type = RayHitType::PhotonSphere;
+                break;
+            }
+        }
+    }
+
+    hit.position = pos;
+    hit.direction = glm::normalize(vel);
+    if (hit.type == RayHitType::Escaped) {
+        hit.direction = getFarFieldDirection(pos, hit.direction, Physics::FarFieldLaw::Model);
+    }
+    hit.steps = attempts;
+    return hit;
+}
+
+RayHit CpuRayTracer::marchRayKerr(const glm::vec3& origin, const glm::vec3& direction,
+                                  LensingSample* sample) const {
+    using Physics::KerrState;
+
+    const double M = m_scene.schwarzschildRadius * 0.5;
+    const Physics::KerrGeodesic kerr(M, m_scene.blackHoleSpin);
+    const double a2 = kerr.getSpinParameter() * kerr.getSpinParameter();
+    const double absorbRadius = kerr.getHorizonRadius() * 1.01;
+    const double photonSphereRadius = m_scene.schwarzschildRadius * 1.5;
+
+    const double farFieldRadius = getFarFieldRadius(Physics::FarFieldLaw::Schwarzschild);
+
+    RayHit hit;
+    hit.type = RayHitType::None;
+    hit.position = origin;
+    hit.direction = direction;
+    hit.steps = 0;
+
+    // Cross the far field along the Schwarzschild orbit
+    glm::vec3 start = origin;
+    glm::vec3 startDir = direction;
+    if (enterFarField(start, startDir, sample != nullptr, Physics::FarFieldLaw::Schwarzschild) ==
+        FarFieldEntry::Escaped) {
+        hit.type = RayHitType::Escaped;
+        hit.direction = startDir;
+        return hit;
+    }
+
+    Physics::KerrConstants constants;
+    KerrState state;
+    if (!kerr.initialize(start - m_scene.blackHolePos, startDir, constants, state)) {
+        hit.type = RayHitType::Absorbed;
+        return hit;
+    }
+
+    // Error scales of the Mino-time momenta: |dtheta/dlambda| <= sqrt(Q + a^2)
+    // and |dr/dlambda| grows as r^2
+    const double thetaMomentumScale = std::sqrt(std::abs(constants.Q) + a2) + M;
+
+    // Integrate in s with dlambda = ds / (r^2 + a^2). In pure Mino time r
+    // reaches infinity at finite lambda, which forces ever smaller steps on
+    // escaping rays; in s, r grows about linearly far from the hole.
+    auto rate = [&](const KerrState& s) {
+        return (1.0 / (s.r * s.r + a2)) * kerr.derivative(constants, s);
+    };
+
+    KerrState k1 = rate(state);
+    double speed = std::max(static_cast<double>(glm::length(kerr.cartesianVelocity(state, k1))), 1e-12);
+    double h = 0.1 * state.r / speed;
+    int attempts = 0;
+
+    while (attempts < m_maxSteps) {
+        if (state.r < absorbRadius) {
+            hit.type = RayHitType::Absorbed;
+            break;
+        }
+
+        // Same spatial step limits as the RK45 integrator, converted to s
+        double minStep = RK_MIN_STEP / speed;
+        double maxStep = std::max(RK_MAX_STEP_FRACTION * state.r, static_cast<double>(RK_MIN_STEP)) / speed;
+        h = glm::clamp(h, minStep, maxStep);
+        ++attempts;
+
+        KerrState k2 = rate(state + h * (DP_A21 * k1));
+        KerrState k3 = rate(state + h * (DP_A31 * k1 + DP_A32 * k2));
+        KerrState k4 = rate(state + h * (DP_A41 * k1 + DP_A42 * k2 + DP_A43 * k3));
+        KerrState k5 = rate(state + h * (DP_A51 * k1 + DP_A52 * k2 + DP_A53 * k3 +
+                                                               DP_A54 * k4));
+        KerrState k6 = rate(state + h * (DP_A61 * k1 + DP_A62 * k2 + DP_A63 * k3 +
+                                                               DP_A64 * k4 + DP_A65 * k5));
+
+        KerrState next = state + h * (DP_B1 * k1 + DP_B3 * k3 + DP_B4 * k4 + DP_B5 * k5 + DP_B6 * k6);
+        KerrState k7 = rate(next);
+
+        KerrState err = h * (DP_E1 * k1 + DP_E3 * k3 + DP_E4 * k4 + DP_E5 * k5 + DP_E6 * k6 + DP_E7 * k7);
+        double error = std::max({ std::abs(err.r) / std::max(state.r, 1.0),
+                                  std::abs(err.theta),
+                                  std::abs(err.phi * std::sin(state.theta)),
+                                  std::abs(err.pr) / (state.r * state.r + a2),
+                                  std::abs(err.ptheta) / thetaMomentumScale }) / m_tolerance;
+
+        double scale = error > 0.0 ? RK_SAFETY * std::pow(error, -0.2) : RK_MAX_SCALE;
+
+        if (error > 1.0 && h > minStep) {
+            h *= std::max(scale, static_cast<double>(RK_MIN_SCALE));
+            continue;
+        }
+
+        // Equatorial plane crossing: cos(theta) changes sign
+        if ((m_showAccretionDisk || sample) && ((std::cos(state.theta) > 0.0) != (std::cos(next.theta) > 0.0))) {
+            const double halfPi = glm::half_pi<double>();
+            double lo = 0.0;
+            double hi = 1.0;
+            for (int i = 0; i < 12; ++i) {
+                double mid = 0.5 * (lo + hi);
+                double theta = hermiteScalar(state.theta, k1.theta, next.theta, k7.theta, h, mid);
+                if ((theta < halfPi) == (state.theta < halfPi)) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            double t = 0.5 * (lo + hi);
+            double radius = hermiteScalar(state.r, k1.r, next.r, k7.r, h, t);
+            double phi = hermiteScalar(state.phi, k1.phi, next.phi, k7.phi, h, t);
+
+            // Disk radii are Boyer-Lindquist r, so place the hit at r in the plane
+            glm::vec3 crossing = m_scene.blackHolePos +
+                                 glm::vec3(static_cast<float>(radius * std::cos(phi)), 0.0f,
+                                           static_cast<float>(-radius * std::sin(phi)));
+            if (sample) {
+                recordDiskCrossing(*sample, crossing);
+            } else if (radius >= m_scene.diskInnerRadius && radius <= m_scene.diskOuterRadius) {
+                hit.type = RayHitType::Disk;
+                hit.position = crossing;
+                hit.direction = glm::normalize(kerr.cartesianVelocity(next, k7));
+                hit.steps = attempts;
+                return hit;
+            }
+        }
+
+        bool onPhotonSphere = (m_showPhotonSphere || sample) &&
+            ((state.r - photonSphereRadius) * (next.r - photonSphereRadius) <= 0.0 ||
+             std::abs(next.r - photonSphereRadius) < 0.1);
+
+        // Accept. Projection moves the state, so k7 cannot be reused as k1
+        kerr.project(constants, next);
+        state = next;
+        k1 = rate(state);
+        speed = std::max(static_cast<double>(glm::length(kerr.cartesianVelocity(state, k1))), 1e-12);
+        h *= glm::clamp(scale, static_cast<double>(RK_MIN_SCALE), static_cast<double>(RK_MAX_SCALE));
+
+        if (state.r > Physics::RAY_MAX_RADIUS) {
+            hit.type = RayHitType::Escaped;
+            break;
+        }
+        if (state.r >= farFieldRadius && state.pr > 0.0 &&
+            isFarFieldClear(m_scene.blackHolePos + kerr.toCartesian(state.r, state.theta, state.phi),
+                            glm::normalize(kerr.cartesianVelocity(state, k1)),
+                            static_cast<float>(state.r), sample != nullptr)) {
+            hit.type = RayHitType::Escaped;
+            break;
+        }
+        if (onPhotonSphere) {
+            if (sample) {
+                recordPhotonSphere(*sample);
+            } else {
+                hit.type = RayHitType::PhotonSphere;
+                break;
+            }
+        }
+    }
+
+    hit.position = m_scene.blackHolePos + kerr.toCartesian(state.r, state.theta, state.phi);
+    hit.direction = glm::normalize(kerr.cartesianVelocity(state, k1));
+    if (hit.type == RayHitType::Escaped) {
+        hit.direction = getFarFieldDirection(hit.position, hit.direction, Physics::FarFieldLaw::Schwarzschild);
+    }
+    hit.steps = attempts;
+    return hit;
+}
+
+bool CpuRayTracer::isSchwarzschildFastPathActive() const {
+    return m_useSchwarzschildFastPath && m_integrator == GeodesicIntegrator::Kerr &&
+           m_scene.blackHoleSpin < Physics::SCHWARZSCHILD_SPIN_THRESHOLD;
+}
+
+bool CpuRayTracer::isShadowCullingActive() const {
+    return m_useShadowCulling && m_integrator == GeodesicIntegrator::Kerr &&
+           !isSchwarzschildFastPathActive() && !m_showPhotonSphere;
+}
+
+bool CpuRayTracer::isCulledByShadow(const glm::vec3& direction) const {
+    float depth = glm::dot(direction, m_forward);
+    glm::vec2 point(glm::dot(direction, m_right) / depth, glm::dot(direction, m_up) / depth);
+    if (!m_shadowProfile.contains(point)) {
+        return false;
+    }
+    return !m_showAccretionDisk || !canReachDisk(direction);
+}
+
+bool CpuRayTracer::canReachDisk(const glm::vec3& direction) const {
+    // A captured photon falls monotonically in r, so it meets the disk if
+    // it crosses the equatorial plane between the Mino times at which it
+    // passes the outer and the inner edge. The window is widened to cover
+    // the quadratures and the march's far-field entry.
+    const Physics::KerrGeodesic kerr(m_scene.schwarzschildRadius * 0.5, m_scene.blackHoleSpin);
+    Physics::KerrConstants constants;
+    Physics::KerrState state;
+    if (!kerr.initialize(m_scene.cameraPos - m_scene.blackHolePos, direction, constants, state)) {
+        return false;
+    }
+
+    // Q <= 0: never crosses the plane, but may run along it
+    if (constants.Q <= 0.0) {
+        return std::abs(std::cos(state.theta)) < 1e-3;
+    }
+
+    double r = state.r;
+    double inner = m_scene.diskInnerRadius;
+    double outer = m_scene.diskOuterRadius;
+    if (r <= inner) {
+        return false;
+    }
+    double enterTime = r > outer ? kerr.radialMinoTime(constants, r, outer) * (1.0 - SHADOW_DISK_MARGIN) : 0.0;
+    double leaveTime = kerr.radialMinoTime(constants, r, inner) * (1.0 + SHADOW_DISK_MARGIN);
+
+    double period;
+    double crossing = kerr.equatorMinoTime(constants, state, period);
+    if (crossing < enterTime) {
+        crossing += std::ceil((enterTime - crossing) / period) * period;
+    }
+    return crossing <= leaveTime;
+}
+
+RayHit CpuRayTracer::marchRaySchwarzschild(const glm::vec3& origin, const glm::vec3& direction,
+                                           LensingSample* sample) const {
+    using Physics::SchwarzschildLensing;
+
+    RayHit hit;
+    hit.type = RayHitType::None;
+    hit.position = origin;
+    hit.direction = direction;
+    hit.steps = 1;
+
+    // In-plane basis: e1 points from the hole to the camera (phi = 0),
+    // e2 is the direction of increasing phi along the ray
+    glm::vec3 e1 = glm::normalize(origin - m_scene.blackHolePos);
+    float cosAlpha = glm::clamp(glm::dot(direction, e1), -1.0f, 1.0f);
+    glm::vec3 perp = direction - cosAlpha * e1;
+    glm::vec3 e2;
+    if (glm::length(perp) > 1e-6f) {
+        e2 = glm::normalize(perp);
+    } else {
+        // Radial ray: any plane through it works
+        glm::vec3 axis = std::abs(e1.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        e2 = glm::normalize(glm::cross(glm::cross(e1, axis), e1));
+    }
+
+    // Blend the two nearest rows unless their orbits end differently
+    float t = m_lensing.rowCoordinate(std::acos(cosAlpha)) * (SchwarzschildLensing::ROWS - 1);
+    int row0 = std::min(static_cast<int>(t), SchwarzschildLensing::ROWS - 2);
+    int row1 = row0 + 1;
+    float f = t - static_cast<float>(row0);
+
+    const SchwarzschildLensing::RowInfo& info0 = m_lensing.getRow(row0);
+    const SchwarzschildLensing::RowInfo& info1 = m_lensing.getRow(row1);
+    if (info0.fate != info1.fate) {
+        f = f < 0.5f ? 0.0f : 1.0f;
+    }
+    const SchwarzschildLensing::RowInfo& nearest = f < 0.5f ? info0 : info1;
+
+    float phiEnd = glm::mix(info0.phiEnd, info1.phiEnd, f);
+    float phiPhotonSphere = (m_showPhotonSphere || sample) ? nearest.phiPhotonSphere : -1.0f;
+
+    auto sampleU = [&](float phi) {
+        return glm::mix(m_lensing.sampleU(row0, phi), m_lensing.sampleU(row1, phi), f);
+    };
+
+    // The ray meets the disk plane y = 0 where cos(phi) e1.y + sin(phi) e2.y = 0,
+    // i.e. every pi after the first crossing phi0
+    if ((m_showAccretionDisk || sample) && (std::abs(e1.y) > 1e-6f || std::abs(e2.y) > 1e-6f)) {
+        const float pi = glm::pi<float>();
+        float phi0 = std::fmod(std::atan2(-e1.y, e2.y), pi);
+        if (phi0 <= 1e-6f) {
+            phi0 += pi;
+        }
+
+        for (float phi = phi0; phi < phiEnd; phi += pi) {
+            if (phiPhotonSphere >= 0.0f && phiPhotonSphere < phi) {
+                if (!sample) {
+                    break;
+                }
+                recordPhotonSphere(*sample);
+            }
+
+            float u = sampleU(phi);
+            float radius = 1.0f / u;
+            if (sample) {
+                recordDiskCrossing(*sample, m_scene.blackHolePos +
+                                            radius * (std::cos(phi) * e1 + std::sin(phi) * e2));
+            } else if (radius >= m_scene.diskInnerRadius && radius <= m_scene.diskOuterRadius) {
+                glm::vec3 radial = std::cos(phi) * e1 + std::sin(phi) * e2;
+                glm::vec3 tangent = -std::sin(phi) * e1 + std::cos(phi) * e2;
+                float du = (sampleU(phi + 1e-3f) - sampleU(phi - 1e-3f)) / 2e-3f;
+
+                hit.type = RayHitType::Disk;
+                hit.position = m_scene.blackHolePos + radius * radial;
+                hit.direction = glm::normalize(-du * radius * radius * radial + radius * tangent);
+                return hit;
+            }
+        }
+    }
+
+    if (phiPhotonSphere >= 0.0f) {
+        if (sample) {
+            recordPhotonSphere(*sample);
+        } else {
+            hit.type = RayHitType::PhotonSphere;
+            return hit;
+        }
+    }
+
+    if (nearest.fate == static_cast<float>(SchwarzschildLensing::Captured)) {
+        hit.type = RayHitType::Absorbed;
+        return hit;
+    }
+
+    // Escaped: the asymptote points along the position angle where u = 0
+    hit.type = RayHitType::Escaped;
+    hit.direction = std::cos(phiEnd) * e1 + std::sin(phiEnd) * e2;
+    hit.position = m_scene.blackHolePos + Physics::RAY_MAX_RADIUS * hit.direction;
+    return hit;
+}
+
+bool CpuRayTracer::reshadeFromLensingMap(std::shared_ptr<LensingMap>& recordMap) {
+    LensingMapKey key = makeLensingMapKey();
+
+    std::shared_ptr<const LensingMap> map = m_lensingMapCache->find(key);
+    if (map) {
+        shadeLensingMap(*map, nullptr, 0.0f);
+        m_lensingMapResult = LensingMapResult::Cached;
+        return true;
+    }
+
+    // Spin preview: blend the nearest cached spins rather than stall the
+    // slider on a full trace per value
+    std::shared_ptr<const LensingMap> below;
+    std::shared_ptr<const LensingMap> above;
+    if (m_lensingMapPreview && m_lensingMapCache->findSpinNeighbors(key, below, above)) {
+        if (below && above) {
+            float spinBelow = below->getKey().getSpin();
+            float spinAbove = above->getKey().getSpin();
+            float blend = (key.getSpin() - spinBelow) / (spinAbove - spinBelow);
+            shadeLensingMap(*below, above.get(), glm::clamp(blend, 0.0f, 1.0f));
+        } else {
+            shadeLensingMap(below ? *below : *above, nullptr, 0.0f);
+        }
+        m_lensingMapResult = LensingMapResult::Interpolated;
+        return true;
+    }
+
+    recordMap = std::make_shared<LensingMap>(key);
+    return false;
+}
+
+void CpuRayTracer::shadeLensingMap(const LensingMap& map, const LensingMap* other, float blend) {
+    const LensingSample* samples = map.getSamples();
+    const LensingSample* otherSamples = other ? other->getSamples() : nullptr;
+    const int width = m_width;
+    const int height = m_height;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(getThreadCount())
+#endif
+    for (int y = 0; y < height; ++y) {
+        size_t row = static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            glm::vec4 color = shadeSample(samples[row + x]);
+            if (otherSamples) {
+                color = glm::mix(color, shadeSample(otherSamples[row + x]), blend);
+            }
+            float* out = m_pixels.data() + (row + x) * 4;
+            out[0] = color.r;
+            out[1] = color.g;
+            out[2] = color.b;
+            out[3] = color.a;
+        }
+    }
+}
+
+LensingMapKey CpuRayTracer::makeLensingMapKey() const {
+    auto quantize = [](float value, float step) {
+        return static_cast<int32_t>(std::lround(value / step));
+    };
+
+    glm::vec3 cameraOffset = m_scene.cameraPos - m_scene.blackHolePos;
+    float distance = std::max(glm::length(cameraOffset), 1e-6f);
+    glm::vec3 forward = toCanonical(m_forward);
+    glm::vec3 up = toCanonical(m_up);
+
+    LensingMapKey key{};
+    key.width = m_width;
+    key.height = m_height;
+    key.integrator = static_cast<int32_t>(m_integrator);
+    key.maxSteps = m_maxSteps;
+    if (m_integrator == GeodesicIntegrator::FixedStep) {
+        key.stepSize = quantize(std::log(m_stepSize), LensingMapKey::LOG_STEP);
+    } else {
+        key.tolerance = quantize(std::log(m_tolerance), LensingMapKey::LOG_STEP);
+    }
+    key.fastPath = isSchwarzschildFastPathActive() ? 1 : 0;
+    if (!key.fastPath) {
+        key.influenceRadius = quantize(m_influenceRadius, LensingMapKey::INFLUENCE_STEP);
+    }
+    key.mass = quantize(std::log(m_scene.schwarzschildRadius), LensingMapKey::LOG_STEP);
+    key.spin = quantize(m_scene.blackHoleSpin, LensingMapKey::SPIN_STEP);
+    key.distance = quantize(std::log(distance), LensingMapKey::LOG_STEP);
+    key.inclination = quantize(std::acos(glm::clamp(cameraOffset.y / distance, -1.0f, 1.0f)),
+                               LensingMapKey::ANGLE_STEP);
+    key.fov = quantize(m_scene.fov, LensingMapKey::FOV_STEP);
+    for (int i = 0; i < 3; ++i) {
+        key.forward[i] = quantize(forward[i], LensingMapKey::DIRECTION_STEP);
+        key.up[i] = quantize(up[i], LensingMapKey::DIRECTION_STEP);
+    }
+    return key;
+}
+
+glm::vec4 CpuRayTracer::shadeSample(const LensingSample& sample) const {
+    RayHit hit;
+    hit.type = static_cast<RayHitType>(sample.type);
+    hit.position = m_scene.blackHolePos;
+    hit.direction = fromCanonical(glm::vec3(sample.direction[0], sample.direction[1], sample.direction[2]));
+    hit.steps = 0;
+
+    // Same precedence as a direct trace: the first disk crossing inside the
+    // current radii wins unless the ray reached the photon sphere before it
+    bool photonSphere = m_showPhotonSphere && sample.photonSphereCrossings >= 0;
+    for (int i = 0; i < sample.crossingCount; ++i) {
+        if (photonSphere && i >= sample.photonSphereCrossings) {
+            break;
+        }
+        float radius = sample.crossingRadius[i];
+        if (m_showAccretionDisk && radius >= m_scene.diskInnerRadius && radius <= m_scene.diskOuterRadius) {
+            float phi = sample.crossingPhi[i] + m_cameraAzimuth;
+            hit.type = RayHitType::Disk;
+            hit.position = m_scene.blackHolePos + glm::vec3(radius * std::cos(phi), 0.0f, radius * std::sin(phi));
+            return shadeHit(hit);
+        }
+    }
+
+    if (photonSphere) {
+        hit.type = RayHitType::PhotonSphere;
+    }
+    return shadeHit(hit);
+}
+
+void CpuRayTracer::recordDiskCrossing(LensingSample& sample, const glm::vec3& position) const {
+    if (sample.crossingCount >= LensingSample::MAX_CROSSINGS) {
+        return;
+    }
+    glm::vec3 p = toCanonical(position - m_scene.blackHolePos);
+    sample.crossingRadius[sample.crossingCount] = glm::length(glm::vec2(p.x, p.z));
+    sample.crossingPhi[sample.crossingCount] = std::atan2(p.z, p.x);
+    ++sample.crossingCount;
+}
+
+void CpuRayTracer::recordPhotonSphere(LensingSample& sample) const {
+    if (sample.photonSphereCrossings < 0) {
+        sample.photonSphereCrossings = sample.crossingCount;
+    }
+}
+
+glm::vec3 CpuRayTracer::toCanonical(const glm::vec3& v) const {
+    // Rotate about the spin axis by -azimuth (camera moves to azimuth 0)
+    float c = m_azimuthRotation.x;
+    float s = m_azimuthRotation.y;
+    return glm::vec3(v.x * c + v.z * s, v.y, -v.x * s + v.z * c);
+}
+
+glm::vec3 CpuRayTracer::fromCanonical(const glm::vec3& v) const {
+    float c = m_azimuthRotation.x;
+    float s = m_azimuthRotation.y;
+    return glm::vec3(v.x * c - v.z * s, v.y, v.x * s + v.z * c);
+}
+
+glm::vec4 CpuRayTracer::shadeHit(const RayHit& hit) const {
+    glm::vec4 color(0.0f);
+
+    switch (hit.type) {
+        case RayHitType::Disk: {
+            float radius = glm::length(glm::vec2(hit.position.x, hit.position.z));
+            glm::vec2 diskCoord(radius, std::atan2(hit.position.z, hit.position.x));
+            color = glm::vec4(getDiskEmission(radius, diskCoord), 1.0f);
+            break;
+        }
+        case RayHitType::Absorbed:
+            color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            break;
+        case RayHitType::Escaped:
+            color = glm::vec4(sampleStarfield(hit.direction), 1.0f);
+            break;
+        case RayHitType::PhotonSphere:
+            color = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
+            break;
+        default:
+            break;
+    }
+
+    // Gravitational redshift based on potential at the observer
+    float r = glm::length(m_scene.cameraPos - m_scene.blackHolePos);
+    float Rs = m_scene.schwarzschildRadius;
+    float redshift = std::sqrt(1.0f - Rs / std::max(r, Rs * 1.1f));
+    color.r *= redshift;
+    color.g *= redshift;
+    color.b *= redshift;
+
+    return color;
+}
+
+} // namespace Rendering
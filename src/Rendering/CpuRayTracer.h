@@ -0,0 +1,303 @@
+#pragma once
+
+#include "Integrator.h"
+#include "RayPacket.h"
+#include "ShadowProfile.h"
+#include "TileScheduler.h"
+#include "../Physics/FarField.h"
+#include "../Physics/SchwarzschildLensing.h"
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Core {
+    class Camera;
+}
+
+namespace Physics {
+    class BlackHole;
+    class AccretionDisk;
+}
+
+namespace Rendering {
+
+struct LensingSample;
+struct LensingMapKey;
+class LensingMap;
+class LensingMapCache;
+
+// How frame work is split across cores
+enum class CpuScheduling {
+    WorkStealing,  // Morton-ordered tiles with per-thread deques (default)
+    OpenMPRows     // OpenMP dynamic schedule over image rows
+};
+
+// Where the pixels of the last frame came from
+enum class LensingMapResult {
+    Disabled,      // No lensing map cache attached
+    Traced,        // Traced and stored as a new map
+    Cached,        // Re-shaded from a stored map
+    Interpolated   // Blended from maps of neighbouring spins (preview)
+};
+
+// CPU implementation of shaders/raytracer.comp.
+// Traces a full frame across all cores into an RGBA float buffer that can be
+// uploaded to the output texture in place of the compute dispatch.
+class CpuRayTracer {
+public:
+    CpuRayTracer(int width, int height);
+
+    void resize(int width, int height);
+
+    // Trace one frame into the pixel buffer
+    void render(const Core::Camera& camera,
+                const Physics::BlackHole& blackHole,
+                const Physics::AccretionDisk& disk);
+
+    // Trace a single ray using the parameters of the last render() call
+    glm::vec4 traceRay(const glm::vec3& origin, const glm::vec3& direction) const;
+    
+    // March a single ray without shading it, using the selected integrator.
+    // With a sample, disk-plane and photon sphere crossings are recorded
+    // into it instead of ending the ray.
+    RayHit marchRay(const glm::vec3& origin, const glm::vec3& direction,
+                    LensingSample* sample = nullptr) const;
+    
+    // Constant-step march (scalar reference for the packet kernel)
+    RayHit marchRayFixedStep(const glm::vec3& origin, const glm::vec3& direction,
+                             LensingSample* sample = nullptr) const;
+    
+    // Dormand-Prince 5(4) march with error-controlled step size
+    RayHit marchRayAdaptive(const glm::vec3& origin, const glm::vec3& direction,
+                            LensingSample* sample = nullptr) const;
+    
+    // Kerr null geodesic in Boyer-Lindquist coordinates and Mino time
+    RayHit marchRayKerr(const glm::vec3& origin, const glm::vec3& direction,
+                        LensingSample* sample = nullptr) const;
+    
+    // Table lookup for rays from the camera of a non-rotating hole
+    RayHit marchRaySchwarzschild(const glm::vec3& origin, const glm::vec3& direction,
+                                 LensingSample* sample = nullptr) const;
+
+    // RGBA32F pixels, row-major, first row is the bottom of the image (GL convention)
+    const std::vector<float>& getPixels() const { return m_pixels; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+    // Threading (0 = use all available cores)
+    void setThreadCount(int count);
+    int getThreadCount() const;
+    static int getMaxThreads();
+    
+    // Work distribution
+    void setScheduling(CpuScheduling scheduling) { m_scheduling = scheduling; }
+    CpuScheduling getScheduling() const { return m_scheduling; }
+    void setTileSize(int size) { m_scheduler.setTileSize(size); }
+    int getTileSize() const { return m_scheduler.getTileSize(); }
+    
+    // Per-thread busy/idle times of the last work-stealing frame
+    const TileScheduler& getScheduler() const { return m_scheduler; }
+
+    // SIMD ray packets (default: widest instruction set the CPU supports)
+    void setUsePackets(bool use) { m_usePackets = use; }
+    void setSimdLevel(SimdLevel level) { m_simdLevel = level; }
+    bool getUsePackets() const { return m_usePackets; }
+    SimdLevel getSimdLevel() const { return m_simdLevel; }
+    
+    // Ray marching settings (defaults match raytracer.comp)
+    void setMaxSteps(int steps) { m_maxSteps = steps; }
+    void setStepSize(float size) { m_stepSize = size; }
+    int getMaxSteps() const { return m_maxSteps; }
+    float getStepSize() const { return m_stepSize; }
+    
+    // Integration scheme. SIMD packets are used for the fixed-step march only.
+    void setIntegrator(GeodesicIntegrator integrator) { m_integrator = integrator; }
+    GeodesicIntegrator getIntegrator() const { return m_integrator; }
+    
+    // Relative error tolerance of the adaptive integrator
+    void setTolerance(float tolerance) { m_tolerance = tolerance; }
+    float getTolerance() const { return m_tolerance; }
+    
+    // Sphere of influence around the hole in Schwarzschild radii (0 = off).
+    // Rays from a camera outside it advance straight to it, and rays leaving
+    // it outbound take their escape direction in closed form, unless their
+    // line could still meet the disk.
+    void setInfluenceRadius(float radius) { m_influenceRadius = radius; }
+    float getInfluenceRadius() const { return m_influenceRadius; }
+    
+    // Kerr integrator on a hole with spin below SCHWARZSCHILD_SPIN_THRESHOLD:
+    // look rays up in a planar Binet table instead of integrating them
+    void setUseSchwarzschildFastPath(bool use) { m_useSchwarzschildFastPath = use; }
+    bool getUseSchwarzschildFastPath() const { return m_useSchwarzschildFastPath; }
+    bool isSchwarzschildFastPathActive() const;
+    const Physics::SchwarzschildLensing& getSchwarzschildLensing() const { return m_lensing; }
+    
+    // Kerr integrator: pixels well inside the analytic shadow are returned
+    // as captured without marching, unless their ray could still reach the
+    // disk first or the photon sphere overlay is on
+    void setUseShadowCulling(bool use) { m_useShadowCulling = use; }
+    bool getUseShadowCulling() const { return m_useShadowCulling; }
+    bool isShadowCullingActive() const;
+    const ShadowProfile& getShadowProfile() const { return m_shadowProfile; }
+    
+    // Lensing map cache (not owned, nullptr = trace every frame). Frames
+    // whose camera and tracer state match a stored map are only re-shaded,
+    // so disk radii and overlay changes never re-trace.
+    void setLensingMapCache(LensingMapCache* cache) { m_lensingMapCache = cache; }
+    LensingMapCache* getLensingMapCache() const { return m_lensingMapCache; }
+    
+    // While set (e.g. during a spin slider drag), a missing map is blended
+    // from cached maps of the neighbouring spins instead of traced
+    void setLensingMapPreview(bool preview) { m_lensingMapPreview = preview; }
+    LensingMapResult getLensingMapResult() const { return m_lensingMapResult; }
+    
+    // Steps per ray of the last frame (adaptive: accepted + rejected attempts)
+    const StepStats& getStepStats() const { return m_stepStats; }
+
+    // Rendering options
+    void setShowPhotonSphere(bool show) { m_showPhotonSphere = show; }
+    void setShowAccretionDisk(bool show) { m_showAccretionDisk = show; }
+    
+    // Sub-pixel offset of the primary rays in pixels (progressive mode).
+    // Jittered frames bypass the lensing map cache.
+    void setJitter(const glm::vec2& jitter) { m_jitter = jitter; }
+    const glm::vec2& getJitter() const { return m_jitter; }
+    
+    // Animation time in seconds (orbiting disk hotspots, as in shade.comp)
+    void setTime(float time) { m_time = time; }
+    float getTime() const { return m_time; }
+
+    // Wall-clock time of the last render() call in milliseconds
+    double getLastFrameTime() const { return m_lastFrameTime; }
+
+private:
+    // Snapshot of the scene taken at the start of each frame so that
+    // worker threads never touch the live Physics objects
+    struct SceneParams {
+        glm::vec3 cameraPos;
+        glm::vec3 cameraTarget;
+        glm::vec3 cameraUp;
+        float fov;
+        float aspectRatio;
+
+        float blackHoleSpin;
+        glm::vec3 blackHolePos;
+        float schwarzschildRadius;
+
+        float diskInnerRadius;
+        float diskOuterRadius;
+        float diskRotationSpeed;
+        float time;
+    };
+
+    // Per-thread buffers for one span of pixels
+    struct RowScratch {
+        std::vector<float> dirX;
+        std::vector<float> dirY;
+        std::vector<float> dirZ;
+        std::vector<RayHit> hits;
+        std::vector<float> originX;       // Packet rays still to march (directions
+        std::vector<float> originY;       // compacted in place), where each starts
+        std::vector<float> originZ;
+        std::vector<int> marchPixel;      // and which pixel it belongs to
+        std::vector<RayHit> marchHits;
+        long long stepSum;
+        int stepMax;
+    };
+    
+    // Result of moving a camera ray onto the sphere of influence
+    enum class FarFieldEntry {
+        Inside,    // Starts inside, or must be marched from the camera
+        Entered,   // Moved onto the sphere
+        Escaped    // Never enters it; the direction is the escape direction
+    };
+
+    void traceFrame();
+    void traceSpan(int x0, int y, int count, const PacketParams& packetParams, RowScratch& scratch);
+    
+    // Lensing map cache: re-shade the frame from a stored map if possible,
+    // otherwise set recordMap to the map the trace should fill
+    bool reshadeFromLensingMap(std::shared_ptr<LensingMap>& recordMap);
+    void shadeLensingMap(const LensingMap& map, const LensingMap* other, float blend);
+    LensingMapKey makeLensingMapKey() const;
+    glm::vec4 shadeSample(const LensingSample& sample) const;
+    void recordDiskCrossing(LensingSample& sample, const glm::vec3& position) const;
+    void recordPhotonSphere(LensingSample& sample) const;
+    glm::vec3 toCanonical(const glm::vec3& v) const;
+    glm::vec3 fromCanonical(const glm::vec3& v) const;
+    PacketParams makePacketParams() const;
+    glm::vec4 shadeHit(const RayHit& hit) const;
+    glm::vec3 integrateGeodesic(const glm::vec3& pos, const glm::vec3& dir, float step, bool& absorbed) const;
+    glm::vec3 gravitationalAcceleration(const glm::vec3& pos) const;
+    void geodesicDerivative(const glm::vec3& pos, const glm::vec3& vel,
+                            glm::vec3& dPos, glm::vec3& dVel) const;
+    bool intersectDisk(const glm::vec3& origin, const glm::vec3& dir,
+                       float& t, float& radius, glm::vec2& diskCoord) const;
+    
+    // Far field outside the sphere of influence, crossed along the paths of
+    // Physics::FarFieldLaw: the model law for the fixed-step and RK45
+    // marches, Schwarzschild orbits for the Kerr one (entered from the
+    // camera's local direction, left from a coordinate direction). Spin is
+    // only corrected for to first order, so the Kerr sphere grows with it.
+    float getFarFieldRadius(Physics::FarFieldLaw law) const;
+    bool isFarFieldClear(const glm::vec3& pos, const glm::vec3& dir, float r, bool recording) const;
+    // Straight path of the given length (< 0: past the hole and out) that
+    // comes no closer to the hole than nearest
+    bool isFarFieldPathClear(const glm::vec3& pos, const glm::vec3& dir, float length, float nearest,
+                             bool recording) const;
+    bool isLeavingFarField(const glm::vec3& pos, const glm::vec3& dir, float r, bool recording) const;
+    FarFieldEntry planFarFieldEntry(const glm::vec3& pos, const glm::vec3& dir, bool recording,
+                                    Physics::FarFieldLaw law, float& radius) const;
+    FarFieldEntry enterFarField(glm::vec3& pos, glm::vec3& dir, bool recording, Physics::FarFieldLaw law) const;
+    glm::vec3 getFarFieldDirection(const glm::vec3& pos, const glm::vec3& dir, Physics::FarFieldLaw law) const;
+    // Shadow culling: inside the profile, and for a visible disk, every
+    // equatorial crossing of the Kerr geodesic falls inside its inner edge
+    bool isCulledByShadow(const glm::vec3& direction) const;
+    bool canReachDisk(const glm::vec3& direction) const;
+    glm::vec3 getDiskEmission(float radius, const glm::vec2& diskCoord) const;
+    float getDiskHotspots(float radius, float phi) const;
+    glm::vec3 sampleStarfield(const glm::vec3& dir) const;
+
+    int m_width;
+    int m_height;
+    int m_threadCount;
+    CpuScheduling m_scheduling;
+    TileScheduler m_scheduler;
+    std::vector<RowScratch> m_scratch;
+    
+    bool m_usePackets;
+    SimdLevel m_simdLevel;
+
+    int m_maxSteps;
+    float m_stepSize;
+    GeodesicIntegrator m_integrator;
+    float m_tolerance;
+    float m_influenceRadius;
+    StepStats m_stepStats;
+    bool m_useSchwarzschildFastPath;
+    Physics::SchwarzschildLensing m_lensing;
+    bool m_useShadowCulling;
+    ShadowProfile m_shadowProfile;
+    
+    LensingMapCache* m_lensingMapCache;
+    bool m_lensingMapPreview;
+    LensingMapResult m_lensingMapResult;
+    LensingSample* m_recordSamples;   // Map being filled by the current trace
+
+    bool m_showPhotonSphere;
+    bool m_showAccretionDisk;
+    float m_time;
+    glm::vec2 m_jitter;
+
+    SceneParams m_scene;
+    glm::vec3 m_forward;
+    glm::vec3 m_right;
+    glm::vec3 m_up;
+    float m_tanHalfFov;
+    float m_cameraAzimuth;            // Camera angle about the spin axis
+    glm::vec2 m_azimuthRotation;      // (cos, sin) of m_cameraAzimuth
+    std::vector<float> m_pixels;
+    double m_lastFrameTime;
+};
+
+} // namespace Rendering
@@ -0,0 +1,313 @@
+#include "EquirectImage.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <stb_image.h>
+
+namespace Rendering {
+
+namespace {
+
+bool isLittleEndian() {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+}
+
+// Next '\n'-terminated line of a mapped header, advancing pos past it
+bool readLine(const char* data, size_t size, size_t& pos, std::string& line) {
+    if (pos >= size) {
+        return false;
+    }
+    const char* start = data + pos;
+    const char* end = static_cast<const char*>(std::memchr(start, '\n', size - pos));
+    if (!end) {
+        return false;
+    }
+    line.assign(start, end);
+    pos = static_cast<size_t>(end - data) + 1;
+    return true;
+}
+
+std::string lowercaseExtension(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+} // namespace
+
+EquirectImage::EquirectImage()
+    : m_format(Format::None)
+    , m_width(0)
+    , m_height(0)
+    , m_dataOffset(0)
+    , m_swapBytes(false) {
+}
+
+bool EquirectImage::open(const std::string& path) {
+    std::string extension = lowercaseExtension(path);
+    bool opened = false;
+    if (extension == ".hdr" || extension == ".pic") {
+        opened = openRadiance(path);
+    } else if (extension == ".pfm") {
+        opened = openPfm(path);
+    } else {
+        opened = openDecoded(path);
+    }
+    if (!opened) {
+        m_format = Format::None;
+        m_file.close();
+        return false;
+    }
+
+    if (m_format != Format::Decoded) {
+        m_cache.assign(static_cast<size_t>(CACHE_ROWS) * m_width * 3, 0.0f);
+        m_cachedRow.assign(CACHE_ROWS, -1);
+    }
+    return true;
+}
+
+bool EquirectImage::openRadiance(const std::string& path) {
+    if (!m_file.open(path)) {
+        std::cerr << "Failed to open sky map: " << path << std::endl;
+        return false;
+    }
+    const char* data = static_cast<const char*>(m_file.getData());
+    size_t size = m_file.getSize();
+    size_t pos = 0;
+
+    std::string line;
+    if (!readLine(data, size, pos, line) || line.compare(0, 2, "#?") != 0) {
+        std::cerr << "Not a Radiance HDR file: " << path << std::endl;
+        return false;
+    }
+    while (readLine(data, size, pos, line) && !line.empty()) {
+        if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe") {
+            std::cerr << "Unsupported Radiance format " << line.substr(7) << ": " << path << std::endl;
+            return false;
+        }
+    }
+
+    // Only the standard orientation: top row first, left to right
+    if (!readLine(data, size, pos, line) ||
+        std::sscanf(line.c_str(), "-Y %d +X %d", &m_height, &m_width) != 2 ||
+        m_width <= 0 || m_height <= 0) {
+        std::cerr << "Unsupported Radiance resolution line '" << line << "': " << path << std::endl;
+        return false;
+    }
+
+    m_format = Format::Radiance;
+    if (!indexRadianceRows(pos)) {
+        std::cerr << "Truncated or corrupt Radiance data: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool EquirectImage::indexRadianceRows(size_t offset) {
+    // Run-length encoded scanlines have no length field, so walk the runs
+    // once to find where each one starts
+    const unsigned char* data = static_cast<const unsigned char*>(m_file.getData());
+    size_t size = m_file.getSize();
+    m_rowOffsets.resize(m_height);
+
+    size_t pos = offset;
+    for (int y = 0; y < m_height; ++y) {
+        m_rowOffsets[y] = pos;
+        if (pos + 4 <= size && data[pos] == 2 && data[pos + 1] == 2 && !(data[pos + 2] & 0x80)) {
+            if (((data[pos + 2] << 8) | data[pos + 3]) != m_width) {
+                return false;
+            }
+            pos += 4;
+            for (int channel = 0; channel < 4; ++channel) {
+                int x = 0;
+                while (x < m_width) {
+                    if (pos >= size) {
+                        return false;
+                    }
+                    int count = data[pos++];
+                    if (count > 128) {
+                        count -= 128;
+                        pos += 1;
+                    } else if (count == 0) {
+                        return false;
+                    } else {
+                        pos += count;
+                    }
+                    x += count;
+                }
+                if (x != m_width) {
+                    return false;
+                }
+            }
+        } else {
+            pos += static_cast<size_t>(m_width) * 4;   // Flat RGBE
+        }
+        if (pos > size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EquirectImage::openPfm(const std::string& path) {
+    if (!m_file.open(path)) {
+        std::cerr << "Failed to open sky map: " << path << std::endl;
+        return false;
+    }
+    const char* data = static_cast<const char*>(m_file.getData());
+    size_t size = m_file.getSize();
+    size_t pos = 0;
+
+    // "PF", "width height" and the scale, one per line as writePFM() writes them
+    std::string type, dimensions, scaleLine;
+    float scale = 0.0f;
+    if (!readLine(data, size, pos, type) || type != "PF" ||
+        !readLine(data, size, pos, dimensions) ||
+        std::sscanf(dimensions.c_str(), "%d %d", &m_width, &m_height) != 2 ||
+        !readLine(data, size, pos, scaleLine) ||
+        std::sscanf(scaleLine.c_str(), "%f", &scale) != 1 ||
+        m_width <= 0 || m_height <= 0 || scale == 0.0f) {
+        std::cerr << "Not a colour PFM file: " << path << std::endl;
+        return false;
+    }
+
+    // Negative scale marks little-endian data
+    m_dataOffset = pos;
+    m_swapBytes = (scale < 0.0f) != isLittleEndian();
+    if (size - pos < static_cast<size_t>(m_width) * m_height * 3 * sizeof(float)) {
+        std::cerr << "Truncated PFM data: " << path << std::endl;
+        return false;
+    }
+    m_format = Format::Pfm;
+    return true;
+}
+
+bool EquirectImage::openDecoded(const std::string& path) {
+    int channels = 0;
+    float* pixels = stbi_loadf(path.c_str(), &m_width, &m_height, &channels, 3);
+    if (!pixels) {
+        std::cerr << "Failed to load sky map: " << path << " (" << stbi_failure_reason() << ")" << std::endl;
+        return false;
+    }
+    m_pixels.assign(pixels, pixels + static_cast<size_t>(m_width) * m_height * 3);
+    stbi_image_free(pixels);
+    m_format = Format::Decoded;
+    return true;
+}
+
+const float* EquirectImage::getRow(int y) {
+    if (m_format == Format::Decoded) {
+        return m_pixels.data() + static_cast<size_t>(y) * m_width * 3;
+    }
+
+    int slot = y % CACHE_ROWS;
+    float* row = m_cache.data() + static_cast<size_t>(slot) * m_width * 3;
+    if (m_cachedRow[slot] != y) {
+        decodeRow(y, row);
+        m_cachedRow[slot] = y;
+    }
+    return row;
+}
+
+void EquirectImage::decodeRow(int y, float* rgb) const {
+    const unsigned char* data = static_cast<const unsigned char*>(m_file.getData());
+    if (m_format == Format::Pfm) {
+        // Bottom row first
+        const unsigned char* src = data + m_dataOffset
+                                 + static_cast<size_t>(m_height - 1 - y) * m_width * 3 * sizeof(float);
+        std::memcpy(rgb, src, static_cast<size_t>(m_width) * 3 * sizeof(float));
+        if (m_swapBytes) {
+            for (int i = 0; i < m_width * 3; ++i) {
+                uint32_t bits;
+                std::memcpy(&bits, &rgb[i], sizeof(bits));
+                bits = (bits >> 24) | ((bits >> 8) & 0xff00u) | ((bits << 8) & 0xff0000u) | (bits << 24);
+                std::memcpy(&rgb[i], &bits, sizeof(bits));
+            }
+        }
+        return;
+    }
+
+    // Radiance: gather the RGBE bytes of the scanline, then convert.
+    // Run-length encoded lines store each channel separately; reuse the
+    // output row (4 bytes per pixel fit in the 12 of the floats).
+    const unsigned char* src = data + m_rowOffsets[y];
+    unsigned char* rgbe = reinterpret_cast<unsigned char*>(rgb) + static_cast<size_t>(m_width) * 8;
+    if (src[0] == 2 && src[1] == 2 && !(src[2] & 0x80)) {
+        src += 4;
+        for (int channel = 0; channel < 4; ++channel) {
+            int x = 0;
+            while (x < m_width) {
+                int count = *src++;
+                if (count > 128) {
+                    count -= 128;
+                    for (int i = 0; i < count; ++i) {
+                        rgbe[(x + i) * 4 + channel] = *src;
+                    }
+                    ++src;
+                } else {
+                    for (int i = 0; i < count; ++i) {
+                        rgbe[(x + i) * 4 + channel] = src[i];
+                    }
+                    src += count;
+                }
+                x += count;
+            }
+        }
+    } else {
+        std::memcpy(rgbe, src, static_cast<size_t>(m_width) * 4);
+    }
+
+    // Front to back: pixel x's floats never overlap the RGBE bytes of later pixels
+    for (int x = 0; x < m_width; ++x) {
+        unsigned char e = rgbe[x * 4 + 3];
+        float f = e ? std::ldexp(1.0f, e - (128 + 8)) : 0.0f;
+        float r = rgbe[x * 4 + 0] * f;
+        float g = rgbe[x * 4 + 1] * f;
+        float b = rgbe[x * 4 + 2] * f;
+        rgb[x * 3 + 0] = r;
+        rgb[x * 3 + 1] = g;
+        rgb[x * 3 + 2] = b;
+    }
+}
+
+glm::vec3 EquirectImage::sample(float u, float v) {
+    float x = u * m_width - 0.5f;
+    float y = glm::clamp(v * m_height - 0.5f, 0.0f, float(m_height - 1));
+    float x0f = std::floor(x);
+    float fx = x - x0f;
+    int y0 = std::min(static_cast<int>(y), m_height - 1);
+    int y1 = std::min(y0 + 1, m_height - 1);
+    float fy = y - float(y0);
+
+    int x0 = static_cast<int>(x0f) % m_width;
+    if (x0 < 0) {
+        x0 += m_width;
+    }
+    int x1 = x0 + 1 == m_width ? 0 : x0 + 1;
+
+    const float* row0 = getRow(y0);
+    const float* row1 = getRow(y1);
+    glm::vec3 a = glm::mix(glm::vec3(row0[x0 * 3], row0[x0 * 3 + 1], row0[x0 * 3 + 2]),
+                           glm::vec3(row0[x1 * 3], row0[x1 * 3 + 1], row0[x1 * 3 + 2]), fx);
+    glm::vec3 b = glm::mix(glm::vec3(row1[x0 * 3], row1[x0 * 3 + 1], row1[x0 * 3 + 2]),
+                           glm::vec3(row1[x1 * 3], row1[x1 * 3 + 1], row1[x1 * 3 + 2]), fx);
+    return glm::mix(a, b, fy);
+}
+
+glm::vec3 EquirectImage::sample(const glm::vec3& dir) {
+    // Same mapping as sampleStarfield() in shade.comp: u from phi around +Y, v from the pole
+    float phi = std::atan2(dir.z, dir.x);
+    float theta = std::acos(glm::clamp(dir.y / glm::length(dir), -1.0f, 1.0f));
+    return sample(phi / glm::two_pi<float>() + 0.5f, theta / glm::pi<float>());
+}
+
+} // namespace Rendering
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../Core/MappedFile.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace Rendering {
+
+// Equirectangular sky image read a scanline at a time.
+//
+// Radiance .hdr and .pfm files are memory-mapped and decoded row by row
+// into a small direct-mapped row cache, so even 16K maps never need a
+// full-resolution copy in RAM. Other formats are decoded whole by
+// stb_image and are meant for small maps only.
+//
+// Not thread-safe: sample() fills the row cache.
+class EquirectImage {
+public:
+    EquirectImage();
+
+    EquirectImage(const EquirectImage&) = delete;
+    EquirectImage& operator=(const EquirectImage&) = delete;
+
+    // Open an image file; prints the reason and returns false on failure
+    bool open(const std::string& path);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+    // Bilinear sample; u wraps, v is clamped
+    glm::vec3 sample(float u, float v);
+
+    // Bilinear sample in the direction dir (need not be normalized)
+    glm::vec3 sample(const glm::vec3& dir);
+
+private:
+    enum class Format {
+        None,
+        Radiance,     // RGBE scanlines, flat or run-length encoded
+        Pfm,          // Float RGB, bottom row first
+        Decoded       // Whole image in m_pixels
+    };
+
+    static constexpr int CACHE_ROWS = 128;
+
+    bool openRadiance(const std::string& path);
+    bool openPfm(const std::string& path);
+    bool openDecoded(const std::string& path);
+    bool indexRadianceRows(size_t offset);
+
+    const float* getRow(int y);
+    void decodeRow(int y, float* rgb) const;
+
+    Format m_format;
+    int m_width;
+    int m_height;
+    Core::MappedFile m_file;
+    std::vector<size_t> m_rowOffsets;      // Radiance: start of each scanline
+    size_t m_dataOffset;                   // Pfm: first float
+    bool m_swapBytes;                      // Pfm: big-endian data
+    std::vector<float> m_pixels;           // Decoded: RGB, top row first
+    std::vector<float> m_cache;            // CACHE_ROWS rows of RGB
+    std::vector<int> m_cachedRow;          // Row held by each cache slot, or -1
+};
+
+} // namespace Rendering
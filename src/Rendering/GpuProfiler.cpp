@@ -0,0 +1,154 @@
+#include "GpuProfiler.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+
+namespace Rendering {
+
+GpuProfiler::GpuProfiler()
+    : m_frame(0) {
+    for (PassTimer& timer : m_passes) {
+        for (Query& query : timer.queries) {
+            glGenQueries(1, &query.id);
+        }
+        timer.history.reserve(HISTORY_SIZE);
+    }
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (PassTimer& timer : m_passes) {
+        for (Query& query : timer.queries) {
+            glDeleteQueries(1, &query.id);
+        }
+    }
+}
+
+void GpuProfiler::beginFrame() {
+    for (PassTimer& timer : m_passes) {
+        // Oldest first, so the ring and the latest result stay in frame order
+        Query* first = &timer.queries[0];
+        Query* second = &timer.queries[1];
+        if (second->frame < first->frame) {
+            std::swap(first, second);
+        }
+
+        bool updated = false;
+        for (Query* query : { first, second }) {
+            if (!query->pending) {
+                continue;
+            }
+            GLint available = 0;
+            glGetQueryObjectiv(query->id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                break;
+            }
+            readQuery(timer, *query);
+            FrameRecord& record = getFrameRecord(query->frame);
+            int pass = static_cast<int>(&timer - m_passes);
+            if (record.times.frame == query->frame) {
+                record.times.passMs[pass] = timer.stats.lastMs;
+                record.times.totalMs += timer.stats.lastMs;
+                record.resolved |= 1u << pass;
+            }
+            updated = true;
+        }
+        if (updated) {
+            updateStats(timer);
+        }
+    }
+    ++m_frame;
+    FrameRecord& record = getFrameRecord(m_frame);
+    record = FrameRecord();
+    record.times.frame = m_frame;
+}
+
+void GpuProfiler::begin(GpuPass pass) {
+    PassTimer& timer = m_passes[index(pass)];
+    Query& query = timer.queries[timer.next];
+
+    // Both queries still in flight: skip this frame rather than stall
+    FrameRecord& record = getFrameRecord(m_frame);
+    timer.active = !query.pending;
+    if (!timer.active) {
+        record.untimed |= 1u << index(pass);
+        return;
+    }
+    record.issued |= 1u << index(pass);
+    query.frame = m_frame;
+    glBeginQuery(GL_TIME_ELAPSED, query.id);
+}
+
+void GpuProfiler::end(GpuPass pass) {
+    PassTimer& timer = m_passes[index(pass)];
+    if (!timer.active) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    timer.queries[timer.next].pending = true;
+    timer.next = (timer.next + 1) % QUERIES_PER_PASS;
+    timer.active = false;
+}
+
+bool GpuProfiler::getLatest(GpuPass pass, unsigned long long& frame, double& ms) const {
+    const PassTimer& timer = m_passes[index(pass)];
+    if (timer.stats.samples == 0) {
+        return false;
+    }
+    frame = timer.latestFrame;
+    ms = timer.stats.lastMs;
+    return true;
+}
+
+bool GpuProfiler::getFrameTimes(unsigned long long frame, GpuFrameTimes& times) const {
+    const FrameRecord& record = m_frames[frame % FRAME_HISTORY];
+    if (record.times.frame != frame || record.untimed != 0 || record.resolved != record.issued) {
+        return false;
+    }
+    times = record.times;
+    return true;
+}
+
+GpuProfiler::FrameRecord& GpuProfiler::getFrameRecord(unsigned long long frame) {
+    return m_frames[frame % FRAME_HISTORY];
+}
+
+const char* GpuProfiler::getPassName(GpuPass pass) {
+    static const char* names[] = { "Ray march", "Shade", "Display", "UI" };
+    return names[index(pass)];
+}
+
+void GpuProfiler::readQuery(PassTimer& timer, Query& query) {
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed);
+    query.pending = false;
+
+    double ms = elapsed * 1e-6;
+    if (static_cast<int>(timer.history.size()) < HISTORY_SIZE) {
+        timer.history.push_back(ms);
+    } else {
+        timer.history[timer.historyNext] = ms;
+    }
+    timer.historyNext = (timer.historyNext + 1) % HISTORY_SIZE;
+    timer.latestFrame = query.frame;
+    timer.stats.lastMs = ms;
+}
+
+void GpuProfiler::updateStats(PassTimer& timer) {
+    // A few hundred values: sorting a copy is cheap enough once per frame
+    std::vector<double> sorted = timer.history;
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (double ms : sorted) {
+        sum += ms;
+    }
+
+    int count = static_cast<int>(sorted.size());
+    int p99 = std::max(0, static_cast<int>(std::ceil(0.99 * count)) - 1);
+    timer.stats.minMs = sorted.front();
+    timer.stats.avgMs = sum / count;
+    timer.stats.p99Ms = sorted[p99];
+    timer.stats.samples = count;
+}
+
+} // namespace Rendering
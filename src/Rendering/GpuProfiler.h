@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+
+namespace Rendering {
+
+// Passes of a frame timed on the GPU, in frame order
+enum class GpuPass {
+    RayMarch,   // raytracer.comp: geodesics into the G-buffer
+    Shade,      // shade.comp: disk and sky colours, accumulation
+    Display,    // display.frag: exposure, tone mapping and upsampling
+    UI,         // ImGui draw lists
+    Count
+};
+
+// Rolling statistics of one pass over the last HISTORY_SIZE results
+struct GpuPassStats {
+    double lastMs = 0.0;
+    double minMs = 0.0;
+    double avgMs = 0.0;
+    double p99Ms = 0.0;
+    int samples = 0;      // Results in the window (0 = never ran)
+};
+
+// Pass times of one frame, for per-frame analysis such as benchmarks
+struct GpuFrameTimes {
+    unsigned long long frame = 0;
+    double passMs[static_cast<int>(GpuPass::Count)] = {};
+    double totalMs = 0.0;
+};
+
+// GL_TIME_ELAPSED queries around each pass. Every pass has two query
+// objects that are read back frames later, so nothing waits on the GPU;
+// if both are still in flight the pass goes untimed for that frame.
+// Passes must not overlap, as only one elapsed-time query can be active.
+class GpuProfiler {
+public:
+    static constexpr int HISTORY_SIZE = 240;
+    static constexpr int QUERIES_PER_PASS = 2;
+    static constexpr int FRAME_HISTORY = 16;   // Frames kept for getFrameTimes()
+
+    GpuProfiler();
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // Read back finished queries and start the next frame. Call once per
+    // frame before the first begin().
+    void beginFrame();
+    void begin(GpuPass pass);
+    void end(GpuPass pass);
+
+    const GpuPassStats& getStats(GpuPass pass) const { return m_passes[index(pass)].stats; }
+
+    // Newest result of pass and the frame that issued it; false if none yet
+    bool getLatest(GpuPass pass, unsigned long long& frame, double& ms) const;
+    unsigned long long getFrame() const { return m_frame; }
+
+    // Pass times of frame once every pass it timed has been read back.
+    // False while results are outstanding, if a pass went untimed or if
+    // the frame is more than FRAME_HISTORY frames old.
+    bool getFrameTimes(unsigned long long frame, GpuFrameTimes& times) const;
+
+    static const char* getPassName(GpuPass pass);
+
+private:
+    struct Query {
+        unsigned int id = 0;
+        unsigned long long frame = 0;  // Frame the query was issued in
+        bool pending = false;
+    };
+
+    struct PassTimer {
+        Query queries[QUERIES_PER_PASS];
+        int next = 0;                  // Query the next begin() uses
+        bool active = false;           // begin() issued a query this time
+        std::vector<double> history;   // Ring of the last HISTORY_SIZE results
+        int historyNext = 0;
+        unsigned long long latestFrame = 0;
+        GpuPassStats stats;
+    };
+
+    // Which passes a frame issued, read back and could not time
+    struct FrameRecord {
+        GpuFrameTimes times;
+        unsigned int issued = 0;
+        unsigned int resolved = 0;
+        unsigned int untimed = 0;
+    };
+
+    static int index(GpuPass pass) { return static_cast<int>(pass); }
+    FrameRecord& getFrameRecord(unsigned long long frame);
+    void readQuery(PassTimer& timer, Query& query);
+    static void updateStats(PassTimer& timer);
+
+    PassTimer m_passes[static_cast<int>(GpuPass::Count)];
+    FrameRecord m_frames[FRAME_HISTORY];
+    unsigned long long m_frame;
+};
+
+} // namespace Rendering
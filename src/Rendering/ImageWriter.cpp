@@ -0,0 +1,120 @@
+#include "ImageWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+namespace Rendering {
+
+namespace {
+
+// Must match acesToneMapping() in display.frag
+float acesToneMapping(float x) {
+    const float a = 2.51f;
+    const float b = 0.03f;
+    const float c = 2.43f;
+    const float d = 0.59f;
+    const float e = 0.14f;
+
+    return std::clamp((x * (a * x + b)) / (x * (c * x + d) + e), 0.0f, 1.0f);
+}
+
+uint8_t toDisplay(float linear, float exposure) {
+    float mapped = acesToneMapping(linear * exposure);
+    mapped = std::pow(mapped, 1.0f / 2.2f);
+    return static_cast<uint8_t>(std::lround(mapped * 255.0f));
+}
+
+bool isLittleEndian() {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+}
+
+// Move a fully written temporary file into place, so that a crash mid-write
+// never leaves a truncated image under the final name
+bool replaceFile(const std::string& tempPath, const std::string& path) {
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::cerr << "Failed to store " << path << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool writePFM(const std::string& path, int width, int height, const float* rgba) {
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Failed to open " << tempPath << " for writing" << std::endl;
+            return false;
+        }
+
+        // Negative scale marks little-endian data
+        file << "PF\n" << width << " " << height << "\n" << (isLittleEndian() ? "-1.0" : "1.0") << "\n";
+
+        // PFM scanlines run bottom to top, which is already our row order
+        std::vector<float> row(static_cast<size_t>(width) * 3);
+        for (int y = 0; y < height; ++y) {
+            const float* src = rgba + static_cast<size_t>(y) * width * 4;
+            for (int x = 0; x < width; ++x) {
+                row[x * 3 + 0] = src[x * 4 + 0];
+                row[x * 3 + 1] = src[x * 4 + 1];
+                row[x * 3 + 2] = src[x * 4 + 2];
+            }
+            file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+        }
+
+        if (!file) {
+            std::cerr << "Failed to write " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    return replaceFile(tempPath, path);
+}
+
+bool writePNG(const std::string& path, int width, int height, const float* rgba, float exposure) {
+    std::vector<uint8_t> image(static_cast<size_t>(width) * height * 3);
+
+    // PNG rows run top to bottom
+    for (int y = 0; y < height; ++y) {
+        const float* src = rgba + static_cast<size_t>(height - 1 - y) * width * 4;
+        uint8_t* dst = image.data() + static_cast<size_t>(y) * width * 3;
+        for (int x = 0; x < width; ++x) {
+            dst[x * 3 + 0] = toDisplay(src[x * 4 + 0], exposure);
+            dst[x * 3 + 1] = toDisplay(src[x * 4 + 1], exposure);
+            dst[x * 3 + 2] = toDisplay(src[x * 4 + 2], exposure);
+        }
+    }
+
+    std::string tempPath = path + ".tmp";
+    if (!stbi_write_png(tempPath.c_str(), width, height, 3, image.data(), width * 3)) {
+        std::cerr << "Failed to write " << tempPath << std::endl;
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return replaceFile(tempPath, path);
+}
+
+std::string replaceExtension(const std::string& path, const std::string& extension) {
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + extension;
+    }
+    return path.substr(0, dot) + extension;
+}
+
+} // namespace Rendering
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+namespace Rendering {
+
+// Image output for headless rendering. All functions take RGBA32F pixels in
+// GL row order (first row is the bottom of the image), as produced by
+// CpuRayTracer, and return false if the file could not be written.
+
+// Portable float map: linear HDR RGB, bottom-to-top like the source buffer
+bool writePFM(const std::string& path, int width, int height, const float* rgba);
+
+// 8-bit PNG tone-mapped the same way as shaders/display.frag
+// (exposure, ACES, gamma 2.2)
+bool writePNG(const std::string& path, int width, int height, const float* rgba, float exposure);
+
+// "out/frame.pfm" + ".png" -> "out/frame.png"
+std::string replaceExtension(const std::string& path, const std::string& extension);
+
+} // namespace Rendering
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+
+namespace Rendering {
+
+// Geodesic integration scheme, shared by raytracer.comp (u_integrator) and
+// CpuRayTracer. Values match the integer constants in the shader.
+enum class GeodesicIntegrator {
+    FixedStep = 0,  // Original constant-step march (STEP_SIZE / MAX_STEPS)
+    RK45 = 1,       // Dormand-Prince 5(4) with error-controlled step size
+    Kerr = 2        // Kerr null geodesics from E, L, Q in Mino time (Physics::KerrGeodesic)
+};
+
+inline const char* getIntegratorName(GeodesicIntegrator integrator) {
+    switch (integrator) {
+        case GeodesicIntegrator::FixedStep: return "Fixed Step";
+        case GeodesicIntegrator::RK45: return "Adaptive RK45";
+        case GeodesicIntegrator::Kerr: return "Kerr Geodesic";
+        default: return "Unknown";
+    }
+}
+
+// Command line / job file spelling: "fixed", "rk45" or "kerr"
+inline bool parseIntegratorName(const std::string& name, GeodesicIntegrator& integrator) {
+    if (name == "fixed") {
+        integrator = GeodesicIntegrator::FixedStep;
+    } else if (name == "rk45") {
+        integrator = GeodesicIntegrator::RK45;
+    } else if (name == "kerr") {
+        integrator = GeodesicIntegrator::Kerr;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Sphere of influence in Schwarzschild radii: beyond it rays are propagated
+// in closed form instead of marched (0 turns that off). Large enough that
+// the closed forms stay within a few milliradians; the Kerr integrator
+// scales it by 1 + |spin|.
+constexpr float DEFAULT_INFLUENCE_RADIUS = 6.0f;
+constexpr float MIN_INFLUENCE_RADIUS = 2.0f;     // Keeps the far field outside the photon sphere
+constexpr float MAX_INFLUENCE_RADIUS = 100.0f;
+
+// Integration steps spent on the last frame
+struct StepStats {
+    double averageSteps;  // Per ray
+    int maxSteps;
+    long long totalSteps;
+};
+
+// Tracer settings of a quality level (1 = Low ... 4 = Ultra). The compute
+// shader is compiled once per level with these as #defines.
+struct QualityTier {
+    int maxSteps;              // Step limit of every integrator
+    float stepSize;            // Fixed-step march
+    float tolerance;           // Relative error tolerance of the adaptive integrators
+    int crossingIterations;    // Bisection steps locating a disk crossing
+};
+
+constexpr int QUALITY_TIER_COUNT = 4;
+
+inline QualityTier getQualityTier(int quality) {
+    switch (quality) {
+        case 1: return QualityTier{ 250, 0.15f, 1e-3f, 8 };
+        case 3: return QualityTier{ 1000, 0.05f, 1e-5f, 16 };
+        case 4: return QualityTier{ 2000, 0.02f, 1e-6f, 20 };
+        default: return QualityTier{ 500, 0.1f, 1e-4f, 12 };
+    }
+}
+
+inline float getToleranceForQuality(int quality) {
+    return getQualityTier(quality).tolerance;
+}
+
+} // namespace Rendering
@@ -0,0 +1,239 @@
+#include "LensingMapCache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace Rendering {
+
+namespace {
+
+// Map file layout: header, then width * height LensingSample records
+struct MapFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t sampleSize;
+    uint32_t reserved;
+    LensingMapKey key;
+};
+
+constexpr char MAP_FILE_MAGIC[4] = { 'B', 'H', 'L', 'M' };
+constexpr uint32_t MAP_FILE_VERSION = 2;
+
+} // namespace
+
+bool LensingMapKey::operator==(const LensingMapKey& other) const {
+    // All members are int32_t, so there is no padding to compare
+    return std::memcmp(this, &other, sizeof(LensingMapKey)) == 0;
+}
+
+bool LensingMapKey::matchesExceptSpin(const LensingMapKey& other) const {
+    LensingMapKey a = *this;
+    LensingMapKey b = other;
+    a.spin = 0;
+    b.spin = 0;
+    return a == b;
+}
+
+uint64_t LensingMapKey::hash() const {
+    // FNV-1a over the key bytes
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(this);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(LensingMapKey); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+LensingMap::LensingMap(const LensingMapKey& key)
+    : LensingMap(key, true) {
+}
+
+LensingMap::LensingMap(const LensingMapKey& key, bool allocate)
+    : m_key(key)
+    , m_samples(nullptr) {
+    if (allocate) {
+        m_storage.resize(static_cast<size_t>(key.width) * key.height);
+        m_samples = m_storage.data();
+    }
+}
+
+size_t LensingMap::getByteSize() const {
+    return static_cast<size_t>(m_key.width) * m_key.height * sizeof(LensingSample);
+}
+
+std::shared_ptr<LensingMap> LensingMap::load(const std::string& path, const LensingMapKey& key) {
+    std::shared_ptr<LensingMap> map(new LensingMap(key, false));
+    if (!map->m_file.open(path)) {
+        return nullptr;
+    }
+
+    const MapFileHeader* header = static_cast<const MapFileHeader*>(map->m_file.getData());
+    if (map->m_file.getSize() != sizeof(MapFileHeader) + map->getByteSize() ||
+        std::memcmp(header->magic, MAP_FILE_MAGIC, sizeof(MAP_FILE_MAGIC)) != 0 ||
+        header->version != MAP_FILE_VERSION ||
+        header->sampleSize != sizeof(LensingSample) ||
+        header->key != key) {
+        std::cerr << "Ignoring stale lensing map " << path << std::endl;
+        return nullptr;
+    }
+
+    map->m_samples = reinterpret_cast<const LensingSample*>(header + 1);
+    return map;
+}
+
+bool LensingMap::save(const std::string& path) const {
+    MapFileHeader header;
+    std::memcpy(header.magic, MAP_FILE_MAGIC, sizeof(MAP_FILE_MAGIC));
+    header.version = MAP_FILE_VERSION;
+    header.sampleSize = sizeof(LensingSample);
+    header.reserved = 0;
+    header.key = m_key;
+
+    // Write under a temporary name so a reader never maps a partial file
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Failed to open lensing map for writing: " << tempPath << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(m_samples), static_cast<std::streamsize>(getByteSize()));
+        if (!file) {
+            std::cerr << "Failed to write lensing map: " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::cerr << "Failed to store lensing map " << path << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+LensingMapCache::LensingMapCache(size_t memoryBudget)
+    : m_memoryBudget(memoryBudget)
+    , m_memoryUsed(0)
+    , m_hits(0)
+    , m_misses(0) {
+}
+
+bool LensingMapCache::setDirectory(const std::string& directory) {
+    m_directory = directory;
+    if (directory.empty()) {
+        return true;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        std::cerr << "Failed to create lensing cache directory " << directory << ": "
+                  << ec.message() << std::endl;
+        m_directory.clear();
+        return false;
+    }
+    return true;
+}
+
+void LensingMapCache::setMemoryBudget(size_t bytes) {
+    m_memoryBudget = bytes;
+    evict();
+}
+
+std::shared_ptr<const LensingMap> LensingMapCache::find(const LensingMapKey& key) {
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if ((*it)->getKey() == key) {
+            ++m_hits;
+            touch(it);
+            return m_entries.front();
+        }
+    }
+
+    if (!m_directory.empty()) {
+        std::shared_ptr<LensingMap> map = LensingMap::load(pathFor(key), key);
+        if (map) {
+            ++m_hits;
+            m_entries.push_front(map);
+            m_memoryUsed += map->getByteSize();
+            evict();
+            return map;
+        }
+    }
+
+    ++m_misses;
+    return nullptr;
+}
+
+void LensingMapCache::insert(const std::shared_ptr<LensingMap>& map) {
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if ((*it)->getKey() == map->getKey()) {
+            m_memoryUsed -= (*it)->getByteSize();
+            m_entries.erase(it);
+            break;
+        }
+    }
+
+    m_entries.push_front(map);
+    m_memoryUsed += map->getByteSize();
+
+    if (!m_directory.empty()) {
+        map->save(pathFor(map->getKey()));
+    }
+    evict();
+}
+
+bool LensingMapCache::findSpinNeighbors(const LensingMapKey& key,
+                                        std::shared_ptr<const LensingMap>& below,
+                                        std::shared_ptr<const LensingMap>& above) const {
+    below.reset();
+    above.reset();
+
+    for (const auto& map : m_entries) {
+        const LensingMapKey& candidate = map->getKey();
+        if (!candidate.matchesExceptSpin(key)) {
+            continue;
+        }
+        if (candidate.spin <= key.spin) {
+            if (!below || candidate.spin > below->getKey().spin) {
+                below = map;
+            }
+        } else {
+            if (!above || candidate.spin < above->getKey().spin) {
+                above = map;
+            }
+        }
+    }
+    return below || above;
+}
+
+void LensingMapCache::clear() {
+    m_entries.clear();
+    m_memoryUsed = 0;
+}
+
+void LensingMapCache::touch(std::list<std::shared_ptr<LensingMap>>::iterator entry) {
+    m_entries.splice(m_entries.begin(), m_entries, entry);
+}
+
+void LensingMapCache::evict() {
+    // Always keep the most recent map, even if it alone exceeds the budget
+    while (m_memoryUsed > m_memoryBudget && m_entries.size() > 1) {
+        m_memoryUsed -= m_entries.back()->getByteSize();
+        m_entries.pop_back();
+    }
+}
+
+std::string LensingMapCache::pathFor(const LensingMapKey& key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bhlm", static_cast<unsigned long long>(key.hash()));
+    return (std::filesystem::path(m_directory) / name).string();
+}
+
+} // namespace Rendering
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "../Core/MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Rendering {
+
+// Per-pixel result of a traced ray that does not depend on the disk radii,
+// the overlays or the display settings: where the ray crosses the disk
+// plane, when it passes the photon sphere and how it ends.
+//
+// Angles and directions are stored in the camera's canonical frame, rotated
+// about the spin axis so that the camera sits at azimuth 0. The scene is
+// symmetric about that axis, so one map serves every camera azimuth.
+struct LensingSample {
+    static constexpr int MAX_CROSSINGS = 3;
+
+    float crossingRadius[MAX_CROSSINGS];  // Disk-plane crossings in ray order
+    float crossingPhi[MAX_CROSSINGS];
+    float direction[3];                   // Final ray direction (escape direction)
+    int32_t crossingCount;
+    int32_t photonSphereCrossings;        // Crossings before the photon sphere shell, -1 if never reached
+    int32_t type;                         // RayHitType at the end of the ray
+};
+
+// Quantized camera and tracer state a lensing map was traced for.
+// Two frames with equal keys share the map; the azimuth of the camera
+// about the spin axis is deliberately not part of it.
+struct LensingMapKey {
+    int32_t width;
+    int32_t height;
+    int32_t integrator;
+    int32_t maxSteps;
+    int32_t stepSize;
+    int32_t tolerance;
+    int32_t fastPath;
+    int32_t influenceRadius;
+    int32_t mass;
+    int32_t spin;
+    int32_t distance;
+    int32_t inclination;
+    int32_t fov;
+    int32_t forward[3];
+    int32_t up[3];
+
+    // Quantization steps used to build the key
+    static constexpr float SPIN_STEP = 1e-3f;
+    static constexpr float LOG_STEP = 1e-4f;        // Mass, distance, tolerance and step size (log scale)
+    static constexpr float ANGLE_STEP = 1e-4f;      // Inclination in radians
+    static constexpr float FOV_STEP = 1e-2f;        // Degrees
+    static constexpr float INFLUENCE_STEP = 1e-2f;  // Schwarzschild radii
+    static constexpr float DIRECTION_STEP = 1e-4f;  // Camera basis components
+
+    float getSpin() const { return spin * SPIN_STEP; }
+
+    bool operator==(const LensingMapKey& other) const;
+    bool operator!=(const LensingMapKey& other) const { return !(*this == other); }
+
+    // Equal apart from the spin (candidates for interpolated previews)
+    bool matchesExceptSpin(const LensingMapKey& other) const;
+
+    uint64_t hash() const;
+};
+
+// Lensing map of one frame, owned in memory or mapped from the disk store
+class LensingMap {
+public:
+    explicit LensingMap(const LensingMapKey& key);
+
+    // Map a file written by save(). Returns nullptr if it is missing,
+    // truncated or was written for a different key.
+    static std::shared_ptr<LensingMap> load(const std::string& path, const LensingMapKey& key);
+    bool save(const std::string& path) const;
+
+    const LensingMapKey& getKey() const { return m_key; }
+    int getWidth() const { return m_key.width; }
+    int getHeight() const { return m_key.height; }
+    size_t getByteSize() const;
+
+    // Row-major samples, first row is the bottom of the image
+    const LensingSample* getSamples() const { return m_samples; }
+    LensingSample* getMutableSamples() { return m_storage.data(); }
+
+private:
+    LensingMap(const LensingMapKey& key, bool allocate);
+
+    LensingMapKey m_key;
+    std::vector<LensingSample> m_storage;
+    Core::MappedFile m_file;
+    const LensingSample* m_samples;
+};
+
+// Least-recently-used set of lensing maps with an optional directory of
+// memory-mapped map files behind it.
+class LensingMapCache {
+public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = size_t(512) << 20;
+
+    explicit LensingMapCache(size_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+
+    // Directory of the disk store (created if needed); empty = memory only
+    bool setDirectory(const std::string& directory);
+    const std::string& getDirectory() const { return m_directory; }
+
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const { return m_memoryBudget; }
+
+    // Map for key from memory, else from the disk store, else nullptr
+    std::shared_ptr<const LensingMap> find(const LensingMapKey& key);
+
+    // Add a freshly traced map (and write it to the disk store)
+    void insert(const std::shared_ptr<LensingMap>& map);
+
+    // In-memory maps that only differ by spin, nearest below and above the
+    // spin of key. Returns false if neither exists.
+    bool findSpinNeighbors(const LensingMapKey& key,
+                           std::shared_ptr<const LensingMap>& below,
+                           std::shared_ptr<const LensingMap>& above) const;
+
+    void clear();
+
+    size_t getMapCount() const { return m_entries.size(); }
+    size_t getMemoryUsed() const { return m_memoryUsed; }
+    long long getHits() const { return m_hits; }
+    long long getMisses() const { return m_misses; }
+
+private:
+    void touch(std::list<std::shared_ptr<LensingMap>>::iterator entry);
+    void evict();
+    std::string pathFor(const LensingMapKey& key) const;
+
+    // Most recently used first. Only a handful of full-frame maps fit in
+    // the budget, so a linear search is all the lookup needs.
+    std::list<std::shared_ptr<LensingMap>> m_entries;
+    size_t m_memoryBudget;
+    size_t m_memoryUsed;
+    std::string m_directory;
+    long long m_hits;
+    long long m_misses;
+};
+
+} // namespace Rendering
@@ -0,0 +1,116 @@
+#include "OfflineRenderer.h"
+#include "ImageWriter.h"
+#include "../Core/Camera.h"
+#include "../Core/CommandLine.h"
+#include "../Physics/BlackHole.h"
+#include "../Physics/AccretionDisk.h"
+#include <iostream>
+
+namespace Rendering {
+
+namespace {
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+OfflineRenderer::OfflineRenderer(int width, int height)
+    : m_tracer(width, height)
+    , m_exposure(1.0f) {
+}
+
+void OfflineRenderer::configure(const Core::LaunchOptions& options) {
+    m_tracer.setThreadCount(options.threads);
+    m_tracer.setMaxSteps(options.maxSteps);
+    m_tracer.setStepSize(options.stepSize);
+    GeodesicIntegrator integrator = GeodesicIntegrator::Kerr;
+    parseIntegratorName(options.integrator, integrator);
+    m_tracer.setIntegrator(integrator);
+    m_tracer.setTolerance(options.tolerance);
+    m_tracer.setInfluenceRadius(options.influenceRadius);
+    m_tracer.setShowAccretionDisk(options.showAccretionDisk);
+    m_tracer.setShowPhotonSphere(options.showPhotonSphere);
+    m_exposure = options.exposure;
+    
+    // Batch frames that only differ in disk or display settings re-shade
+    // the stored lensing map; a cache directory also shares maps across runs
+    if (options.mode == Core::RunMode::Batch || !options.lensingCacheDir.empty()) {
+        if (options.lensingCacheDir != m_lensingMapCache.getDirectory()) {
+            m_lensingMapCache.setDirectory(options.lensingCacheDir);
+        }
+        m_tracer.setLensingMapCache(&m_lensingMapCache);
+    } else {
+        m_tracer.setLensingMapCache(nullptr);
+    }
+}
+
+void OfflineRenderer::render(const Core::Camera& camera,
+                             const Physics::BlackHole& blackHole,
+                             const Physics::AccretionDisk& disk) {
+    m_tracer.render(camera, blackHole, disk);
+}
+
+void OfflineRenderer::renderScene(const Core::LaunchOptions& options) {
+    Core::Camera camera(options.cameraPosition, options.cameraTarget, options.fov);
+
+    Physics::BlackHole blackHole(options.mass, options.spin);
+    Physics::AccretionDisk disk(&blackHole);
+    if (options.diskInnerRadius > 0.0f) {
+        disk.setInnerRadius(options.diskInnerRadius);
+    }
+    if (options.diskOuterRadius > 0.0f) {
+        disk.setOuterRadius(options.diskOuterRadius);
+    }
+
+    render(camera, blackHole, disk);
+}
+
+bool OfflineRenderer::save(const std::string& path) const {
+    const float* pixels = m_tracer.getPixels().data();
+    int width = m_tracer.getWidth();
+    int height = m_tracer.getHeight();
+
+    bool ok = writePFM(replaceExtension(path, ".pfm"), width, height, pixels);
+    ok = writePNG(replaceExtension(path, ".png"), width, height, pixels, m_exposure) && ok;
+    return ok;
+}
+
+int runOfflineRender(const Core::LaunchOptions& options,
+                     std::chrono::steady_clock::time_point processStart) {
+    OfflineRenderer renderer(options.width, options.height);
+    renderer.configure(options);
+
+    double startupMs = millisecondsSince(processStart);
+
+    renderer.renderScene(options);
+
+    // The CPU tracer hands over the whole frame at once, so the first pixel
+    // is available as soon as the trace finishes
+    double firstPixelMs = millisecondsSince(processStart);
+
+    auto writeStart = std::chrono::steady_clock::now();
+    if (!renderer.save(options.outputPath)) {
+        return -1;
+    }
+    double writeMs = millisecondsSince(writeStart);
+
+    const CpuRayTracer& tracer = renderer.getTracer();
+    std::cout << "Rendered " << options.width << "x" << options.height
+              << " on " << tracer.getThreadCount() << " threads ("
+              << getSimdLevelName(tracer.getSimdLevel()) << ")" << std::endl;
+    std::cout << "  Startup:        " << startupMs << " ms" << std::endl;
+    std::cout << "  Trace:          " << tracer.getLastFrameTime() << " ms" << std::endl;
+    std::cout << "  Steps/ray:      " << tracer.getStepStats().averageSteps << " avg, "
+              << tracer.getStepStats().maxSteps << " max ("
+              << getIntegratorName(tracer.getIntegrator()) << ")" << std::endl;
+    std::cout << "  First pixel at: " << firstPixelMs << " ms after launch" << std::endl;
+    std::cout << "  Write:          " << writeMs << " ms" << std::endl;
+    std::cout << "  Output:         " << replaceExtension(options.outputPath, ".pfm") << ", "
+              << replaceExtension(options.outputPath, ".png") << std::endl;
+
+    return 0;
+}
+
+} // namespace Rendering
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CpuRayTracer.h"
+#include "LensingMapCache.h"
+#include <chrono>
+#include <string>
+
+namespace Core {
+    struct LaunchOptions;
+}
+
+namespace Rendering {
+
+// Window-less frame renderer for batch nodes.
+// Traces frames with CpuRayTracer and writes them to disk; never touches
+// GLFW, OpenGL, ImGui or the sky map.
+class OfflineRenderer {
+public:
+    OfflineRenderer(int width, int height);
+
+    // Copy tracer settings (threads, steps, overlays) from the command line
+    void configure(const Core::LaunchOptions& options);
+
+    // Trace one frame
+    void render(const Core::Camera& camera,
+                const Physics::BlackHole& blackHole,
+                const Physics::AccretionDisk& disk);
+    
+    // Build the camera, black hole and disk described by options and trace them
+    void renderScene(const Core::LaunchOptions& options);
+
+    // Write the last frame as <path>.pfm (HDR) and <path>.png (tone-mapped)
+    bool save(const std::string& path) const;
+
+    void setExposure(float exposure) { m_exposure = exposure; }
+    float getExposure() const { return m_exposure; }
+
+    CpuRayTracer& getTracer() { return m_tracer; }
+    const CpuRayTracer& getTracer() const { return m_tracer; }
+
+private:
+    CpuRayTracer m_tracer;
+    LensingMapCache m_lensingMapCache;
+    float m_exposure;
+};
+
+// Headless entry point used by main(): render options.outputPath and exit.
+// processStart is used to report startup-to-first-pixel latency.
+int runOfflineRender(const Core::LaunchOptions& options,
+                     std::chrono::steady_clock::time_point processStart);
+
+} // namespace Rendering
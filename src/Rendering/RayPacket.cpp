@@ -0,0 +1,166 @@
+#include "RayPacket.h"
+#include "RayPacketKernel.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(BH_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Rendering {
+
+namespace {
+
+bool cpuSupports(SimdLevel level) {
+    if (level == SimdLevel::Scalar) {
+        return true;
+    }
+
+#if defined(BH_SIMD_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+
+    // The OS must save YMM/ZMM state for AVX registers to be usable
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool ymmState = (xcr0 & 0x6) == 0x6;
+    bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+    bool avx2 = false;
+    bool avx512f = false;
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+        avx512f = (info[1] & (1 << 16)) != 0;
+    }
+
+    switch (level) {
+        case SimdLevel::SSE: return sse2;
+        case SimdLevel::AVX2: return avx2 && ymmState;
+        case SimdLevel::AVX512: return avx512f && zmmState;
+        default: return false;
+    }
+#else
+    __builtin_cpu_init();
+    switch (level) {
+        case SimdLevel::SSE: return __builtin_cpu_supports("sse2");
+        case SimdLevel::AVX2: return __builtin_cpu_supports("avx2");
+        case SimdLevel::AVX512: return __builtin_cpu_supports("avx512f");
+        default: return false;
+    }
+#endif
+#else
+    return false;
+#endif
+}
+
+detail::PacketConstants makeConstants(const PacketParams& params) {
+    detail::PacketConstants c;
+
+    float Rs = params.schwarzschildRadius;
+    float M = Rs * 0.5f;
+    float a = params.blackHoleSpin * M;
+    float eventHorizon = M + std::sqrt(std::max(M * M - a * a, 0.01f));
+
+    c.holeX = params.blackHolePos.x;
+    c.holeY = params.blackHolePos.y;
+    c.holeZ = params.blackHolePos.z;
+    c.absorbRadius = eventHorizon * 1.1f;
+    c.halfRs = Rs * 0.5f;
+    c.grCoefficient = 1.5f * Rs;
+    c.twoMa = 2.0f * M * a;
+    c.a2 = a * a;
+    c.twoMa2 = 2.0f * M * c.a2;
+    c.spinSign = params.blackHoleSpin > 0.0f ? 1.0f : -1.0f;
+    c.absSpin = std::abs(params.blackHoleSpin);
+    c.schwarzschildRadius = Rs;
+    c.photonSphereRadius = Rs * 1.5f;
+    c.diskInnerRadius = params.diskInnerRadius;
+    c.diskOuterRadius = params.diskOuterRadius;
+    c.maxDistance = params.maxDistance;
+    c.influenceRadius = params.influenceRadius;
+    c.farFieldBend = params.farFieldBend;
+    c.stepSize = params.stepSize;
+    c.maxSteps = params.maxSteps;
+    c.frameDragging = std::abs(params.blackHoleSpin) > 0.01f;
+    c.showAccretionDisk = params.showAccretionDisk;
+    c.showPhotonSphere = params.showPhotonSphere;
+
+    return c;
+}
+
+} // namespace
+
+bool isSimdLevelSupported(SimdLevel level) {
+    return cpuSupports(level);
+}
+
+SimdLevel detectSimdLevel() {
+    static const SimdLevel detected = [] {
+        if (cpuSupports(SimdLevel::AVX512)) return SimdLevel::AVX512;
+        if (cpuSupports(SimdLevel::AVX2)) return SimdLevel::AVX2;
+        if (cpuSupports(SimdLevel::SSE)) return SimdLevel::SSE;
+        return SimdLevel::Scalar;
+    }();
+    return detected;
+}
+
+const char* getSimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar: return "Scalar";
+        case SimdLevel::SSE: return "SSE2";
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::AVX512: return "AVX-512";
+        default: return "Unknown";
+    }
+}
+
+int getPacketWidth(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SSE: return 4;
+        case SimdLevel::AVX2: return 8;
+        case SimdLevel::AVX512: return 16;
+        default: return 1;
+    }
+}
+
+void tracePackets(SimdLevel level, const PacketParams& params,
+                  const float* originX, const float* originY, const float* originZ,
+                  const float* dirX, const float* dirY, const float* dirZ,
+                  int count, RayHit* hits) {
+    if (count <= 0) {
+        return;
+    }
+
+    detail::PacketConstants c = makeConstants(params);
+    detail::PacketRays rays = { originX, originY, originZ, dirX, dirY, dirZ };
+
+    // Never run code the CPU cannot execute
+    if (!cpuSupports(level)) {
+        level = detectSimdLevel();
+    }
+
+    switch (level) {
+#if defined(BH_SIMD_X86)
+        case SimdLevel::AVX512:
+            detail::tracePacketsAVX512(c, rays, count, hits);
+            break;
+        case SimdLevel::AVX2:
+            detail::tracePacketsAVX2(c, rays, count, hits);
+            break;
+        case SimdLevel::SSE:
+            detail::tracePacketsSSE(c, rays, count, hits);
+            break;
+#endif
+        default:
+            detail::tracePacketsScalar(c, rays, count, hits);
+            break;
+    }
+}
+
+} // namespace Rendering
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Rendering {
+
+// How a marched ray terminated
+enum class RayHitType : int {
+    None = 0,          // Ran out of steps
+    Disk = 1,          // Hit the accretion disk (position = hit point)
+    Absorbed = 2,      // Fell into the event horizon
+    Escaped = 3,       // Left the scene (direction = final direction)
+    PhotonSphere = 4   // Crossed the photon sphere indicator
+};
+
+// Result of marching a single ray, shaded afterwards by CpuRayTracer
+struct RayHit {
+    RayHitType type;
+    glm::vec3 position;   // Disk hit point
+    glm::vec3 direction;  // Final ray direction
+    int steps;            // Integration steps taken
+};
+
+// Per-frame constants shared by every ray in a packet
+struct PacketParams {
+    glm::vec3 blackHolePos;
+    float schwarzschildRadius;
+    float blackHoleSpin;
+    float diskInnerRadius;
+    float diskOuterRadius;
+    float maxDistance;
+    float influenceRadius;      // Outbound rays beyond it stop marching (FLT_MAX = off)
+    float farFieldBend;         // Bending still ahead of such a ray at r is below farFieldBend / r
+    float stepSize;
+    int maxSteps;
+    bool showAccretionDisk;
+    bool showPhotonSphere;
+};
+
+// Instruction sets the packet kernel is compiled for
+enum class SimdLevel {
+    Scalar = 0,   // 1 lane, portable fallback
+    SSE = 1,      // 4 lanes
+    AVX2 = 2,     // 8 lanes
+    AVX512 = 3    // 16 lanes
+};
+
+// Best instruction set supported by both this build and the running CPU
+SimdLevel detectSimdLevel();
+bool isSimdLevelSupported(SimdLevel level);
+const char* getSimdLevelName(SimdLevel level);
+int getPacketWidth(SimdLevel level);
+
+// March `count` rays through the geodesic integrator, stepping one packet
+// of rays per iteration. Origins and directions are given in SoA layout.
+// Every level produces bit-identical results.
+void tracePackets(SimdLevel level, const PacketParams& params,
+                  const float* originX, const float* originY, const float* originZ,
+                  const float* dirX, const float* dirY, const float* dirZ,
+                  int count, RayHit* hits);
+
+} // namespace Rendering
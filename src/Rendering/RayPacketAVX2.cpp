@@ -0,0 +1,12 @@
+// Ray packet kernel: AVX2, 8 rays per packet
+#include "RayPacketKernel.inl"
+
+namespace Rendering {
+namespace detail {
+
+void tracePacketsAVX2(const PacketConstants& c, const PacketRays& rays, int count, RayHit* hits) {
+    Simd::tracePacketKernel<Simd::Float8>(c, rays, count, hits);
+}
+
+} // namespace detail
+} // namespace Rendering
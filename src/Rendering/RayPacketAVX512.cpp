@@ -0,0 +1,12 @@
+// Ray packet kernel: AVX-512F, 16 rays per packet
+#include "RayPacketKernel.inl"
+
+namespace Rendering {
+namespace detail {
+
+void tracePacketsAVX512(const PacketConstants& c, const PacketRays& rays, int count, RayHit* hits) {
+    Simd::tracePacketKernel<Simd::Float16>(c, rays, count, hits);
+}
+
+} // namespace detail
+} // namespace Rendering
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "RayPacket.h"
+
+namespace Rendering {
+namespace detail {
+
+// Scalar constants derived from PacketParams once per call, so that the
+// ISA-specific translation units never call into shared inline library code
+struct PacketConstants {
+    float holeX, holeY, holeZ;
+    float absorbRadius;       // eventHorizon * 1.1
+    float halfRs;             // Rs * 0.5
+    float grCoefficient;      // 1.5 * Rs
+    float twoMa;              // 2 * M * a
+    float a2;                 // a * a
+    float twoMa2;             // 2 * M * a^2
+    float spinSign;           // Direction of the spin axis along y
+    float absSpin;
+    float schwarzschildRadius;
+    float photonSphereRadius;
+    float diskInnerRadius;
+    float diskOuterRadius;
+    float maxDistance;
+    float influenceRadius;
+    float farFieldBend;
+    float stepSize;
+    int maxSteps;
+    bool frameDragging;
+    bool showAccretionDisk;
+    bool showPhotonSphere;
+};
+
+// Arrays of one call, in SoA layout
+struct PacketRays {
+    const float* originX;
+    const float* originY;
+    const float* originZ;
+    const float* dirX;
+    const float* dirY;
+    const float* dirZ;
+};
+
+// One entry point per instruction set, each defined in its own translation
+// unit compiled with the matching compiler flags
+void tracePacketsScalar(const PacketConstants& c, const PacketRays& rays, int count, RayHit* hits);
+void tracePacketsSSE(const PacketConstants& c, const PacketRays& rays, int count, RayHit* hits);
+void tracePacketsAVX2(const PacketConstants& c, const PacketRays& rays, int count, RayHit* hits);
+void tracePacketsAVX512(const PacketConstants& c, const PacketRays& rays, int count, RayHit* hits);
+
+} // namespace detail
+} // namespace Rendering
@@ -0,0 +1,217 @@
+// Packet version of CpuRayTracer's ray march, instantiated once per
+// instruction set by RayPacketScalar/SSE/AVX2/AVX512.cpp.
+//
+// Every arithmetic operation mirrors the scalar code in CpuRayTracer
+// (including glm's normalize = v * (1 / sqrt(dot(v, v))) and the operand
+// order of each expression) so that all widths produce bit-identical hits.
+// Kernel translation units are built with floating-point contraction
+// disabled for the same reason.
+
+#include "RayPacketKernel.h"
+#include "SimdPack.h"
+
+namespace Rendering {
+namespace Simd {
+namespace {
+
+template<typename F, typename M>
+inline void recordHits(int mask, RayHitType type, int steps, int base, int count,
+                       F px, F py, F pz, F dx, F dy, F dz, RayHit* hits) {
+    constexpr int W = F::Width;
+    float lpx[W], lpy[W], lpz[W], ldx[W], ldy[W], ldz[W];
+    store(lpx, px); store(lpy, py); store(lpz, pz);
+    store(ldx, dx); store(ldy, dy); store(ldz, dz);
+
+    for (int lane = 0; lane < W; ++lane) {
+        if (!(mask & (1 << lane)) || base + lane >= count) {
+            continue;
+        }
+        RayHit& hit = hits[base + lane];
+        hit.type = type;
+        hit.position.x = lpx[lane];
+        hit.position.y = lpy[lane];
+        hit.position.z = lpz[lane];
+        hit.direction.x = ldx[lane];
+        hit.direction.y = ldy[lane];
+        hit.direction.z = ldz[lane];
+        hit.steps = steps;
+    }
+}
+
+template<typename F>
+void tracePacketKernel(const detail::PacketConstants& c, const detail::PacketRays& rays,
+                       int count, RayHit* hits) {
+    using M = decltype(F{} < F{});
+    constexpr int W = F::Width;
+
+    const F zero = broadcast(0.0f, F{});
+    const F one = broadcast(1.0f, F{});
+    const F holeX = broadcast(c.holeX, F{});
+    const F holeY = broadcast(c.holeY, F{});
+    const F holeZ = broadcast(c.holeZ, F{});
+    const F absorbRadius = broadcast(c.absorbRadius, F{});
+    const F halfRs = broadcast(c.halfRs, F{});
+    const F grCoefficient = broadcast(c.grCoefficient, F{});
+    const F twoMa = broadcast(c.twoMa, F{});
+    const F a2 = broadcast(c.a2, F{});
+    const F twoMa2 = broadcast(c.twoMa2, F{});
+    const F spinSign = broadcast(c.spinSign, F{});
+    const F absSpin = broadcast(c.absSpin, F{});
+    const F rs = broadcast(c.schwarzschildRadius, F{});
+    const F photonRadius = broadcast(c.photonSphereRadius, F{});
+    const F photonWidth = broadcast(0.1f, F{});
+    const F innerRadius = broadcast(c.diskInnerRadius, F{});
+    const F outerRadius = broadcast(c.diskOuterRadius, F{});
+    const F maxDistance = broadcast(c.maxDistance, F{});
+    const F influenceRadius = broadcast(c.influenceRadius, F{});
+    const F farFieldBend = broadcast(c.farFieldBend, F{});
+    const F step = broadcast(c.stepSize, F{});
+    const F diskWindow = broadcast(c.stepSize * 2.0f, F{});
+    const F parallelEpsilon = broadcast(1e-6f, F{});
+
+    for (int base = 0; base < count; base += W) {
+        // Gather rays, padding the tail packet with the last one
+        float lox[W], loy[W], loz[W], lx[W], ly[W], lz[W];
+        for (int lane = 0; lane < W; ++lane) {
+            int index = base + lane < count ? base + lane : count - 1;
+            lox[lane] = rays.originX[index];
+            loy[lane] = rays.originY[index];
+            loz[lane] = rays.originZ[index];
+            lx[lane] = rays.dirX[index];
+            ly[lane] = rays.dirY[index];
+            lz[lane] = rays.dirZ[index];
+        }
+
+        F dx = load(lx, F{});
+        F dy = load(ly, F{});
+        F dz = load(lz, F{});
+        F px = load(lox, F{});
+        F py = load(loy, F{});
+        F pz = load(loz, F{});
+
+        M active = allTrue(F{});
+        int stepIndex = 0;
+
+        for (; stepIndex < c.maxSteps && bits(active); ++stepIndex) {
+            // Accretion disk intersection (plane y = 0) within the next two steps
+            if (c.showAccretionDisk) {
+                M notParallel = abs(dy) >= parallelEpsilon;
+                F t = (-py) / dy;
+                M candidate = active & notParallel & (t >= zero) & (t < diskWindow);
+
+                if (bits(candidate)) {
+                    F hx = px + t * dx;
+                    F hy = py + t * dy;
+                    F hz = pz + t * dz;
+                    F radius = sqrt(hx * hx + hz * hz);
+                    M diskHit = candidate & (radius >= innerRadius) & (radius <= outerRadius);
+
+                    int mask = bits(diskHit);
+                    if (mask) {
+                        recordHits<F, M>(mask, RayHitType::Disk, stepIndex, base, count,
+                                         hx, hy, hz, dx, dy, dz, hits);
+                        active = andNot(active, diskHit);
+                    }
+                }
+            }
+
+            // Geodesic integration
+            F rx = px - holeX;
+            F ry = py - holeY;
+            F rz = pz - holeZ;
+            F r = sqrt(rx * rx + ry * ry + rz * rz);
+
+            M absorbed = active & (r < absorbRadius);
+            int absorbedMask = bits(absorbed);
+            if (absorbedMask) {
+                recordHits<F, M>(absorbedMask, RayHitType::Absorbed, stepIndex, base, count,
+                                 px, py, pz, dx, dy, dz, hits);
+                active = andNot(active, absorbed);
+            }
+
+            F invR = one / r;
+            F tcx = rx * invR;
+            F tcy = ry * invR;
+            F tcz = rz * invR;
+
+            F factor = one / (r * r);
+            F grCorrection = one + grCoefficient / r;
+
+            F ax = (((-tcx) * halfRs) * factor) * grCorrection;
+            F ay = (((-tcy) * halfRs) * factor) * grCorrection;
+            F az = (((-tcz) * halfRs) * factor) * grCorrection;
+
+            if (c.frameDragging) {
+                F r2 = r * r;
+                F omega = (twoMa * r) / (r2 * r + a2 * r + twoMa2);
+                F dragStrength = (omega * rs) / r;
+
+                // cross((0, sign, 0), toCenter), spelled out as glm evaluates it
+                F tx = spinSign * tcz - tcy * zero;
+                F ty = zero * tcx - tcz * zero;
+                F tz = zero * tcy - tcx * spinSign;
+
+                ax = ax + (tx * dragStrength) * absSpin;
+                ay = ay + (ty * dragStrength) * absSpin;
+                az = az + (tz * dragStrength) * absSpin;
+            }
+
+            F vx = dx + ax * step;
+            F vy = dy + ay * step;
+            F vz = dz + az * step;
+            F invLength = one / sqrt(vx * vx + vy * vy + vz * vz);
+
+            dx = select(active, vx * invLength, dx);
+            dy = select(active, vy * invLength, dy);
+            dz = select(active, vz * invLength, dz);
+
+            px = select(active, px + dx * step, px);
+            py = select(active, py + dy * step, py);
+            pz = select(active, pz + dz * step, pz);
+
+            // Escape test: past the maximum distance, or outbound beyond the
+            // sphere of influence where the disk can no longer be reached:
+            // past its edge, or leaving its plane faster than the remaining
+            // bending could turn the ray back
+            F ex = px - holeX;
+            F ey = py - holeY;
+            F ez = pz - holeZ;
+            F distance = sqrt(ex * ex + ey * ey + ez * ez);
+
+            M escaped = active & (distance > maxDistance);
+            M outbound = active & (distance >= influenceRadius) & (ex * dx + ey * dy + ez * dz > zero);
+            if (c.showAccretionDisk && bits(outbound)) {
+                outbound = outbound & ((distance >= outerRadius) |
+                                       (py * dy * distance > abs(py) * farFieldBend));
+            }
+            escaped = escaped | outbound;
+            int escapedMask = bits(escaped);
+            if (escapedMask) {
+                recordHits<F, M>(escapedMask, RayHitType::Escaped, stepIndex + 1, base, count,
+                                 px, py, pz, dx, dy, dz, hits);
+                active = andNot(active, escaped);
+            }
+
+            if (c.showPhotonSphere) {
+                M onSphere = active & (abs(distance - photonRadius) < photonWidth);
+                int sphereMask = bits(onSphere);
+                if (sphereMask) {
+                    recordHits<F, M>(sphereMask, RayHitType::PhotonSphere, stepIndex + 1, base, count,
+                                     px, py, pz, dx, dy, dz, hits);
+                    active = andNot(active, onSphere);
+                }
+            }
+        }
+
+        // Rays that used up the step budget
+        int remaining = bits(active);
+        if (remaining) {
+            recordHits<F, M>(remaining, RayHitType::None, stepIndex, base, count,
+                             px, py, pz, dx, dy, dz, hits);
+        }
+    }
+}
+
+} // namespace
+} // namespace Simd
+} // namespace Rendering
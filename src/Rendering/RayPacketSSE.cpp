@@ -0,0 +1,12 @@
+// Ray packet kernel: SSE2, 4 rays per packet
+#include "RayPacketKernel.inl"
+
+namespace Rendering {
+namespace detail {
+
+void tracePacketsSSE(const PacketConstants& c, const PacketRays& rays, int count, RayHit* hits) {
+    Simd::tracePacketKernel<Simd::Float4>(c, rays, count, hits);
+}
+
+} // namespace detail
+} // namespace Rendering
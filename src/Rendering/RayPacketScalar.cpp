@@ -0,0 +1,12 @@
+// Ray packet kernel: scalar fallback, built without extra instruction set flags
+#include "RayPacketKernel.inl"
+
+namespace Rendering {
+namespace detail {
+
+void tracePacketsScalar(const PacketConstants& c, const PacketRays& rays, int count, RayHit* hits) {
+    Simd::tracePacketKernel<Simd::Float1>(c, rays, count, hits);
+}
+
+} // namespace detail
+} // namespace Rendering
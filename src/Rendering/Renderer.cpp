@@ -1,16 +1,95 @@
 #include "Renderer.h"
 #include "Texture.h"
 #include "PostProcess.h"
+#include "CpuRayTracer.h"
+#include "LensingMapCache.h"
+#include "GpuProfiler.h"
+#include "UniformBuffer.h"
+#include "SkyMap.h"
+#include "ShadowProfile.h"
 #include "../Core/Shader.h"
+#include "../Core/Profiler.h"
 #include "../Core/Camera.h"
 #include "../Physics/BlackHole.h"
 #include "../Physics/AccretionDisk.h"
+#include "../Physics/SchwarzschildLensing.h"
+#include "../Physics/Constants.h"
+#include "../Physics/EmissionTables.h"
 #include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
-#include <random>
 
 namespace Rendering {
 
+namespace {
+
+// Sub-pixel offset of sample index in [-0.5, 0.5)^2 from the R2
+// low-discrepancy sequence. Sample 0 is the pixel itself.
+glm::vec2 sampleJitter(int index) {
+    const float a1 = 0.7548776662f;   // 1 / g and 1 / g^2, g = plastic number
+    const float a2 = 0.5698402910f;
+    return glm::vec2(glm::fract(0.5f + a1 * index), glm::fract(0.5f + a2 * index)) - 0.5f;
+}
+
+// Dynamic resolution limits. The scale moves in whole steps so the render
+// targets (and CPU lensing map keys) are not re-created every frame.
+constexpr float MIN_RENDER_SCALE = 0.25f;
+constexpr float RENDER_SCALE_STEP = 1.0f / 16.0f;
+constexpr float INTERACTION_RENDER_SCALE = 0.5f;
+
+// std140 mirror of the TraceParams uniform block in raytracer.comp. GLSL
+// bools are 4 bytes in std140; vec3s pack with the float after them.
+constexpr unsigned int TRACE_PARAMS_BINDING = 0;
+
+struct TraceParamsBlock {
+    glm::vec3 cameraPos;
+    float fov;
+    glm::vec3 cameraTarget;
+    float aspectRatio;
+    glm::vec3 cameraUp;
+    float blackHoleMass;
+    glm::vec3 blackHolePos;
+    float blackHoleSpin;
+    glm::vec2 jitter;
+    float schwarzschildRadius;
+    float diskInnerRadius;
+    float diskOuterRadius;
+    float diskThickness;
+    float lensCriticalAngle;
+    int32_t integrator;
+    uint32_t useLensingTable;
+    uint32_t showAccretionDisk;
+    uint32_t showEventHorizon;
+    uint32_t showPhotonSphere;
+    float influenceRadius;
+    uint32_t useShadowProfile;
+    glm::vec2 shadowCenter;
+};
+static_assert(sizeof(TraceParamsBlock) == 128, "TraceParamsBlock must match the std140 layout");
+static_assert(offsetof(TraceParamsBlock, jitter) == 64, "TraceParamsBlock must match the std140 layout");
+static_assert(offsetof(TraceParamsBlock, showPhotonSphere) == 108, "TraceParamsBlock must match the std140 layout");
+static_assert(offsetof(TraceParamsBlock, influenceRadius) == 112, "TraceParamsBlock must match the std140 layout");
+static_assert(offsetof(TraceParamsBlock, shadowCenter) == 120, "TraceParamsBlock must match the std140 layout");
+
+// #define block of the raytracer.comp variant for a quality tier
+std::string makeTierDefines(const QualityTier& tier) {
+    char defines[256];
+    std::snprintf(defines, sizeof(defines),
+                  "#define MAX_STEPS %d\n"
+                  "#define STEP_SIZE %.9e\n"
+                  "#define TOLERANCE %.9e\n"
+                  "#define CROSSING_ITERATIONS %d\n",
+                  tier.maxSteps, tier.stepSize, tier.tolerance, tier.crossingIterations);
+    return defines;
+}
+
+} // namespace
+
 Renderer::Renderer(int width, int height)
     : m_width(width)
     , m_height(height)
@@ -19,9 +98,50 @@ Renderer::Renderer(int width, int height)
     , m_showEventHorizon(true)
     , m_showPhotonSphere(false)
     , m_showAccretionDisk(true)
+    , m_useCpuTracer(false)
     , m_exposure(1.0f)
+    , m_integrator(GeodesicIntegrator::Kerr)
+    , m_useSchwarzschildFastPath(true)
+    , m_useShadowCulling(true)
+    , m_influenceRadius(DEFAULT_INFLUENCE_RADIUS)
+    , m_lensingActive(false)
+    , m_useLensingMapCache(false)
+    , m_animationTime(0.0f)
+    , m_lensingMapPreview(false)
+    , m_lastTraceInputs()
+    , m_lastShadeInputs()
+    , m_traceValid(false)
+    , m_shadeValid(false)
+    , m_traceSkipped(false)
+    , m_shadeSkipped(false)
+    , m_stageStats{ 0, 0, 0 }
+    , m_progressive(true)
+    , m_maxSamples(64)
+    , m_sampleCount(0)
+    , m_dynamicResolution(true)
+    , m_interacting(false)
+    , m_targetFrameTime(1000.0f / 60.0f)
+    , m_renderScale(1.0f)
+    , m_renderWidth(width)
+    , m_renderHeight(height)
+    , m_traceTime(0.0)
+    , m_timedFrames{}
+    , m_lastTimedFrame(0)
+    , m_tierTraceTime{}
+    , m_tierTraceScale{}
     , m_quadVAO(0)
-    , m_quadVBO(0) {
+    , m_quadVBO(0)
+    , m_stepStatsSlots{}
+    , m_stepStatsSlot(0)
+    , m_gpuStepStats{ 0.0, 0, 0 }
+    , m_lensingBuffer(0)
+    , m_shadowBuffer(0)
+    , m_rayTracerShader(nullptr)
+    , m_tracedQuality(0)
+    , m_shadersReady(false)
+    , m_skyVersion(0)
+    , m_lensing(std::make_unique<Physics::SchwarzschildLensing>())
+    , m_shadowProfile(std::make_unique<ShadowProfile>()) {
 }
 
 Renderer::~Renderer() {
@@ -31,12 +151,63 @@ Renderer::~Renderer() {
     if (m_quadVBO) {
         glDeleteBuffers(1, &m_quadVBO);
     }
+    for (StepStatsSlot& slot : m_stepStatsSlots) {
+        if (slot.fence) {
+            glDeleteSync(static_cast<GLsync>(slot.fence));
+        }
+        if (slot.buffer) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            glDeleteBuffers(1, &slot.buffer);
+        }
+    }
+    if (m_lensingBuffer) {
+        glDeleteBuffers(1, &m_lensingBuffer);
+    }
+    if (m_shadowBuffer) {
+        glDeleteBuffers(1, &m_shadowBuffer);
+    }
 }
 
-void Renderer::initialize() {
+void Renderer::initialize(int quality) {
+    PROFILE_ZONE("Renderer::initialize");
+    m_quality = quality;
     createFullscreenQuad();
     loadShaders();  // Will throw exception if shaders fail
-    generateStarfield();
+    
+    // Empty until loadSkyMap(); the shader draws the procedural sky meanwhile
+    m_skyMap = std::make_unique<SkyMap>();
+    
+    // Step counters accumulated by the compute shader, read back through
+    // persistent mappings once each trace has finished
+    const GLbitfield statsFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    for (StepStatsSlot& slot : m_stepStatsSlots) {
+        unsigned int zeroStats[3] = { 0, 0, 0 };
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+        glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(zeroStats), zeroStats, statsFlags);
+        slot.mapped = static_cast<const unsigned int*>(
+            glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zeroStats), statsFlags));
+        if (!slot.mapped) {
+            std::cerr << "Failed to map step statistics buffer" << std::endl;
+        }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    
+    // Filled on first use of the Schwarzschild fast path
+    glGenBuffers(1, &m_lensingBuffer);
+    
+    // Shadow radii, rewritten by every Kerr trace that culls
+    glGenBuffers(1, &m_shadowBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_shadowBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, ShadowProfile::BIN_COUNT * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    
+    m_traceParams = std::make_unique<UniformBuffer>(sizeof(TraceParamsBlock));
+    
+    // Times every pass; the ray march results also drive dynamic resolution
+    m_profiler = std::make_unique<GpuProfiler>();
     
     // Create output texture
     m_outputTexture = std::make_unique<Texture>();
@@ -44,9 +215,31 @@ void Renderer::initialize() {
     
     std::cout << "Created output texture: " << m_width << "x" << m_height << " RGBA16F" << std::endl;
     
+    // Geodesic G-buffer between the trace and shading passes
+    m_gbufferTexture = std::make_unique<Texture>();
+    m_gbufferTexture->createFloat(m_width, m_height);
+    m_historyTexture = std::make_unique<Texture>();
+    m_historyTexture->createFloat(m_width, m_height);
+    
+    // Disk colour table, shared with the CPU tracer
+    const Physics::EmissionTables& emission = Physics::EmissionTables::get();
+    m_dopplerLutTexture = std::make_unique<Texture>();
+    m_dopplerLutTexture->createFloat(Physics::EmissionTables::TEMPERATURE_SAMPLES,
+                                     Physics::EmissionTables::DOPPLER_SAMPLES);
+    m_dopplerLutTexture->update(emission.getDopplerData().data());
+    
     // Create post-processing
     m_postProcess = std::make_unique<PostProcess>(m_width, m_height);
     
+    // CPU tracer shares the output texture with the compute path
+    m_cpuTracer = std::make_unique<CpuRayTracer>(m_width, m_height);
+    m_cpuTracer->setIntegrator(m_integrator);
+    m_cpuTracer->setUseSchwarzschildFastPath(m_useSchwarzschildFastPath);
+    m_cpuTracer->setUseShadowCulling(m_useShadowCulling);
+    m_cpuTracer->setInfluenceRadius(m_influenceRadius);
+    m_lensingMapCache = std::make_unique<LensingMapCache>();
+    setQuality(m_quality);
+    
     std::cout << "Renderer initialized" << std::endl;
 }
 
@@ -54,65 +247,150 @@ void Renderer::resize(int width, int height) {
     m_width = width;
     m_height = height;
     
-    m_outputTexture->create(width, height, 4, true);
+    // Trace targets follow in updateRenderTargets()
     m_postProcess->resize(width, height);
 }
 
+void Renderer::updateRenderTargets() {
+    float scale = 1.0f;
+    if (m_dynamicResolution) {
+        scale = m_interacting ? std::min(m_renderScale, INTERACTION_RENDER_SCALE) : m_renderScale;
+    }
+    int width = std::max(1, static_cast<int>(m_width * scale + 0.5f));
+    int height = std::max(1, static_cast<int>(m_height * scale + 0.5f));
+    if (width == m_renderWidth && height == m_renderHeight) {
+        return;
+    }
+    
+    m_renderWidth = width;
+    m_renderHeight = height;
+    m_outputTexture->create(width, height, 4, true);
+    m_gbufferTexture->createFloat(width, height);
+    m_historyTexture->createFloat(width, height);
+    m_cpuTracer->resize(width, height);
+    invalidateFrame();
+}
+
 void Renderer::render(const Core::Camera& camera, 
                        const Physics::BlackHole& blackHole,
                        const Physics::AccretionDisk& disk) {
-    // Compute shader ray tracing pass
-    if (m_rayTracerShader) {
-        m_rayTracerShader->use();
-        
-        // Set uniforms
-        m_rayTracerShader->setVec3("u_cameraPos", camera.getPosition());
-        m_rayTracerShader->setVec3("u_cameraTarget", camera.getTarget());
-        m_rayTracerShader->setVec3("u_cameraUp", camera.getUp());
-        m_rayTracerShader->setFloat("u_fov", camera.getFOV());
-        m_rayTracerShader->setFloat("u_aspectRatio", static_cast<float>(m_width) / m_height);
-        
-        // Black hole parameters
-        m_rayTracerShader->setFloat("u_blackHoleMass", blackHole.getMass());
-        m_rayTracerShader->setFloat("u_blackHoleSpin", blackHole.getSpin());
-        m_rayTracerShader->setVec3("u_blackHolePos", blackHole.getPosition());
-        m_rayTracerShader->setFloat("u_schwarzschildRadius", blackHole.getSchwarzschildRadius());
-        
-        // Accretion disk parameters
-        m_rayTracerShader->setBool("u_showAccretionDisk", m_showAccretionDisk);
-        m_rayTracerShader->setFloat("u_diskInnerRadius", disk.getInnerRadius());
-        m_rayTracerShader->setFloat("u_diskOuterRadius", disk.getOuterRadius());
-        m_rayTracerShader->setFloat("u_diskThickness", disk.getThickness());
-        
-        // Rendering options
-        m_rayTracerShader->setBool("u_showEventHorizon", m_showEventHorizon);
-        m_rayTracerShader->setBool("u_showPhotonSphere", m_showPhotonSphere);
-        
-        // Bind output texture as image
-        m_outputTexture->bindImage(0, GL_WRITE_ONLY);
-        
-        // Bind starfield
-        if (m_starfieldTexture) {
-            m_starfieldTexture->bind(0);
-            m_rayTracerShader->setInt("u_starfield", 0);
+    PROFILE_ZONE("Renderer::render");
+    m_profiler->beginFrame();
+    readTraceTimer();
+    readStepStats();
+    updateRenderTargets();
+    pollShaders();
+    m_rayTracerShader = selectRayTracerVariant();
+    if (m_skyMap->update()) {
+        ++m_skyVersion;
+    }
+    
+    TraceInputs traceInputs;
+    traceInputs.cameraPos = camera.getPosition();
+    traceInputs.cameraTarget = camera.getTarget();
+    traceInputs.cameraUp = camera.getUp();
+    traceInputs.fov = camera.getFOV();
+    traceInputs.aspectRatio = static_cast<float>(m_width) / m_height;
+    traceInputs.mass = blackHole.getMass();
+    traceInputs.spin = blackHole.getSpin();
+    traceInputs.blackHolePos = blackHole.getPosition();
+    traceInputs.diskInnerRadius = disk.getInnerRadius();
+    traceInputs.diskOuterRadius = disk.getOuterRadius();
+    traceInputs.showAccretionDisk = m_showAccretionDisk;
+    traceInputs.showPhotonSphere = m_showPhotonSphere;
+    traceInputs.integrator = m_integrator;
+    traceInputs.quality = m_useCpuTracer ? m_quality : m_tracedQuality;
+    traceInputs.useSchwarzschildFastPath = m_useSchwarzschildFastPath;
+    traceInputs.useShadowCulling = m_useShadowCulling;
+    traceInputs.influenceRadius = m_influenceRadius;
+    
+    ShadeInputs shadeInputs;
+    shadeInputs.schwarzschildRadius = blackHole.getSchwarzschildRadius();
+    shadeInputs.diskInnerRadius = disk.getInnerRadius();
+    shadeInputs.diskOuterRadius = disk.getOuterRadius();
+    shadeInputs.animationPhase = disk.getRotationSpeed() * m_animationTime;
+    shadeInputs.skyVersion = m_useCpuTracer ? 0 : m_skyVersion;   // The CPU tracer's sky is procedural
+    
+    m_traceSkipped = m_traceValid && traceInputs == m_lastTraceInputs;
+    m_shadeSkipped = m_traceSkipped && m_shadeValid && shadeInputs == m_lastShadeInputs;
+    
+    // Any change restarts the accumulation; a still frame keeps adding
+    // jittered samples until the limit is reached
+    if (!m_shadeSkipped) {
+        m_sampleCount = 0;
+    } else if (m_progressive && m_sampleCount < m_maxSamples) {
+        m_traceSkipped = false;
+        m_shadeSkipped = false;
+    }
+    int sampleIndex = m_sampleCount;
+    glm::vec2 jitter = m_progressive ? sampleJitter(sampleIndex) : glm::vec2(0.0f);
+    
+    bool rendered = true;
+    if (m_useCpuTracer) {
+        // CPU ray tracing pass, uploaded in place of the compute dispatch.
+        // It traces and shades in one go; only a lensing map hit saves the trace.
+        if (!m_shadeSkipped) {
+            m_cpuTracer->setShowAccretionDisk(m_showAccretionDisk);
+            m_cpuTracer->setShowPhotonSphere(m_showPhotonSphere);
+            m_cpuTracer->setJitter(jitter);
+            m_cpuTracer->render(camera, blackHole, disk);
+            m_lensingActive = m_cpuTracer->isSchwarzschildFastPathActive();
+            accumulateCpuFrame(sampleIndex);
+            
+            LensingMapResult result = m_cpuTracer->getLensingMapResult();
+            m_traceSkipped = result == LensingMapResult::Cached || result == LensingMapResult::Interpolated;
+            if (!m_traceSkipped) {
+                m_traceTime = m_cpuTracer->getLastFrameTime();
+                adjustRenderScale(m_traceTime, getRenderScale());
+                recordTierTraceTime(m_quality, m_traceTime, getRenderScale());
+            }
         }
-        
-        // Dispatch compute shader
-        unsigned int workGroupsX = (m_width + 15) / 16;
-        unsigned int workGroupsY = (m_height + 15) / 16;
-        m_rayTracerShader->dispatch(workGroupsX, workGroupsY, 1);
-        
-        // Wait for compute shader to finish
-        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    } else if (m_rayTracerShader && isShaderReady(m_shadeShader.get())) {
+        // The shading pass re-runs on its own while only the disk animates.
+        // Pass times are read back a frame or more later.
+        if (!m_traceSkipped) {
+            unsigned long long frame = m_profiler->getFrame();
+            m_timedFrames[frame % TIMED_FRAME_COUNT] = { frame, getRenderScale(), m_tracedQuality };
+            m_profiler->begin(GpuPass::RayMarch);
+            traceGBuffer(camera, blackHole, disk, jitter);
+            m_profiler->end(GpuPass::RayMarch);
+        }
+        if (!m_shadeSkipped) {
+            m_profiler->begin(GpuPass::Shade);
+            shadeGBuffer(blackHole, disk, sampleIndex);
+            m_profiler->end(GpuPass::Shade);
+        }
+    } else {
+        // Still compiling: keep showing the last output until a tier is ready
+        rendered = false;
+    }
+    
+    if (!m_shadeSkipped) {
+        m_sampleCount = rendered ? sampleIndex + 1 : 0;
     }
     
+    m_lastTraceInputs = traceInputs;
+    m_lastShadeInputs = shadeInputs;
+    m_traceValid = rendered;
+    m_shadeValid = rendered;
+    
+    ++m_stageStats.frames;
+    m_stageStats.tracesSkipped += m_traceSkipped ? 1 : 0;
+    m_stageStats.shadesSkipped += m_shadeSkipped ? 1 : 0;
+    
     // Display pass
     // Don't clear! We want to draw on top of what ImGui might render
     // glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    if (m_displayShader) {
+    if (!isShaderReady(m_displayShader.get())) {
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    } else {
+        m_profiler->begin(GpuPass::Display);
         m_displayShader->use();
         m_displayShader->setFloat("u_exposure", m_exposure);
+        m_displayShader->setVec2("u_sourceSize", glm::vec2(m_renderWidth, m_renderHeight));
+        m_displayShader->setBool("u_upscale", m_renderWidth != m_width || m_renderHeight != m_height);
         
         m_outputTexture->bind(0);
         m_displayShader->setInt("u_texture", 0);
@@ -120,9 +398,242 @@ void Renderer::render(const Core::Camera& camera,
         glBindVertexArray(m_quadVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindVertexArray(0);
+        m_profiler->end(GpuPass::Display);
     }
 }
 
+void Renderer::traceGBuffer(const Core::Camera& camera,
+                            const Physics::BlackHole& blackHole,
+                            const Physics::AccretionDisk& disk,
+                            const glm::vec2& jitter) {
+    PROFILE_ZONE("Renderer::traceGBuffer");
+    m_rayTracerShader->use();
+    
+    // One block for all per-frame parameters instead of a glUniform call
+    // (and a name lookup) each; zeroed so unchanged frames compare equal
+    TraceParamsBlock params = {};
+    params.cameraPos = camera.getPosition();
+    params.cameraTarget = camera.getTarget();
+    params.cameraUp = camera.getUp();
+    params.fov = camera.getFOV();
+    params.aspectRatio = static_cast<float>(m_width) / m_height;
+    params.jitter = jitter;
+    
+    // Black hole parameters
+    params.blackHoleMass = blackHole.getMass();
+    params.blackHoleSpin = blackHole.getSpin();
+    params.blackHolePos = blackHole.getPosition();
+    params.schwarzschildRadius = blackHole.getSchwarzschildRadius();
+    
+    // Accretion disk parameters
+    params.showAccretionDisk = m_showAccretionDisk;
+    params.diskInnerRadius = disk.getInnerRadius();
+    params.diskOuterRadius = disk.getOuterRadius();
+    params.diskThickness = disk.getThickness();
+    
+    // Rendering options
+    params.showEventHorizon = m_showEventHorizon;
+    params.showPhotonSphere = m_showPhotonSphere;
+    
+    // Integration scheme
+    params.integrator = static_cast<int32_t>(m_integrator);
+    params.influenceRadius = m_influenceRadius;
+    
+    // A non-rotating hole under the exact integrator reads its rays from
+    // the Binet table, rebuilt only when the mass or camera radius change
+    m_lensingActive = m_useSchwarzschildFastPath && m_integrator == GeodesicIntegrator::Kerr &&
+                      blackHole.getSpin() < Physics::SCHWARZSCHILD_SPIN_THRESHOLD;
+    if (m_lensingActive) {
+        updateLensingTable(blackHole.getSchwarzschildRadius() * 0.5f,
+                           glm::length(camera.getPosition() - blackHole.getPosition()));
+        params.lensCriticalAngle = m_lensing->getCriticalAngle();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_lensingBuffer);
+    }
+    params.useLensingTable = m_lensingActive;
+    
+    // The remaining Kerr marches skip pixels well inside the analytic shadow
+    m_shadowProfile->clear();
+    if (m_useShadowCulling && m_integrator == GeodesicIntegrator::Kerr && !m_lensingActive && !m_showPhotonSphere) {
+        glm::vec3 forward = glm::normalize(params.cameraTarget - params.cameraPos);
+        glm::vec3 right = glm::normalize(glm::cross(forward, params.cameraUp));
+        glm::vec3 up = glm::cross(right, forward);
+        float pixelSize = 2.0f * std::tan(glm::radians(params.fov) * 0.5f) / m_renderHeight;
+        if (m_shadowProfile->build(blackHole.getShadowContour(params.cameraPos), forward, right, up, pixelSize)) {
+            const std::vector<float>& radii = m_shadowProfile->getRadii();
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_shadowBuffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, radii.size() * sizeof(float), radii.data());
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_shadowBuffer);
+            params.shadowCenter = m_shadowProfile->getCenter();
+        }
+    }
+    params.useShadowProfile = m_shadowProfile->isValid();
+    
+    m_traceParams->update(&params);
+    m_traceParams->bind(TRACE_PARAMS_BINDING);
+    
+    // Fresh counters for this trace
+    int statsSlot = beginStepStats();
+    
+    m_gbufferTexture->bindImage(0, GL_WRITE_ONLY);
+    
+    // Dispatch compute shader
+    unsigned int workGroupsX = (m_renderWidth + 15) / 16;
+    unsigned int workGroupsY = (m_renderHeight + 15) / 16;
+    m_rayTracerShader->dispatch(workGroupsX, workGroupsY, 1);
+    m_traceParams->fence();
+    
+    // The shading pass reads the G-buffer next; the step counters are read
+    // through their mapping once the fence behind them signals
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT |
+                    GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+    StepStatsSlot& slot = m_stepStatsSlots[statsSlot];
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.pixels = static_cast<long long>(m_renderWidth) * m_renderHeight;
+}
+
+void Renderer::shadeGBuffer(const Physics::BlackHole& blackHole,
+                            const Physics::AccretionDisk& disk,
+                            int sampleIndex) {
+    PROFILE_ZONE("Renderer::shadeGBuffer");
+    m_shadeShader->use();
+    m_shadeShader->setFloat("u_schwarzschildRadius", blackHole.getSchwarzschildRadius());
+    m_shadeShader->setFloat("u_diskInnerRadius", disk.getInnerRadius());
+    m_shadeShader->setFloat("u_diskOuterRadius", disk.getOuterRadius());
+    m_shadeShader->setFloat("u_diskRotationSpeed", disk.getRotationSpeed());
+    m_shadeShader->setFloat("u_time", m_animationTime);
+    m_shadeShader->setInt("u_sampleIndex", sampleIndex);
+    
+    m_outputTexture->bindImage(0, GL_WRITE_ONLY);
+    m_gbufferTexture->bindImage(1, GL_READ_ONLY);
+    m_historyTexture->bindImage(2, GL_READ_WRITE);
+    
+    // Sky cubemap; until a stage of it is in, the shader draws the procedural sky
+    m_skyMap->bind(0);
+    m_shadeShader->setInt("u_skyMap", 0);
+    m_shadeShader->setBool("u_useSkyMap", m_skyMap->isReady());
+    m_shadeShader->setFloat("u_skyTexelAngle", m_skyMap->getTexelAngle());
+    m_dopplerLutTexture->bind(1);
+    m_shadeShader->setInt("u_dopplerLut", 1);
+    
+    unsigned int workGroupsX = (m_renderWidth + 15) / 16;
+    unsigned int workGroupsY = (m_renderHeight + 15) / 16;
+    m_shadeShader->dispatch(workGroupsX, workGroupsY, 1);
+    
+    // Wait for the output image before the display pass samples it
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void Renderer::readTraceTimer() {
+    unsigned long long frame = 0;
+    double traceTime = 0.0;
+    if (!m_profiler->getLatest(GpuPass::RayMarch, frame, traceTime) || frame == m_lastTimedFrame) {
+        return;
+    }
+    m_lastTimedFrame = frame;
+    
+    // Too old to know the scale it ran at
+    const TimedFrame& timed = m_timedFrames[frame % TIMED_FRAME_COUNT];
+    if (timed.frame != frame) {
+        return;
+    }
+    
+    // The budget covers both compute passes
+    unsigned long long shadeFrame = 0;
+    double shadeTime = 0.0;
+    if (m_profiler->getLatest(GpuPass::Shade, shadeFrame, shadeTime) && shadeFrame == frame) {
+        traceTime += shadeTime;
+    }
+    
+    m_traceTime = traceTime;
+    adjustRenderScale(m_traceTime, timed.scale);
+    recordTierTraceTime(timed.quality, m_traceTime, timed.scale);
+}
+
+void Renderer::recordTierTraceTime(int quality, double traceTime, float scale) {
+    int index = glm::clamp(quality, 1, QUALITY_TIER_COUNT) - 1;
+    m_tierTraceTime[index] = traceTime;
+    m_tierTraceScale[index] = scale;
+}
+
+double Renderer::getTierTraceTime(int quality) const {
+    return m_tierTraceTime[glm::clamp(quality, 1, QUALITY_TIER_COUNT) - 1];
+}
+
+float Renderer::getTierTraceScale(int quality) const {
+    return m_tierTraceScale[glm::clamp(quality, 1, QUALITY_TIER_COUNT) - 1];
+}
+
+void Renderer::adjustRenderScale(double traceTime, float measuredScale) {
+    if (!m_dynamicResolution || traceTime <= 0.0) {
+        return;
+    }
+    
+    // Trace cost is proportional to the pixel count, i.e. the scale squared
+    float ideal = measuredScale * static_cast<float>(std::sqrt(m_targetFrameTime / traceTime));
+    ideal = glm::clamp(ideal, MIN_RENDER_SCALE, 1.0f);
+    
+    // Ignore changes under one step so the scale settles instead of flickering
+    if (std::abs(ideal - m_renderScale) < RENDER_SCALE_STEP) {
+        return;
+    }
+    float scale = m_renderScale + 0.5f * (ideal - m_renderScale);
+    scale = std::round(scale / RENDER_SCALE_STEP) * RENDER_SCALE_STEP;
+    m_renderScale = glm::clamp(scale, MIN_RENDER_SCALE, 1.0f);
+}
+
+void Renderer::accumulateCpuFrame(int sampleIndex) {
+    PROFILE_ZONE("Renderer::accumulateCpuFrame");
+    const std::vector<float>& pixels = m_cpuTracer->getPixels();
+    if (!m_progressive) {
+        m_outputTexture->update(pixels.data());
+        return;
+    }
+    
+    if (sampleIndex == 0) {
+        m_cpuHistory = pixels;
+        m_outputTexture->update(pixels.data());
+        return;
+    }
+    
+    // Running sum of the samples, uploaded as their mean
+    float scale = 1.0f / (sampleIndex + 1);
+    m_cpuAverage.resize(pixels.size());
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        m_cpuHistory[i] += pixels[i];
+        m_cpuAverage[i] = m_cpuHistory[i] * scale;
+    }
+    m_outputTexture->update(m_cpuAverage.data());
+}
+
+bool Renderer::TraceInputs::operator==(const TraceInputs& other) const {
+    return cameraPos == other.cameraPos &&
+           cameraTarget == other.cameraTarget &&
+           cameraUp == other.cameraUp &&
+           fov == other.fov &&
+           aspectRatio == other.aspectRatio &&
+           mass == other.mass &&
+           spin == other.spin &&
+           blackHolePos == other.blackHolePos &&
+           diskInnerRadius == other.diskInnerRadius &&
+           diskOuterRadius == other.diskOuterRadius &&
+           showAccretionDisk == other.showAccretionDisk &&
+           showPhotonSphere == other.showPhotonSphere &&
+           integrator == other.integrator &&
+           quality == other.quality &&
+           useSchwarzschildFastPath == other.useSchwarzschildFastPath &&
+           useShadowCulling == other.useShadowCulling &&
+           influenceRadius == other.influenceRadius;
+}
+
+bool Renderer::ShadeInputs::operator==(const ShadeInputs& other) const {
+    return schwarzschildRadius == other.schwarzschildRadius &&
+           diskInnerRadius == other.diskInnerRadius &&
+           diskOuterRadius == other.diskOuterRadius &&
+           animationPhase == other.animationPhase &&
+           skyVersion == other.skyVersion;
+}
+
 void Renderer::createFullscreenQuad() {
     float quadVertices[] = {
         // positions   // texCoords
@@ -152,78 +663,325 @@ void Renderer::createFullscreenQuad() {
 }
 
 void Renderer::loadShaders() {
+    PROFILE_ZONE("Renderer::loadShaders");
     bool success = true;
+    m_shaderLoadStart = std::chrono::steady_clock::now();
     
-    // Load compute shader for ray tracing
-    m_rayTracerShader = std::make_unique<Core::Shader>();
-    if (!m_rayTracerShader->loadComputeShader("shaders/raytracer.comp")) {
-        std::cerr << "Failed to load ray tracer compute shader" << std::endl;
+    // Nothing is waited for here: programs compile in the background and
+    // render() uses each one once it is ready. The cheap display and shading
+    // programs and the Low tier go first, so a first image appears early.
+    m_displayShader = std::make_unique<Core::Shader>();
+    if (!m_displayShader->beginFromFile("shaders/fullscreen.vert", "shaders/display.frag")) {
+        std::cerr << "Failed to load display shader" << std::endl;
         success = false;
     }
     
-    // Load display shader
-    m_displayShader = std::make_unique<Core::Shader>();
-    if (!m_displayShader->loadFromFile("shaders/fullscreen.vert", "shaders/display.frag")) {
-        std::cerr << "Failed to load display shader" << std::endl;
+    // Compute shader for shading the G-buffer
+    m_shadeShader = std::make_unique<Core::Shader>();
+    if (!m_shadeShader->beginComputeShader("shaders/shade.comp")) {
+        std::cerr << "Failed to load shading compute shader" << std::endl;
         success = false;
     }
     
-    // Load post-processing shader
     m_postProcessShader = std::make_unique<Core::Shader>();
-    if (!m_postProcessShader->loadFromFile("shaders/fullscreen.vert", "shaders/postprocess.frag")) {
+    if (!m_postProcessShader->beginFromFile("shaders/fullscreen.vert", "shaders/postprocess.frag")) {
         std::cerr << "Failed to load post-process shader" << std::endl;
         success = false;
     }
     
+    // Ray tracer variants of all quality tiers: Low, the current tier, then the rest
+    std::vector<int> order = { 1 };
+    if (m_quality != 1) {
+        order.push_back(m_quality);
+    }
+    for (int tier = 2; tier <= QUALITY_TIER_COUNT; ++tier) {
+        if (tier != m_quality) {
+            order.push_back(tier);
+        }
+    }
+    for (int tier : order) {
+        auto& variant = m_rayTracerVariants[tier - 1];
+        variant = std::make_unique<Core::Shader>();
+        if (!variant->beginComputeShader("shaders/raytracer.comp", makeTierDefines(getQualityTier(tier)))) {
+            variant.reset();
+        }
+    }
+    if (!m_rayTracerVariants[m_quality - 1]) {
+        std::cerr << "Failed to load ray tracer compute shader" << std::endl;
+        success = false;
+    }
+    
     if (!success) {
         throw std::runtime_error("One or more shaders failed to load");
     }
 }
 
-void Renderer::generateStarfield() {
-    // Generate procedural starfield texture
-    const int starfieldSize = 2048;
-    const int numStars = 10000;
-    
-    std::vector<unsigned char> data(starfieldSize * starfieldSize * 3, 0);
-    
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> posDist(0, starfieldSize - 1);
-    std::uniform_int_distribution<> brightDist(50, 255);
+void Renderer::pollShaders() {
+    PROFILE_ZONE("Renderer::pollShaders");
+    if (m_shadersReady) {
+        return;
+    }
     
-    // Generate random stars
-    for (int i = 0; i < numStars; ++i) {
-        int x = posDist(gen);
-        int y = posDist(gen);
-        int brightness = brightDist(gen);
-        
-        int idx = (y * starfieldSize + x) * 3;
-        data[idx] = brightness;
-        data[idx + 1] = brightness;
-        data[idx + 2] = brightness;
-        
-        // Add some color variation
-        if (brightness > 200) {
-            // Blue stars
-            data[idx + 2] = 255;
-        } else if (brightness < 100) {
-            // Red stars
-            data[idx] = brightness + 50;
-            data[idx + 2] = brightness / 2;
+    // Required programs end the session like a failed load used to
+    const std::pair<Core::Shader*, const char*> required[] = {
+        { m_displayShader.get(), "display" },
+        { m_shadeShader.get(), "shading" },
+        { m_postProcessShader.get(), "post-process" },
+    };
+    for (const auto& shader : required) {
+        if (shader.first->isCompilePending() && shader.first->isCompileComplete() &&
+            !shader.first->finishCompile()) {
+            throw std::runtime_error(std::string("Failed to compile ") + shader.second + " shader");
         }
     }
     
-    m_starfieldTexture = std::make_unique<Texture>();
-    // Would need to create texture from data - for now placeholder
+    // A broken variant only costs its tier; the others stand in for it
+    for (int tier = 1; tier <= QUALITY_TIER_COUNT; ++tier) {
+        auto& variant = m_rayTracerVariants[tier - 1];
+        if (variant && variant->isCompilePending() && variant->isCompileComplete() &&
+            !variant->finishCompile()) {
+            std::cerr << "Failed to compile ray tracer variant for quality " << tier << std::endl;
+            variant.reset();
+        }
+    }
     
-    std::cout << "Generated starfield texture" << std::endl;
+    if (getPendingShaderCount() == 0) {
+        m_shadersReady = true;
+        double elapsed = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - m_shaderLoadStart).count();
+        std::cout << "All shaders ready after " << elapsed << " ms" << std::endl;
+    }
+}
+
+Core::Shader* Renderer::selectRayTracerVariant() {
+    // The current tier, else the best finished tier below it, else above it
+    for (int tier = m_quality; tier >= 1; --tier) {
+        if (isShaderReady(m_rayTracerVariants[tier - 1].get())) {
+            m_tracedQuality = tier;
+            return m_rayTracerVariants[tier - 1].get();
+        }
+    }
+    for (int tier = m_quality + 1; tier <= QUALITY_TIER_COUNT; ++tier) {
+        if (isShaderReady(m_rayTracerVariants[tier - 1].get())) {
+            m_tracedQuality = tier;
+            return m_rayTracerVariants[tier - 1].get();
+        }
+    }
+    m_tracedQuality = 0;
+    return nullptr;
+}
+
+bool Renderer::isShaderReady(const Core::Shader* shader) {
+    return shader && !shader->isCompilePending();
+}
+
+int Renderer::getPendingShaderCount() const {
+    int count = 0;
+    for (const Core::Shader* shader : { m_displayShader.get(), m_shadeShader.get(), m_postProcessShader.get() }) {
+        count += shader && shader->isCompilePending() ? 1 : 0;
+    }
+    for (const auto& variant : m_rayTracerVariants) {
+        count += variant && variant->isCompilePending() ? 1 : 0;
+    }
+    return count;
 }
 
 void Renderer::setQuality(int quality) {
     m_quality = quality;
-    // Note: Quality changes would require recompiling shaders with different constants
-    // For now, we just store the value - full implementation would need shader variants
+    // The GPU picks the precompiled variant of the tier on the next frame
+    QualityTier tier = getQualityTier(quality);
+    m_cpuTracer->setMaxSteps(tier.maxSteps);
+    m_cpuTracer->setStepSize(tier.stepSize);
+    m_cpuTracer->setTolerance(tier.tolerance);
+}
+
+void Renderer::setIntegrator(GeodesicIntegrator integrator) {
+    m_integrator = integrator;
+    m_cpuTracer->setIntegrator(integrator);
+}
+
+void Renderer::setUseSchwarzschildFastPath(bool use) {
+    m_useSchwarzschildFastPath = use;
+    m_cpuTracer->setUseSchwarzschildFastPath(use);
+}
+
+void Renderer::setUseShadowCulling(bool use) {
+    m_useShadowCulling = use;
+    m_cpuTracer->setUseShadowCulling(use);
+}
+
+void Renderer::setInfluenceRadius(float radius) {
+    m_influenceRadius = radius;
+    m_cpuTracer->setInfluenceRadius(radius);
+}
+
+void Renderer::setAnimationTime(float time) {
+    m_animationTime = time;
+    m_cpuTracer->setTime(time);
+}
+
+void Renderer::setUseLensingMapCache(bool use) {
+    m_useLensingMapCache = use;
+    m_cpuTracer->setLensingMapCache(use ? m_lensingMapCache.get() : nullptr);
+    if (!use) {
+        m_lensingMapCache->clear();
+    }
+}
+
+void Renderer::setProgressive(bool progressive) {
+    if (progressive != m_progressive) {
+        // Restart from a single unjittered sample
+        m_progressive = progressive;
+        invalidateFrame();
+    }
+}
+
+void Renderer::setDynamicResolution(bool enable) {
+    m_dynamicResolution = enable;
+    if (!enable) {
+        m_renderScale = 1.0f;
+    }
+}
+
+void Renderer::setUseCpuTracer(bool use) {
+    if (use != m_useCpuTracer) {
+        // Both paths write the output texture
+        m_useCpuTracer = use;
+        invalidateFrame();
+    }
+}
+
+void Renderer::setLensingMapPreview(bool preview) {
+    if (preview != m_lensingMapPreview) {
+        // Replace the blended preview with a traced frame once the drag ends
+        m_lensingMapPreview = preview;
+        m_cpuTracer->setLensingMapPreview(preview);
+        invalidateFrame();
+    }
+}
+
+void Renderer::invalidateFrame() {
+    m_traceValid = false;
+    m_shadeValid = false;
+}
+
+LensingMapResult Renderer::getLensingMapResult() const {
+    return m_cpuTracer->getLensingMapResult();
+}
+
+void Renderer::loadSkyMap(const std::string& path, int maxFaceSize) {
+    m_skyMap->load(path, maxFaceSize);
+}
+
+double Renderer::getLensingBuildTime() const {
+    return m_useCpuTracer ? m_cpuTracer->getSchwarzschildLensing().getLastBuildTime()
+                          : m_lensing->getLastBuildTime();
+}
+
+void Renderer::updateLensingTable(float mass, float cameraRadius) {
+    PROFILE_ZONE("Renderer::updateLensingTable");
+    if (!m_lensing->build(mass, cameraRadius)) {
+        return;
+    }
+    
+    const std::vector<float>& data = m_lensing->getData();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lensingBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, data.size() * sizeof(float), data.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+float Renderer::getTolerance() const {
+    return getToleranceForQuality(m_quality);
+}
+
+StepStats Renderer::getStepStats() const {
+    return m_useCpuTracer ? m_cpuTracer->getStepStats() : m_gpuStepStats;
+}
+
+void Renderer::readStepStats() {
+    PROFILE_ZONE("Renderer::readStepStats");
+    // Oldest first, so the newest finished trace ends up in m_gpuStepStats
+    for (int i = 1; i <= STEP_STATS_SLOTS; ++i) {
+        StepStatsSlot& slot = m_stepStatsSlots[(m_stepStatsSlot + i) % STEP_STATS_SLOTS];
+        if (!slot.fence) {
+            continue;
+        }
+        GLenum status = glClientWaitSync(static_cast<GLsync>(slot.fence), 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            continue;
+        }
+        glDeleteSync(static_cast<GLsync>(slot.fence));
+        slot.fence = nullptr;
+        if (!slot.mapped) {
+            continue;
+        }
+        
+        long long total = (static_cast<long long>(slot.mapped[1]) << 32) | slot.mapped[0];
+        m_gpuStepStats.totalSteps = total;
+        m_gpuStepStats.maxSteps = static_cast<int>(slot.mapped[2]);
+        m_gpuStepStats.averageSteps = slot.pixels > 0 ? static_cast<double>(total) / slot.pixels : 0.0;
+    }
+}
+
+int Renderer::beginStepStats() {
+    // A slot still in flight means the GPU is STEP_STATS_SLOTS traces
+    // behind; its counts are dropped rather than waited for. The clear is
+    // queued behind that trace, so it cannot mix into this one.
+    m_stepStatsSlot = (m_stepStatsSlot + 1) % STEP_STATS_SLOTS;
+    StepStatsSlot& slot = m_stepStatsSlots[m_stepStatsSlot];
+    if (slot.fence) {
+        glDeleteSync(static_cast<GLsync>(slot.fence));
+        slot.fence = nullptr;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, slot.buffer);
+    return m_stepStatsSlot;
+}
+
+void Renderer::setCpuThreadCount(int count) {
+    m_cpuTracer->setThreadCount(count);
+}
+
+int Renderer::getCpuThreadCount() const {
+    return m_cpuTracer->getThreadCount();
+}
+
+double Renderer::getCpuFrameTime() const {
+    return m_cpuTracer->getLastFrameTime();
+}
+
+void Renderer::setCpuUsePackets(bool use) {
+    m_cpuTracer->setUsePackets(use);
+}
+
+bool Renderer::getCpuUsePackets() const {
+    return m_cpuTracer->getUsePackets();
+}
+
+const char* Renderer::getCpuSimdName() const {
+    return getSimdLevelName(m_cpuTracer->getSimdLevel());
+}
+
+void Renderer::setCpuWorkStealing(bool enable) {
+    m_cpuTracer->setScheduling(enable ? CpuScheduling::WorkStealing : CpuScheduling::OpenMPRows);
+}
+
+bool Renderer::getCpuWorkStealing() const {
+    return m_cpuTracer->getScheduling() == CpuScheduling::WorkStealing;
+}
+
+void Renderer::setCpuTileSize(int size) {
+    m_cpuTracer->setTileSize(size);
+}
+
+int Renderer::getCpuTileSize() const {
+    return m_cpuTracer->getTileSize();
+}
+
+const TileScheduler& Renderer::getCpuScheduler() const {
+    return m_cpuTracer->getScheduler();
 }
 
 const char* Renderer::getQualityName() const {
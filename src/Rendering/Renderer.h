@@ -1,6 +1,10 @@
 #pragma once
 
+#include "Integrator.h"
+#include <chrono>
 #include <memory>
+#include <string>
+#include <vector>
 #include <glm/glm.hpp>
 
 namespace Core {
@@ -11,21 +15,38 @@ namespace Core {
 namespace Physics {
     class BlackHole;
     class AccretionDisk;
+    class SchwarzschildLensing;
 }
 
 namespace Rendering {
     class Texture;
     class PostProcess;
+    class CpuRayTracer;
+    class GpuProfiler;
+    class UniformBuffer;
+    class TileScheduler;
+    class LensingMapCache;
+    class SkyMap;
+    class ShadowProfile;
+    enum class LensingMapResult;
 }
 
 namespace Rendering {
 
+// Frames rendered and the stages skipped because their inputs were unchanged
+struct RenderStageStats {
+    long long frames;
+    long long tracesSkipped;
+    long long shadesSkipped;
+};
+
 class Renderer {
 public:
     Renderer(int width, int height);
     ~Renderer();
     
-    void initialize();
+    // quality: starting tier, whose shader variant is compiled right after Low
+    void initialize(int quality = 2);
     void resize(int width, int height);
     
     // Main rendering function
@@ -40,6 +61,40 @@ public:
     void setShowEventHorizon(bool show) { m_showEventHorizon = show; }
     void setShowPhotonSphere(bool show) { m_showPhotonSphere = show; }
     void setShowAccretionDisk(bool show) { m_showAccretionDisk = show; }
+    void setUseCpuTracer(bool use);
+    void setCpuThreadCount(int count);
+    void setCpuUsePackets(bool use);
+    void setCpuWorkStealing(bool enable);
+    void setCpuTileSize(int size);
+    void setIntegrator(GeodesicIntegrator integrator);
+    void setUseSchwarzschildFastPath(bool use);
+    
+    // Kerr integrator: skip the march for pixels well inside the analytic shadow
+    void setUseShadowCulling(bool use);
+    
+    // Sphere of influence in Schwarzschild radii (0 = march every ray to
+    // the end); beyond it rays are propagated in closed form
+    void setInfluenceRadius(float radius);
+    
+    // Seconds since start, drives the disk animation of the shading pass
+    void setAnimationTime(float time);
+    
+    // Progressive refinement: while nothing changes, each frame adds one
+    // jittered sample per pixel to a history buffer, up to the sample limit
+    void setProgressive(bool progressive);
+    void setMaxSamples(int samples) { m_maxSamples = samples; }
+    
+    // Dynamic resolution: trace at a fraction of the window size chosen to
+    // keep the trace within the frame-time budget, and upscale for display.
+    // While interacting the scale drops to at most the interaction scale.
+    void setDynamicResolution(bool enable);
+    void setTargetFrameTime(float milliseconds) { m_targetFrameTime = milliseconds; }
+    void setInteracting(bool interacting) { m_interacting = interacting; }
+    
+    // CPU tracer lensing map cache: re-shade instead of re-trace when only
+    // disk or display settings change. Preview blends cached spins.
+    void setUseLensingMapCache(bool use);
+    void setLensingMapPreview(bool preview);
     
     // Getters
     int getQuality() const { return m_quality; }
@@ -49,11 +104,126 @@ public:
     bool getShowEventHorizon() const { return m_showEventHorizon; }
     bool getShowPhotonSphere() const { return m_showPhotonSphere; }
     bool getShowAccretionDisk() const { return m_showAccretionDisk; }
+    bool getUseCpuTracer() const { return m_useCpuTracer; }
+    int getCpuThreadCount() const;
+    double getCpuFrameTime() const;
+    bool getCpuUsePackets() const;
+    const char* getCpuSimdName() const;
+    bool getCpuWorkStealing() const;
+    int getCpuTileSize() const;
+    const TileScheduler& getCpuScheduler() const;
+    GeodesicIntegrator getIntegrator() const { return m_integrator; }
+    float getTolerance() const;
+    bool getUseSchwarzschildFastPath() const { return m_useSchwarzschildFastPath; }
+    bool getUseShadowCulling() const { return m_useShadowCulling; }
+    float getInfluenceRadius() const { return m_influenceRadius; }
+    bool getProgressive() const { return m_progressive; }
+    int getMaxSamples() const { return m_maxSamples; }
+    int getSampleCount() const { return m_sampleCount; }
+    bool getDynamicResolution() const { return m_dynamicResolution; }
+    float getTargetFrameTime() const { return m_targetFrameTime; }
+    int getRenderWidth() const { return m_renderWidth; }
+    int getRenderHeight() const { return m_renderHeight; }
+    float getRenderScale() const { return static_cast<float>(m_renderWidth) / m_width; }
+    
+    // Measured time of the last timed trace (GPU timer query or CPU wall clock)
+    double getTraceTime() const { return m_traceTime; }
+    
+    // GPU time of each pass; main.cpp times the UI pass through it
+    GpuProfiler& getProfiler() { return *m_profiler; }
+    const GpuProfiler& getProfiler() const { return *m_profiler; }
+    
+    // Last trace time measured on each quality tier and the render scale it
+    // was measured at (0 ms = not measured yet)
+    double getTierTraceTime(int quality) const;
+    float getTierTraceScale(int quality) const;
+    
+    // Shader programs still compiling in the background, and the tier the
+    // GPU path traces with meanwhile (0 = none ready yet)
+    int getPendingShaderCount() const;
+    int getTracedQuality() const { return m_tracedQuality; }
+    
+    // Stream an equirectangular sky image into the GPU path's cubemap
+    // (faces of at most maxFaceSize texels). The procedural sky stays
+    // until the first stage is in, or for good if the file is unusable.
+    void loadSkyMap(const std::string& path, int maxFaceSize);
+    const SkyMap& getSkyMap() const { return *m_skyMap; }
+    
+    // Whether the last frame used the Binet lensing table, and its build time
+    bool isSchwarzschildFastPathActive() const { return m_lensingActive; }
+    double getLensingBuildTime() const;
+    
+    bool getUseLensingMapCache() const { return m_useLensingMapCache; }
+    LensingMapResult getLensingMapResult() const;
+    const LensingMapCache& getLensingMapCache() const { return *m_lensingMapCache; }
+    
+    // Steps per ray on the last completed frame of the active tracer
+    StepStats getStepStats() const;
+    
+    // Stages the last frame skipped. The display pass always runs, so an
+    // idle frame with both skipped only re-applies the exposure.
+    bool wasTraceSkipped() const { return m_traceSkipped; }
+    bool wasShadeSkipped() const { return m_shadeSkipped; }
+    const RenderStageStats& getStageStats() const { return m_stageStats; }
     
 private:
+    // Everything the geodesic G-buffer (or the CPU trace) depends on.
+    // Frames with equal inputs reuse it.
+    struct TraceInputs {
+        glm::vec3 cameraPos;
+        glm::vec3 cameraTarget;
+        glm::vec3 cameraUp;
+        float fov;
+        float aspectRatio;
+        float mass;
+        float spin;
+        glm::vec3 blackHolePos;
+        float diskInnerRadius;
+        float diskOuterRadius;
+        bool showAccretionDisk;
+        bool showPhotonSphere;
+        GeodesicIntegrator integrator;
+        int quality;
+        bool useSchwarzschildFastPath;
+        bool useShadowCulling;
+        float influenceRadius;
+        
+        bool operator==(const TraceInputs& other) const;
+    };
+    
+    // Inputs of the shading pass on top of the G-buffer
+    struct ShadeInputs {
+        float schwarzschildRadius;
+        float diskInnerRadius;
+        float diskOuterRadius;
+        float animationPhase;   // Rotation speed x time
+        int skyVersion;         // Bumped whenever a sky map stage lands
+        
+        bool operator==(const ShadeInputs& other) const;
+    };
+    
+
     void createFullscreenQuad();
     void loadShaders();
-    void generateStarfield();
+    void readStepStats();
+    int beginStepStats();
+    void invalidateFrame();
+    void traceGBuffer(const Core::Camera& camera,
+                      const Physics::BlackHole& blackHole,
+                      const Physics::AccretionDisk& disk,
+                      const glm::vec2& jitter);
+    void shadeGBuffer(const Physics::BlackHole& blackHole,
+                      const Physics::AccretionDisk& disk,
+                      int sampleIndex);
+    void accumulateCpuFrame(int sampleIndex);
+    void updateRenderTargets();
+    void readTraceTimer();
+    void adjustRenderScale(double traceTime, float measuredScale);
+    void recordTierTraceTime(int quality, double traceTime, float scale);
+    void pollShaders();
+    Core::Shader* selectRayTracerVariant();
+    static bool isShaderReady(const Core::Shader* shader);
+    void updateLensingTable(float mass, float cameraRadius);
     
     int m_width;
     int m_height;
@@ -64,23 +234,105 @@ private:
     bool m_showEventHorizon;
     bool m_showPhotonSphere;
     bool m_showAccretionDisk;
+    bool m_useCpuTracer;
     float m_exposure;
+    GeodesicIntegrator m_integrator;
+    bool m_useSchwarzschildFastPath;
+    bool m_useShadowCulling;
+    float m_influenceRadius;
+    bool m_lensingActive;
+    bool m_useLensingMapCache;
+    float m_animationTime;
+    bool m_lensingMapPreview;
+    
+    // Dirty-state tracking: stages re-run only when their inputs change
+    TraceInputs m_lastTraceInputs;
+    ShadeInputs m_lastShadeInputs;
+    bool m_traceValid;
+    bool m_shadeValid;
+    bool m_traceSkipped;
+    bool m_shadeSkipped;
+    RenderStageStats m_stageStats;
+    
+    // Progressive accumulation
+    bool m_progressive;
+    int m_maxSamples;
+    int m_sampleCount;                     // Samples in the history
+    std::vector<float> m_cpuHistory;       // Sum of the CPU tracer's samples
+    std::vector<float> m_cpuAverage;
+    
+    // Dynamic resolution
+    bool m_dynamicResolution;
+    bool m_interacting;
+    float m_targetFrameTime;     // Milliseconds for trace + shade
+    float m_renderScale;         // Scale the budget allows
+    int m_renderWidth;           // Size of the trace targets
+    int m_renderHeight;
+    double m_traceTime;
+    
+    // Render scale and tier of recently traced frames, for matching the
+    // profiler's delayed ray march results to what they measured
+    struct TimedFrame {
+        unsigned long long frame;
+        float scale;
+        int quality;
+    };
+    static constexpr int TIMED_FRAME_COUNT = 4;
+    TimedFrame m_timedFrames[TIMED_FRAME_COUNT];
+    unsigned long long m_lastTimedFrame;   // Profiler frame of the last result used
+    double m_tierTraceTime[QUALITY_TIER_COUNT];
+    float m_tierTraceScale[QUALITY_TIER_COUNT];
     
     // OpenGL objects
     unsigned int m_quadVAO;
     unsigned int m_quadVBO;
     
+    // Step counters written by raytracer.comp (low word, high word, max),
+    // one persistently mapped SSBO per trace in flight. A slot is read once
+    // its fence has signalled, so the render thread never waits on it.
+    struct StepStatsSlot {
+        unsigned int buffer;
+        const unsigned int* mapped;
+        void* fence;          // GLsync after the trace that used it, null once read
+        long long pixels;     // Pixels of that trace
+    };
+    static constexpr int STEP_STATS_SLOTS = 3;
+    StepStatsSlot m_stepStatsSlots[STEP_STATS_SLOTS];
+    int m_stepStatsSlot;                 // Slot of the latest trace
+    StepStats m_gpuStepStats;
+    unsigned int m_lensingBuffer;    // SchwarzschildLensing table for raytracer.comp
+    unsigned int m_shadowBuffer;     // ShadowProfile radii for raytracer.comp
+    std::unique_ptr<UniformBuffer> m_traceParams;  // TraceParams block of raytracer.comp
+    
     // Shaders
-    std::unique_ptr<Core::Shader> m_rayTracerShader;
+    std::unique_ptr<Core::Shader> m_rayTracerVariants[QUALITY_TIER_COUNT];  // One per quality tier
+    Core::Shader* m_rayTracerShader;                                       // Variant traced with this frame
+    int m_tracedQuality;                                                   // Its tier
+    bool m_shadersReady;                                                   // Nothing left compiling
+    std::chrono::steady_clock::time_point m_shaderLoadStart;
+    std::unique_ptr<Core::Shader> m_shadeShader;
     std::unique_ptr<Core::Shader> m_displayShader;
     std::unique_ptr<Core::Shader> m_postProcessShader;
     
     // Textures
     std::unique_ptr<Texture> m_outputTexture;
-    std::unique_ptr<Texture> m_starfieldTexture;
+    std::unique_ptr<Texture> m_gbufferTexture;   // RGBA32F, written by raytracer.comp
+    std::unique_ptr<Texture> m_historyTexture;   // RGBA32F sample sum, written by shade.comp
+    std::unique_ptr<Texture> m_dopplerLutTexture;  // Physics::EmissionTables, read by shade.comp
+    std::unique_ptr<SkyMap> m_skyMap;              // Cubemap sky, streamed in the background
+    int m_skyVersion;
     
     // Post-processing
     std::unique_ptr<PostProcess> m_postProcess;
+    
+    // CPU fallback for machines without a usable GPU
+    std::unique_ptr<CpuRayTracer> m_cpuTracer;
+    std::unique_ptr<GpuProfiler> m_profiler;
+    std::unique_ptr<LensingMapCache> m_lensingMapCache;
+    
+    // Lensing table of the compute path (the CPU tracer keeps its own)
+    std::unique_ptr<Physics::SchwarzschildLensing> m_lensing;
+    std::unique_ptr<ShadowProfile> m_shadowProfile;
 };
 
 } // namespace Rendering
@@ -0,0 +1,100 @@
+#include "ShadowProfile.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Rendering {
+
+namespace {
+
+// Contour directions must lie this far in front of the camera (cosine)
+constexpr float MIN_FORWARD = 0.05f;
+
+// Inset of the curve: covers the marched rays' own error near the edge,
+// the bins' linear interpolation and sub-pixel jitter
+constexpr float INSET_PIXELS = 2.0f;
+constexpr float INSET_FRACTION = 0.01f;
+
+} // namespace
+
+ShadowProfile::ShadowProfile()
+    : m_valid(false)
+    , m_center(0.0f)
+    , m_radii(BIN_COUNT, 0.0f) {
+}
+
+bool ShadowProfile::build(const std::vector<glm::vec3>& contour, const glm::vec3& forward,
+                          const glm::vec3& right, const glm::vec3& up, float pixelSize) {
+    clear();
+    if (contour.size() < 3) {
+        return false;
+    }
+
+    std::vector<glm::vec2> points;
+    points.reserve(contour.size());
+    glm::vec2 center(0.0f);
+    for (const glm::vec3& direction : contour) {
+        float depth = glm::dot(direction, forward);
+        if (depth < MIN_FORWARD) {
+            return false;
+        }
+        points.emplace_back(glm::dot(direction, right) / depth, glm::dot(direction, up) / depth);
+        center += points.back();
+    }
+    center /= static_cast<float>(points.size());
+
+    // Nearest crossing of each bin's ray with the polygon, so a slightly
+    // non-convex curve still gives a region inside it
+    for (int bin = 0; bin < BIN_COUNT; ++bin) {
+        float angle = glm::two_pi<float>() * bin / BIN_COUNT;
+        glm::vec2 ray(std::cos(angle), std::sin(angle));
+        float radius = std::numeric_limits<float>::max();
+        for (size_t i = 0; i < points.size(); ++i) {
+            glm::vec2 p0 = points[i] - center;
+            glm::vec2 edge = points[(i + 1) % points.size()] - points[i];
+            float denom = ray.x * edge.y - ray.y * edge.x;
+            if (std::abs(denom) < 1e-12f) {
+                continue;
+            }
+            float t = (p0.x * edge.y - p0.y * edge.x) / denom;
+            float s = (p0.x * ray.y - p0.y * ray.x) / denom;
+            if (t > 0.0f && s >= 0.0f && s <= 1.0f) {
+                radius = std::min(radius, t);
+            }
+        }
+        if (radius == std::numeric_limits<float>::max()) {
+            clear();
+            return false;
+        }
+        m_radii[bin] = std::max(radius * (1.0f - INSET_FRACTION) - INSET_PIXELS * pixelSize, 0.0f);
+    }
+
+    m_center = center;
+    m_valid = true;
+    return true;
+}
+
+void ShadowProfile::clear() {
+    m_valid = false;
+    m_center = glm::vec2(0.0f);
+    std::fill(m_radii.begin(), m_radii.end(), 0.0f);
+}
+
+bool ShadowProfile::contains(const glm::vec2& point) const {
+    if (!m_valid) {
+        return false;
+    }
+    glm::vec2 d = point - m_center;
+    float bin = std::atan2(d.y, d.x) / glm::two_pi<float>() * BIN_COUNT;
+    if (bin < 0.0f) {
+        bin += BIN_COUNT;
+    }
+    int i0 = std::min(static_cast<int>(bin), BIN_COUNT - 1);
+    int i1 = (i0 + 1) % BIN_COUNT;
+    float t = bin - i0;
+    float radius = m_radii[i0] + t * (m_radii[i1] - m_radii[i0]);
+    return glm::dot(d, d) < radius * radius;
+}
+
+} // namespace Rendering
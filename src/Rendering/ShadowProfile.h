@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Rendering {
+
+// Shadow of the black hole on a camera's image plane, used to skip pixels
+// whose rays are certain to fall in. Image-plane points are a ray
+// direction's right and up components over its forward one, i.e.
+// uv * tan(fov / 2) in the ray tracers' pixel mapping. The critical curve
+// is convex, so it is kept as its radius about the centroid in BIN_COUNT
+// equal angle bins, pulled in by a safety inset (shadowRadii in
+// raytracer.comp).
+class ShadowProfile {
+public:
+    static constexpr int BIN_COUNT = 256;
+
+    ShadowProfile();
+
+    // Project a contour from Physics::BlackHole::getShadowContour for a
+    // camera with the given basis; pixelSize is one pixel in image-plane
+    // units. Fails, leaving the profile empty, if the contour is empty or
+    // reaches towards the edge of the view hemisphere.
+    bool build(const std::vector<glm::vec3>& contour, const glm::vec3& forward,
+               const glm::vec3& right, const glm::vec3& up, float pixelSize);
+    void clear();
+
+    bool isValid() const { return m_valid; }
+
+    // Whether an image-plane point lies inside the inset curve
+    bool contains(const glm::vec2& point) const;
+
+    const glm::vec2& getCenter() const { return m_center; }
+    const std::vector<float>& getRadii() const { return m_radii; }
+
+private:
+    bool m_valid;
+    glm::vec2 m_center;
+    std::vector<float> m_radii;
+};
+
+} // namespace Rendering
@@ -0,0 +1,173 @@
+#pragma once
+
+// Thin wrappers over SIMD registers used by the ray packet kernel.
+// Each wrapper exposes the same small set of operations so that
+// RayPacketKernel.inl can be instantiated once per instruction set.
+// Only the wrappers enabled by the current translation unit's compiler
+// flags are defined. Everything lives in an anonymous namespace so that
+// code built with wider instruction sets never leaks into other units.
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define BH_SIMD_HAS_SSE 1
+#endif
+
+namespace Rendering {
+namespace Simd {
+namespace {
+
+// ---------------------------------------------------------------------------
+// Scalar (1 lane) - reference path and fallback on non-x86 targets
+// ---------------------------------------------------------------------------
+struct Float1 {
+    static constexpr int Width = 1;
+    float v;
+};
+struct Mask1 {
+    bool v;
+};
+
+inline Float1 broadcast(float x, Float1) { return { x }; }
+inline Float1 load(const float* p, Float1) { return { *p }; }
+inline void store(float* p, Float1 a) { *p = a.v; }
+
+inline Float1 operator+(Float1 a, Float1 b) { return { a.v + b.v }; }
+inline Float1 operator-(Float1 a, Float1 b) { return { a.v - b.v }; }
+inline Float1 operator*(Float1 a, Float1 b) { return { a.v * b.v }; }
+inline Float1 operator/(Float1 a, Float1 b) { return { a.v / b.v }; }
+inline Float1 operator-(Float1 a) { return { -a.v }; }
+inline Float1 sqrt(Float1 a) { return { std::sqrt(a.v) }; }
+inline Float1 abs(Float1 a) { return { std::abs(a.v) }; }
+
+inline Mask1 operator<(Float1 a, Float1 b) { return { a.v < b.v }; }
+inline Mask1 operator>(Float1 a, Float1 b) { return { a.v > b.v }; }
+inline Mask1 operator<=(Float1 a, Float1 b) { return { a.v <= b.v }; }
+inline Mask1 operator>=(Float1 a, Float1 b) { return { a.v >= b.v }; }
+inline Mask1 operator&(Mask1 a, Mask1 b) { return { a.v && b.v }; }
+inline Mask1 operator|(Mask1 a, Mask1 b) { return { a.v || b.v }; }
+inline Mask1 andNot(Mask1 a, Mask1 b) { return { a.v && !b.v }; }  // a & ~b
+
+inline Float1 select(Mask1 m, Float1 a, Float1 b) { return m.v ? a : b; }
+inline int bits(Mask1 m) { return m.v ? 1 : 0; }
+inline Mask1 allTrue(Float1) { return { true }; }
+
+#ifdef BH_SIMD_HAS_SSE
+// ---------------------------------------------------------------------------
+// SSE2 (4 lanes)
+// ---------------------------------------------------------------------------
+struct Float4 {
+    static constexpr int Width = 4;
+    __m128 v;
+};
+struct Mask4 {
+    __m128 v;
+};
+
+inline Float4 broadcast(float x, Float4) { return { _mm_set1_ps(x) }; }
+inline Float4 load(const float* p, Float4) { return { _mm_loadu_ps(p) }; }
+inline void store(float* p, Float4 a) { _mm_storeu_ps(p, a.v); }
+
+inline Float4 operator+(Float4 a, Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+inline Float4 operator-(Float4 a, Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline Float4 operator*(Float4 a, Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline Float4 operator/(Float4 a, Float4 b) { return { _mm_div_ps(a.v, b.v) }; }
+inline Float4 operator-(Float4 a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+inline Float4 sqrt(Float4 a) { return { _mm_sqrt_ps(a.v) }; }
+inline Float4 abs(Float4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+
+inline Mask4 operator<(Float4 a, Float4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline Mask4 operator>(Float4 a, Float4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline Mask4 operator<=(Float4 a, Float4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+inline Mask4 operator>=(Float4 a, Float4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline Mask4 operator&(Mask4 a, Mask4 b) { return { _mm_and_ps(a.v, b.v) }; }
+inline Mask4 operator|(Mask4 a, Mask4 b) { return { _mm_or_ps(a.v, b.v) }; }
+inline Mask4 andNot(Mask4 a, Mask4 b) { return { _mm_andnot_ps(b.v, a.v) }; }
+
+inline Float4 select(Mask4 m, Float4 a, Float4 b) {
+    return { _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)) };
+}
+inline int bits(Mask4 m) { return _mm_movemask_ps(m.v); }
+inline Mask4 allTrue(Float4) { return { _mm_castsi128_ps(_mm_set1_epi32(-1)) }; }
+#endif
+
+#ifdef __AVX2__
+// ---------------------------------------------------------------------------
+// AVX2 (8 lanes)
+// ---------------------------------------------------------------------------
+struct Float8 {
+    static constexpr int Width = 8;
+    __m256 v;
+};
+struct Mask8 {
+    __m256 v;
+};
+
+inline Float8 broadcast(float x, Float8) { return { _mm256_set1_ps(x) }; }
+inline Float8 load(const float* p, Float8) { return { _mm256_loadu_ps(p) }; }
+inline void store(float* p, Float8 a) { _mm256_storeu_ps(p, a.v); }
+
+inline Float8 operator+(Float8 a, Float8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline Float8 operator-(Float8 a, Float8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline Float8 operator*(Float8 a, Float8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline Float8 operator/(Float8 a, Float8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline Float8 operator-(Float8 a) { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)) }; }
+inline Float8 sqrt(Float8 a) { return { _mm256_sqrt_ps(a.v) }; }
+inline Float8 abs(Float8 a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+
+inline Mask8 operator<(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline Mask8 operator>(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline Mask8 operator<=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline Mask8 operator>=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline Mask8 operator&(Mask8 a, Mask8 b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline Mask8 operator|(Mask8 a, Mask8 b) { return { _mm256_or_ps(a.v, b.v) }; }
+inline Mask8 andNot(Mask8 a, Mask8 b) { return { _mm256_andnot_ps(b.v, a.v) }; }
+
+inline Float8 select(Mask8 m, Float8 a, Float8 b) { return { _mm256_blendv_ps(b.v, a.v, m.v) }; }
+inline int bits(Mask8 m) { return _mm256_movemask_ps(m.v); }
+inline Mask8 allTrue(Float8) { return { _mm256_castsi256_ps(_mm256_set1_epi32(-1)) }; }
+#endif
+
+#ifdef __AVX512F__
+// ---------------------------------------------------------------------------
+// AVX-512F (16 lanes)
+// ---------------------------------------------------------------------------
+struct Float16 {
+    static constexpr int Width = 16;
+    __m512 v;
+};
+struct Mask16 {
+    __mmask16 v;
+};
+
+inline Float16 broadcast(float x, Float16) { return { _mm512_set1_ps(x) }; }
+inline Float16 load(const float* p, Float16) { return { _mm512_loadu_ps(p) }; }
+inline void store(float* p, Float16 a) { _mm512_storeu_ps(p, a.v); }
+
+inline Float16 operator+(Float16 a, Float16 b) { return { _mm512_add_ps(a.v, b.v) }; }
+inline Float16 operator-(Float16 a, Float16 b) { return { _mm512_sub_ps(a.v, b.v) }; }
+inline Float16 operator*(Float16 a, Float16 b) { return { _mm512_mul_ps(a.v, b.v) }; }
+inline Float16 operator/(Float16 a, Float16 b) { return { _mm512_div_ps(a.v, b.v) }; }
+inline Float16 operator-(Float16 a) {
+    return { _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a.v), _mm512_set1_epi32(static_cast<int>(0x80000000u)))) };
+}
+inline Float16 sqrt(Float16 a) { return { _mm512_sqrt_ps(a.v) }; }
+inline Float16 abs(Float16 a) { return { _mm512_abs_ps(a.v) }; }
+
+inline Mask16 operator<(Float16 a, Float16 b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ) }; }
+inline Mask16 operator>(Float16 a, Float16 b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ) }; }
+inline Mask16 operator<=(Float16 a, Float16 b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ) }; }
+inline Mask16 operator>=(Float16 a, Float16 b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ) }; }
+inline Mask16 operator&(Mask16 a, Mask16 b) { return { static_cast<__mmask16>(a.v & b.v) }; }
+inline Mask16 operator|(Mask16 a, Mask16 b) { return { static_cast<__mmask16>(a.v | b.v) }; }
+inline Mask16 andNot(Mask16 a, Mask16 b) { return { static_cast<__mmask16>(a.v & ~b.v) }; }
+
+inline Float16 select(Mask16 m, Float16 a, Float16 b) { return { _mm512_mask_blend_ps(m.v, b.v, a.v) }; }
+inline int bits(Mask16 m) { return static_cast<int>(m.v); }
+inline Mask16 allTrue(Float16) { return { static_cast<__mmask16>(0xFFFF) }; }
+#endif
+
+} // namespace
+} // namespace Simd
+} // namespace Rendering
@@ -0,0 +1,364 @@
+#include "SkyMap.h"
+#include "EquirectImage.h"
+#include "../Core/Profiler.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace Rendering {
+
+namespace {
+
+// Face sizes of the preview stages; the last stage is always the full size
+constexpr int STAGE_FACE_SIZES[] = { 64, 512 };
+
+// Samples per texel edge, enough to cover up to 4 x 4 image pixels
+constexpr int MAX_SUPERSAMPLES = 4;
+
+// Finished faces the worker may queue ahead of the uploads
+constexpr size_t MAX_QUEUED_BYTES = size_t(128) << 20;
+
+// Texel data uploaded per frame; larger levels go up in row strips
+constexpr size_t UPLOAD_BYTES_PER_FRAME = size_t(8) << 20;
+
+int log2Int(int value) {
+    int log = 0;
+    while ((1 << (log + 1)) <= value) {
+        ++log;
+    }
+    return log;
+}
+
+// Levels of the stages, coarsest first
+std::vector<int> stageLevels(int faceSize) {
+    std::vector<int> levels;
+    for (int size : STAGE_FACE_SIZES) {
+        if (size < faceSize) {
+            levels.push_back(log2Int(faceSize / size));
+        }
+    }
+    levels.push_back(0);
+    return levels;
+}
+
+// Direction through (a, b) in [-1, 1]^2 on a face, in GL cubemap order
+// (+X, -X, +Y, -Y, +Z, -Z) with b growing down the face's rows
+glm::vec3 faceDirection(int face, float a, float b) {
+    switch (face) {
+    case 0:  return glm::vec3(1.0f, -b, -a);
+    case 1:  return glm::vec3(-1.0f, -b, a);
+    case 2:  return glm::vec3(a, 1.0f, b);
+    case 3:  return glm::vec3(a, -1.0f, -b);
+    case 4:  return glm::vec3(a, -b, 1.0f);
+    default: return glm::vec3(-a, -b, -1.0f);
+    }
+}
+
+// 2 x 2 box filter of a size x size RGB face
+std::vector<float> downsample(const std::vector<float>& src, int size) {
+    int half = size / 2;
+    std::vector<float> dst(static_cast<size_t>(half) * half * 3);
+    for (int y = 0; y < half; ++y) {
+        const float* row0 = src.data() + static_cast<size_t>(2 * y) * size * 3;
+        const float* row1 = row0 + static_cast<size_t>(size) * 3;
+        float* out = dst.data() + static_cast<size_t>(y) * half * 3;
+        for (int x = 0; x < half; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                out[x * 3 + c] = 0.25f * (row0[(2 * x) * 3 + c] + row0[(2 * x + 1) * 3 + c]
+                                        + row1[(2 * x) * 3 + c] + row1[(2 * x + 1) * 3 + c]);
+            }
+        }
+    }
+    return dst;
+}
+
+// Texels in the texture's own format, so the driver uploads them as they are
+std::vector<unsigned int> pack(const std::vector<float>& rgb) {
+    std::vector<unsigned int> texels(rgb.size() / 3);
+    for (size_t i = 0; i < texels.size(); ++i) {
+        texels[i] = glm::packF2x11_1x10(glm::vec3(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]));
+    }
+    return texels;
+}
+
+} // namespace
+
+SkyMap::SkyMap()
+    : m_texture(0)
+    , m_faceSize(0)
+    , m_levelCount(0)
+    , m_visibleLevel(-1)
+    , m_uploadedTexels(0)
+    , m_totalTexels(0)
+    , m_cancel(false)
+    , m_queuedBytes(0)
+    , m_workerDone(true)
+    , m_pendingFaceSize(0) {
+}
+
+SkyMap::~SkyMap() {
+    stop();
+    if (m_texture) {
+        glDeleteTextures(1, &m_texture);
+    }
+}
+
+void SkyMap::load(const std::string& path, int maxFaceSize) {
+    start(path, std::max(maxFaceSize, 1));
+}
+
+void SkyMap::start(const std::string& path, int maxFaceSize) {
+    stop();
+    m_workerDone = false;
+    m_worker = std::thread(&SkyMap::run, this, path, maxFaceSize);
+}
+
+void SkyMap::stop() {
+    if (m_worker.joinable()) {
+        {
+            // Under the mutex, so a push() about to wait cannot miss it
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cancel = true;
+        }
+        m_spaceAvailable.notify_all();
+        m_worker.join();
+        m_cancel = false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.clear();
+    m_queuedBytes = 0;
+    m_workerDone = true;
+    m_pendingFaceSize = 0;
+}
+
+bool SkyMap::isLoading() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_workerDone || !m_queue.empty() || m_pendingFaceSize > 0;
+}
+
+void SkyMap::bind(unsigned int slot) const {
+    glActiveTexture(GL_TEXTURE0 + slot);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
+}
+
+float SkyMap::getTexelAngle() const {
+    return m_faceSize > 0 ? glm::half_pi<float>() / m_faceSize : 0.0f;
+}
+
+float SkyMap::getProgress() const {
+    return m_totalTexels > 0 ? static_cast<float>(m_uploadedTexels) / m_totalTexels : 0.0f;
+}
+
+void SkyMap::createTexture(int faceSize) {
+    if (m_texture) {
+        glDeleteTextures(1, &m_texture);
+    }
+    m_faceSize = faceSize;
+    m_levelCount = log2Int(faceSize) + 1;
+    m_visibleLevel = -1;
+    m_uploadedTexels = 0;
+    m_totalTexels = 0;
+    for (int stage : stageLevels(faceSize)) {
+        for (int level = stage; level < m_levelCount; ++level) {
+            long long size = faceSize >> level;
+            m_totalTexels += 6 * size * size;
+        }
+    }
+
+    // Packed 11/11/10-bit floats: a quarter of RGBA32F with enough range for HDR skies
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, m_levelCount, GL_R11F_G11F_B10F, faceSize, faceSize);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, m_levelCount - 1);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+}
+
+bool SkyMap::update() {
+    PROFILE_ZONE("SkyMap::update");
+    bool changed = false;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // A newly opened image replaces the texture; until its first stage is
+    // in, the shader falls back to the procedural sky
+    if (m_pendingFaceSize > 0) {
+        m_name = m_pendingName;
+        int faceSize = m_pendingFaceSize;
+        m_pendingFaceSize = 0;
+        lock.unlock();
+        createTexture(faceSize);
+        lock.lock();
+        changed = true;
+    }
+
+    size_t budget = UPLOAD_BYTES_PER_FRAME;
+    while (budget > 0 && !m_queue.empty()) {
+        // The worker only appends, so the front stays put while unlocked
+        FaceLevel& item = m_queue.front();
+        lock.unlock();
+
+        size_t rowBytes = static_cast<size_t>(item.size) * sizeof(unsigned int);
+        int rows = static_cast<int>(std::min<size_t>(item.size - item.uploadedRows,
+                                                     std::max<size_t>(budget / rowBytes, 1)));
+        glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + item.face, item.level, 0, item.uploadedRows,
+                        item.size, rows, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV,
+                        item.texels.data() + static_cast<size_t>(item.uploadedRows) * item.size);
+        item.uploadedRows += rows;
+        budget -= std::min(budget, rows * rowBytes);
+        m_uploadedTexels += static_cast<long long>(rows) * item.size;
+
+        bool finished = item.uploadedRows == item.size;
+        if (finished && item.completedLevel >= 0) {
+            // Every face has the stage's level and all coarser ones: sample from there down
+            m_visibleLevel = item.completedLevel;
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, m_visibleLevel);
+            changed = true;
+            if (m_visibleLevel == 0) {
+                std::cout << "Sky map " << m_name << ": " << m_faceSize << "x" << m_faceSize
+                          << " faces, " << m_levelCount << " levels" << std::endl;
+            }
+        }
+
+        lock.lock();
+        if (finished) {
+            m_queuedBytes -= item.texels.size() * sizeof(unsigned int);
+            m_queue.pop_front();
+            m_spaceAvailable.notify_one();
+        }
+    }
+    return changed;
+}
+
+void SkyMap::run(const std::string& path, int maxFaceSize) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    EquirectImage image;
+    if (!image.open(path)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_workerDone = true;
+        return;
+    }
+
+    // About one image pixel per face texel: a quarter of the width,
+    // rounded down to a power of two
+    int target = std::min(maxFaceSize, std::max(image.getWidth() / 4, 1));
+    int faceSize = 1 << log2Int(target);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingName = path;
+        m_pendingFaceSize = faceSize;
+    }
+
+    int levelCount = log2Int(faceSize) + 1;
+    bool complete = true;
+    for (int level : stageLevels(faceSize)) {
+        if (!buildStage(image, faceSize, levelCount, level)) {
+            complete = false;
+            break;
+        }
+    }
+
+    if (complete) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << "Resampled " << path << " (" << image.getWidth() << "x" << image.getHeight()
+                  << ") in " << seconds << " s" << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_workerDone = true;
+}
+
+bool SkyMap::buildStage(EquirectImage& image, int faceSize, int levelCount, int level) {
+    int size = faceSize >> level;
+    int width = image.getWidth();
+    int height = image.getHeight();
+
+    // Box filter over the image pixels a texel covers (at a face centre)
+    int samples = static_cast<int>(std::ceil(width / (4.0f * size)));
+    samples = std::clamp(samples, 1, MAX_SUPERSAMPLES);
+    float sampleStep = 1.0f / samples;
+
+    std::vector<int> order(static_cast<size_t>(size) * size);
+    std::vector<int> rowStart(height + 1);
+    std::vector<int> texelRow(order.size());
+
+    for (int face = 0; face < 6; ++face) {
+        // Visit texels in the order of the image rows they read, so the
+        // row cache of the image streams through it about once per face
+        std::fill(rowStart.begin(), rowStart.end(), 0);
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                glm::vec3 dir = glm::normalize(faceDirection(face, 2.0f * (x + 0.5f) / size - 1.0f,
+                                                                   2.0f * (y + 0.5f) / size - 1.0f));
+                float v = std::acos(glm::clamp(dir.y, -1.0f, 1.0f)) / glm::pi<float>();
+                int row = std::min(static_cast<int>(v * height), height - 1);
+                texelRow[y * size + x] = row;
+                ++rowStart[row + 1];
+            }
+        }
+        for (int row = 0; row < height; ++row) {
+            rowStart[row + 1] += rowStart[row];
+        }
+        for (int texel = 0; texel < size * size; ++texel) {
+            order[rowStart[texelRow[texel]]++] = texel;
+        }
+
+        std::vector<float> rgb(static_cast<size_t>(size) * size * 3);
+        for (int texel : order) {
+            int x = texel % size;
+            int y = texel / size;
+            glm::vec3 sum(0.0f);
+            for (int j = 0; j < samples; ++j) {
+                float b = 2.0f * (y + (j + 0.5f) * sampleStep) / size - 1.0f;
+                for (int i = 0; i < samples; ++i) {
+                    float a = 2.0f * (x + (i + 0.5f) * sampleStep) / size - 1.0f;
+                    sum += image.sample(faceDirection(face, a, b));
+                }
+            }
+            sum /= static_cast<float>(samples * samples);
+            rgb[texel * 3 + 0] = sum.r;
+            rgb[texel * 3 + 1] = sum.g;
+            rgb[texel * 3 + 2] = sum.b;
+            if (m_cancel) {
+                return false;
+            }
+        }
+
+        // The rest of the mip chain of this face
+        for (int mip = level, mipSize = size; mip < levelCount; ++mip, mipSize /= 2) {
+            int completedLevel = face == 5 && mip + 1 == levelCount ? level : -1;
+            if (!push(FaceLevel{ face, mip, mipSize, completedLevel, 0, pack(rgb) })) {
+                return false;
+            }
+            if (mip + 1 < levelCount) {
+                rgb = downsample(rgb, mipSize);
+            }
+        }
+    }
+    return true;
+}
+
+bool SkyMap::push(FaceLevel item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_spaceAvailable.wait(lock, [this] { return m_cancel || m_queuedBytes < MAX_QUEUED_BYTES; });
+    if (m_cancel) {
+        return false;
+    }
+    m_queuedBytes += item.texels.size() * sizeof(unsigned int);
+    m_queue.push_back(std::move(item));
+    return true;
+}
+
+} // namespace Rendering
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Rendering {
+
+class EquirectImage;
+
+// Cubemap sky streamed in from an equirectangular image.
+//
+// A worker thread resamples the image into cube faces in stages of
+// increasing face size (64, 512, then the full size), each with its whole
+// mip chain, so a blurry sky shows up almost at once and sharpens as the
+// larger stages arrive. update() uploads finished faces on the GL thread
+// within a per-frame byte budget and lowers the texture's base level
+// whenever a stage is complete. The image is read through EquirectImage,
+// so a 16K map is never held in memory at full resolution.
+class SkyMap {
+public:
+    static constexpr int DEFAULT_MAX_FACE_SIZE = 2048;
+
+    SkyMap();
+    ~SkyMap();
+
+    SkyMap(const SkyMap&) = delete;
+    SkyMap& operator=(const SkyMap&) = delete;
+
+    // Start streaming an image file (.hdr, .pfm; other formats through
+    // stb_image) with faces of at most maxFaceSize texels. The file is
+    // opened on the worker; if that fails the current sky stays.
+    void load(const std::string& path, int maxFaceSize = DEFAULT_MAX_FACE_SIZE);
+
+    // Upload finished faces (GL thread, once per frame). Returns true when
+    // what the sky looks like changed.
+    bool update();
+
+    // Some stage is complete and the texture can be sampled
+    bool isReady() const { return m_visibleLevel >= 0; }
+
+    // Faces are still being built or uploaded
+    bool isLoading() const;
+
+    void bind(unsigned int slot) const;
+
+    const std::string& getName() const { return m_name; }
+    int getFaceSize() const { return m_faceSize; }
+    int getLevelCount() const { return m_levelCount; }
+    int getVisibleFaceSize() const { return m_visibleLevel >= 0 ? m_faceSize >> m_visibleLevel : 0; }
+
+    // Angle subtended by one texel of the finest level at a face centre
+    float getTexelAngle() const;
+
+    // Fraction of the final stage uploaded
+    float getProgress() const;
+
+private:
+    // One mip level of one face, filled by the worker
+    struct FaceLevel {
+        int face;
+        int level;
+        int size;
+        int completedLevel;       // Base level once this upload is in (last of its stage), else -1
+        int uploadedRows;
+        std::vector<unsigned int> texels;   // Packed R11F_G11F_B10F
+    };
+
+    void start(const std::string& path, int maxFaceSize);
+    void stop();
+    void createTexture(int faceSize);
+    void run(const std::string& path, int maxFaceSize);
+    bool buildStage(EquirectImage& image, int faceSize, int levelCount, int level);
+    bool push(FaceLevel item);
+
+    unsigned int m_texture;
+    std::string m_name;
+    int m_faceSize;
+    int m_levelCount;
+    int m_visibleLevel;           // Base level of the texture, -1 until a stage is in
+    long long m_uploadedTexels;
+    long long m_totalTexels;      // Of all stages
+
+    std::thread m_worker;
+    std::atomic<bool> m_cancel;
+
+    // Shared with the worker
+    mutable std::mutex m_mutex;
+    std::condition_variable m_spaceAvailable;
+    std::deque<FaceLevel> m_queue;
+    size_t m_queuedBytes;
+    bool m_workerDone;
+    std::string m_pendingName;    // Opened image waiting for its texture
+    int m_pendingFaceSize;
+};
+
+} // namespace Rendering
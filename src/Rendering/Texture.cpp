@@ -12,7 +12,8 @@ Texture::Texture()
     , m_width(0)
     , m_height(0)
     , m_channels(0)
-    , m_isHDR(false) {
+    , m_isHDR(false)
+    , m_imageFormat(GL_RGBA8) {
 }
 
 Texture::~Texture() {
@@ -73,7 +74,12 @@ bool Texture::create(int width, int height, int channels, bool hdr) {
     m_height = height;
     m_channels = channels;
     m_isHDR = hdr;
+    m_imageFormat = hdr ? GL_RGBA16F : GL_RGBA8;
     
+    // Re-creating (e.g. on resize) replaces the previous texture
+    if (m_textureID) {
+        glDeleteTextures(1, &m_textureID);
+    }
     glGenTextures(1, &m_textureID);
     glBindTexture(GL_TEXTURE_2D, m_textureID);
     
@@ -96,6 +102,40 @@ bool Texture::create(int width, int height, int channels, bool hdr) {
     return true;
 }
 
+bool Texture::createFloat(int width, int height) {
+    m_width = width;
+    m_height = height;
+    m_channels = 4;
+    m_isHDR = true;
+    m_imageFormat = GL_RGBA32F;
+    
+    if (m_textureID) {
+        glDeleteTextures(1, &m_textureID);
+    }
+    glGenTextures(1, &m_textureID);
+    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    
+    // Texels hold data rather than colour, so never interpolate them
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    
+    return true;
+}
+
+void Texture::update(const void* data) {
+    GLenum format = (m_channels == 3) ? GL_RGB : GL_RGBA;
+    GLenum type = m_isHDR ? GL_FLOAT : GL_UNSIGNED_BYTE;
+    
+    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, format, type, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 void Texture::bind(unsigned int slot) const {
     glActiveTexture(GL_TEXTURE0 + slot);
     glBindTexture(GL_TEXTURE_2D, m_textureID);
@@ -106,8 +146,7 @@ void Texture::unbind() const {
 }
 
 void Texture::bindImage(unsigned int slot, unsigned int access) const {
-    GLenum format = m_isHDR ? GL_RGBA16F : GL_RGBA8;
-    glBindImageTexture(slot, m_textureID, 0, GL_FALSE, 0, access, format);
+    glBindImageTexture(slot, m_textureID, 0, GL_FALSE, 0, access, m_imageFormat);
 }
 
 } // namespace Rendering
@@ -15,6 +15,12 @@ public:
     // Create empty texture
     bool create(int width, int height, int channels, bool hdr = false);
     
+    // Create an unfiltered RGBA32F texture (compute shader intermediates)
+    bool createFloat(int width, int height);
+    
+    // Upload pixel data covering the whole texture (RGBA float for HDR textures)
+    void update(const void* data);
+    
     // Bind texture
     void bind(unsigned int slot = 0) const;
     void unbind() const;
@@ -34,6 +40,7 @@ private:
     int m_height;
     int m_channels;
     bool m_isHDR;
+    unsigned int m_imageFormat;  // Format used by bindImage
 };
 
 } // namespace Rendering
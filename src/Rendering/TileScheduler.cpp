@@ -0,0 +1,267 @@
+#include "TileScheduler.h"
+#include "../Core/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace Rendering {
+
+namespace {
+
+// Spread the lower 16 bits of v so that there is a zero bit between each
+uint32_t spreadBits(uint32_t v) {
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+uint32_t mortonCode(uint32_t x, uint32_t y) {
+    return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+} // namespace
+
+TileScheduler::TileScheduler(int threadCount)
+    : m_threadCount(0)
+    , m_tileSize(32)
+    , m_job(nullptr)
+    , m_frameIndex(0)
+    , m_workersFinished(0)
+    , m_shutdown(false)
+    , m_unclaimedTiles(0)
+    , m_lastRunTime(0.0) {
+
+    setThreadCount(threadCount);
+}
+
+TileScheduler::~TileScheduler() {
+    stopWorkers();
+}
+
+int TileScheduler::getHardwareThreads() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? static_cast<int>(count) : 1;
+}
+
+void TileScheduler::setThreadCount(int count) {
+    if (count <= 0) {
+        count = getHardwareThreads();
+    }
+    if (count == m_threadCount) {
+        return;
+    }
+
+    stopWorkers();
+
+    m_threadCount = count;
+    m_queues.clear();
+    for (int i = 0; i < count; ++i) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    m_stats.assign(count, ThreadStats{ 0.0, 0.0, 0, 0 });
+
+    startWorkers();
+}
+
+void TileScheduler::startWorkers() {
+    m_shutdown = false;
+    // Worker 0 is the thread calling run(). New workers wait for the next
+    // frame, not for every frame since the scheduler was created.
+    for (int i = 1; i < m_threadCount; ++i) {
+        m_workers.emplace_back(&TileScheduler::workerLoop, this, i, m_frameIndex);
+    }
+}
+
+void TileScheduler::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_shutdown = true;
+    }
+    m_frameStart.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+void TileScheduler::run(int width, int height, const TileJob& job) {
+    PROFILE_ZONE("TileScheduler::run");
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Publish the job before any tile is queued
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_job = &job;
+    }
+
+    buildMortonTiles(width, height, m_tileSize, m_tiles);
+
+    // Deal contiguous runs of the Morton curve to each worker so that
+    // neighbouring tiles (and their cache lines) stay on one core
+    size_t tileCount = m_tiles.size();
+    for (int i = 0; i < m_threadCount; ++i) {
+        size_t begin = tileCount * i / m_threadCount;
+        size_t end = tileCount * (i + 1) / m_threadCount;
+
+        WorkerQueue& queue = *m_queues[i];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tiles.assign(m_tiles.begin() + begin, m_tiles.begin() + end);
+
+        m_stats[i] = ThreadStats{ 0.0, 0.0, 0, 0 };
+    }
+    m_unclaimedTiles.store(static_cast<int>(tileCount));
+
+    // Wake the workers
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_workersFinished = 0;
+        ++m_frameIndex;
+    }
+    m_frameStart.notify_all();
+
+    // The calling thread is worker 0
+    executeFrame(0);
+
+    // Wait for the others to run out of work
+    {
+        std::unique_lock<std::mutex> lock(m_frameMutex);
+        m_frameDone.wait(lock, [this] { return m_workersFinished == m_threadCount - 1; });
+        m_job = nullptr;
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    m_lastRunTime = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    for (auto& stats : m_stats) {
+        stats.idleMs = std::max(0.0, m_lastRunTime - stats.busyMs);
+    }
+}
+
+void TileScheduler::workerLoop(int index, unsigned long long lastFrame) {
+    PROFILE_THREAD_NAME("Tile worker " + std::to_string(index));
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_frameMutex);
+            m_frameStart.wait(lock, [&] { return m_shutdown || m_frameIndex != lastFrame; });
+            if (m_shutdown) {
+                return;
+            }
+            lastFrame = m_frameIndex;
+        }
+
+        executeFrame(index);
+
+        {
+            std::lock_guard<std::mutex> lock(m_frameMutex);
+            ++m_workersFinished;
+        }
+        m_frameDone.notify_one();
+    }
+}
+
+void TileScheduler::executeFrame(int index) {
+    PROFILE_ZONE("TileScheduler::executeFrame");
+    ThreadStats& stats = m_stats[index];
+    Tile tile;
+
+    while (true) {
+        bool stolen = false;
+        if (!popLocal(index, tile)) {
+            if (!steal(index, tile)) {
+                // Every tile has been claimed by someone
+                break;
+            }
+            stolen = true;
+        }
+
+        auto tileStart = std::chrono::steady_clock::now();
+        (*m_job)(tile, index);
+        auto tileEnd = std::chrono::steady_clock::now();
+
+        stats.busyMs += std::chrono::duration<double, std::milli>(tileEnd - tileStart).count();
+        ++stats.tilesExecuted;
+        if (stolen) {
+            ++stats.tilesStolen;
+        }
+    }
+}
+
+bool TileScheduler::popLocal(int index, Tile& tile) {
+    WorkerQueue& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tiles.empty()) {
+        return false;
+    }
+
+    // Owner walks its run of the Morton curve front to back
+    tile = queue.tiles.front();
+    queue.tiles.pop_front();
+    m_unclaimedTiles.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool TileScheduler::steal(int index, Tile& tile) {
+    while (m_unclaimedTiles.load(std::memory_order_relaxed) > 0) {
+        for (int offset = 1; offset < m_threadCount; ++offset) {
+            WorkerQueue& victim = *m_queues[(index + offset) % m_threadCount];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.tiles.empty()) {
+                continue;
+            }
+
+            // Thieves take from the far end, away from where the owner works
+            tile = victim.tiles.back();
+            victim.tiles.pop_back();
+            m_unclaimedTiles.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TileScheduler::buildMortonTiles(int width, int height, int tileSize, std::vector<Tile>& tiles) {
+    int tilesX = (width + tileSize - 1) / tileSize;
+    int tilesY = (height + tileSize - 1) / tileSize;
+
+    std::vector<std::pair<uint32_t, Tile>> ordered;
+    ordered.reserve(static_cast<size_t>(tilesX) * tilesY);
+
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            Tile tile;
+            tile.x = tx * tileSize;
+            tile.y = ty * tileSize;
+            tile.width = std::min(tileSize, width - tile.x);
+            tile.height = std::min(tileSize, height - tile.y);
+            ordered.emplace_back(mortonCode(static_cast<uint32_t>(tx), static_cast<uint32_t>(ty)), tile);
+        }
+    }
+
+    std::sort(ordered.begin(), ordered.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    tiles.clear();
+    for (const auto& entry : ordered) {
+        tiles.push_back(entry.second);
+    }
+}
+
+double TileScheduler::getLoadBalance() const {
+    double total = 0.0;
+    double maximum = 0.0;
+    for (const auto& stats : m_stats) {
+        total += stats.busyMs;
+        maximum = std::max(maximum, stats.busyMs);
+    }
+    if (maximum <= 0.0) {
+        return 1.0;
+    }
+    return (total / m_stats.size()) / maximum;
+}
+
+} // namespace Rendering
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Rendering {
+
+// Work-stealing scheduler for image tiles.
+// Tiles are ordered along a Morton (Z-order) curve and dealt out to the
+// workers in contiguous runs. Each worker drains its own deque from the
+// front and, once empty, steals from the back of other workers' deques,
+// so threads that drew cheap tiles (e.g. rays that fall into the shadow)
+// pick up work from threads stuck with expensive sky tiles.
+class TileScheduler {
+public:
+    struct Tile {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    struct ThreadStats {
+        double busyMs;     // Time spent executing tiles
+        double idleMs;     // Time spent waiting for the frame to finish
+        int tilesExecuted;
+        int tilesStolen;
+    };
+
+    // Job signature: tile to process and index of the executing worker
+    using TileJob = std::function<void(const Tile& tile, int threadIndex)>;
+
+    explicit TileScheduler(int threadCount = 0);
+    ~TileScheduler();
+
+    TileScheduler(const TileScheduler&) = delete;
+    TileScheduler& operator=(const TileScheduler&) = delete;
+
+    // Thread count including the calling thread (0 = hardware concurrency)
+    void setThreadCount(int count);
+    int getThreadCount() const { return m_threadCount; }
+
+    // Edge length of square tiles in pixels
+    void setTileSize(int size) { m_tileSize = size < 1 ? 1 : size; }
+    int getTileSize() const { return m_tileSize; }
+
+    // Process every tile of a width x height image; blocks until done.
+    // The calling thread participates as worker 0.
+    void run(int width, int height, const TileJob& job);
+
+    // Statistics of the last run()
+    const std::vector<ThreadStats>& getThreadStats() const { return m_stats; }
+    double getLastRunTime() const { return m_lastRunTime; }
+    // Mean busy time divided by the longest busy time (1.0 = perfect balance)
+    double getLoadBalance() const;
+
+    static int getHardwareThreads();
+
+private:
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<Tile> tiles;
+    };
+
+    void startWorkers();
+    void stopWorkers();
+    // lastFrame: m_frameIndex when the worker was started
+    void workerLoop(int index, unsigned long long lastFrame);
+    void executeFrame(int index);
+    bool popLocal(int index, Tile& tile);
+    bool steal(int index, Tile& tile);
+
+    static void buildMortonTiles(int width, int height, int tileSize, std::vector<Tile>& tiles);
+
+    int m_threadCount;
+    int m_tileSize;
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::vector<ThreadStats> m_stats;
+    std::vector<Tile> m_tiles;
+
+    // Frame hand-off between run() and the workers
+    std::mutex m_frameMutex;
+    std::condition_variable m_frameStart;
+    std::condition_variable m_frameDone;
+    const TileJob* m_job;
+    unsigned long long m_frameIndex;
+    int m_workersFinished;
+    bool m_shutdown;
+
+    std::atomic<int> m_unclaimedTiles;
+    double m_lastRunTime;
+};
+
+} // namespace Rendering
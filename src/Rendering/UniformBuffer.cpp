@@ -0,0 +1,106 @@
+#include "UniformBuffer.h"
+#include <glad/glad.h>
+#include <cstring>
+#include <iostream>
+
+namespace Rendering {
+
+namespace {
+
+// Fences are almost always signalled by the time a slot comes round again;
+// this only bounds the stall if the GPU falls SLOT_COUNT frames behind
+constexpr GLuint64 FENCE_TIMEOUT_NS = 1000000000ull;
+
+} // namespace
+
+UniformBuffer::UniformBuffer(size_t size)
+    : m_size(size)
+    , m_stride(size)
+    , m_buffer(0)
+    , m_mapped(nullptr)
+    , m_fences{}
+    , m_slot(0)
+    , m_written(false)
+    , m_shadow(size)
+    , m_writes(0)
+    , m_skips(0) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_stride = (size + alignment - 1) / alignment * alignment;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glBufferStorage(GL_UNIFORM_BUFFER, m_stride * SLOT_COUNT, nullptr, flags);
+    m_mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, m_stride * SLOT_COUNT, flags));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    if (!m_mapped) {
+        std::cerr << "Failed to map uniform buffer" << std::endl;
+    }
+}
+
+UniformBuffer::~UniformBuffer() {
+    for (void*& fence : m_fences) {
+        if (fence) {
+            glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+    if (m_buffer) {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+bool UniformBuffer::update(const void* data) {
+    if (m_written && std::memcmp(m_shadow.data(), data, m_size) == 0) {
+        ++m_skips;
+        return false;
+    }
+
+    // Earlier dispatches may still read the current slot; write the next one
+    int slot = m_written ? (m_slot + 1) % SLOT_COUNT : m_slot;
+    waitForSlot(slot);
+    if (m_mapped) {
+        std::memcpy(m_mapped + slot * m_stride, data, m_size);
+    } else {
+        // Mapping failed: fall back to a plain upload
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, slot * m_stride, m_size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    std::memcpy(m_shadow.data(), data, m_size);
+    m_slot = slot;
+    m_written = true;
+    ++m_writes;
+    return true;
+}
+
+void UniformBuffer::bind(unsigned int index) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, index, m_buffer, m_slot * m_stride, m_size);
+}
+
+void UniformBuffer::fence() {
+    // Replace the slot's fence: only the most recent read matters
+    if (m_fences[m_slot]) {
+        glDeleteSync(static_cast<GLsync>(m_fences[m_slot]));
+    }
+    m_fences[m_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void UniformBuffer::waitForSlot(int slot) {
+    GLsync fence = static_cast<GLsync>(m_fences[slot]);
+    if (!fence) {
+        return;
+    }
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+        std::cerr << "Uniform buffer fence wait failed" << std::endl;
+    }
+    glDeleteSync(fence);
+    m_fences[slot] = nullptr;
+}
+
+} // namespace Rendering
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Rendering {
+
+// Persistently mapped uniform buffer with one slot per frame in flight.
+//
+// update() compares the block with the last one written and, only if it
+// differs, copies it into the next slot with a single memcpy. Before a
+// slot is reused, the fence placed after the GPU last read it is waited
+// on, so the CPU never overwrites data a queued dispatch still needs.
+class UniformBuffer {
+public:
+    static constexpr int SLOT_COUNT = 3;   // Triple-buffered
+
+    explicit UniformBuffer(size_t size);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Copy data (size bytes) into a fresh slot if it changed; returns
+    // whether anything was written
+    bool update(const void* data);
+
+    // Bind the current slot to a uniform block binding point
+    void bind(unsigned int index) const;
+
+    // Call after the commands reading the current slot have been issued
+    void fence();
+
+    // Updates that changed the contents / that were skipped as unchanged
+    long long getWriteCount() const { return m_writes; }
+    long long getSkipCount() const { return m_skips; }
+
+private:
+    void waitForSlot(int slot);
+
+    size_t m_size;
+    size_t m_stride;                  // Size rounded up to the offset alignment
+    unsigned int m_buffer;
+    unsigned char* m_mapped;
+    void* m_fences[SLOT_COUNT];       // GLsync of the last read of each slot
+    int m_slot;
+    bool m_written;                   // m_shadow holds valid contents
+    std::vector<unsigned char> m_shadow;
+    long long m_writes;
+    long long m_skips;
+};
+
+} // namespace Rendering
@@ -1,9 +1,14 @@
 #include "Interface.h"
 #include "../Core/Window.h"
 #include "../Core/Camera.h"
+#include "../Core/Profiler.h"
 #include "../Physics/BlackHole.h"
 #include "../Physics/AccretionDisk.h"
 #include "../Rendering/Renderer.h"
+#include "../Rendering/CpuRayTracer.h"
+#include "../Rendering/LensingMapCache.h"
+#include "../Rendering/GpuProfiler.h"
+#include "../Rendering/SkyMap.h"
 
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
@@ -16,7 +21,9 @@ Interface::Interface(Core::Window* window)
     : m_lastFrameTime(0.0f)
     , m_frameCount(0)
     , m_fps(0.0f)
-    , m_showHelp(true) {
+    , m_showHelp(true)
+    , m_spinSliderActive(false) {
+    PROFILE_ZONE("Interface::Interface");
     
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
@@ -39,12 +46,14 @@ Interface::~Interface() {
 }
 
 void Interface::beginFrame() {
+    PROFILE_ZONE("Interface::beginFrame");
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 }
 
 void Interface::endFrame() {
+    PROFILE_ZONE("Interface::endFrame");
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
@@ -53,6 +62,7 @@ void Interface::renderControls(Core::Camera& camera,
                                Physics::BlackHole& blackHole,
                                Physics::AccretionDisk& disk,
                                Rendering::Renderer& renderer) {
+    PROFILE_ZONE("Interface::renderControls");
     // Main control window
     ImGui::Begin("Black Hole Simulation Controls", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
     
@@ -60,6 +70,9 @@ void Interface::renderControls(Core::Camera& camera,
         renderBlackHoleControls(blackHole);
     }
     
+    // Cached lensing maps stand in for full traces while the spin is dragged
+    renderer.setLensingMapPreview(m_spinSliderActive);
+    
     if (ImGui::CollapsingHeader("Accretion Disk", ImGuiTreeNodeFlags_DefaultOpen)) {
         renderAccretionDiskControls(disk);
     }
@@ -77,7 +90,7 @@ void Interface::renderControls(Core::Camera& camera,
     }
     
     ImGui::Separator();
-    renderPerformanceStats();
+    renderPerformanceStats(renderer);
     
     ImGui::End();
     
@@ -109,6 +122,10 @@ bool Interface::wantsCaptureMouse() const {
     return ImGui::GetIO().WantCaptureMouse;
 }
 
+bool Interface::isInteracting() const {
+    return ImGui::IsAnyItemActive();
+}
+
 bool Interface::wantsCaptureKeyboard() const {
     return ImGui::GetIO().WantCaptureKeyboard;
 }
@@ -134,6 +151,7 @@ void Interface::renderBlackHoleControls(Physics::BlackHole& blackHole) {
     if (ImGui::SliderFloat("Spin", &spin, 0.0f, 0.998f, "%.3f")) {
         blackHole.setSpin(spin);
     }
+    m_spinSliderActive = ImGui::IsItemActive();
     ImGui::SameLine();
     ImGui::TextDisabled("(?)");
     if (ImGui::IsItemHovered()) {
@@ -228,8 +246,126 @@ void Interface::renderRenderingControls(Rendering::Renderer& renderer) {
         ImGui::BulletText("Medium: 500 steps (balanced)");
         ImGui::BulletText("High: 1000 steps (detailed)");
         ImGui::BulletText("Ultra: 2000 steps (slowest)");
+        ImGui::Text("Fixed step size: 0.15 / 0.1 / 0.05 / 0.02");
+        ImGui::Text("Adaptive tolerance: 1e-3 / 1e-4 / 1e-5 / 1e-6");
+        ImGui::EndTooltip();
+    }
+    
+    // Last measured trace time of each tier (each has its own compiled variant)
+    const char* tierNames[] = { "Low", "Medium", "High", "Ultra" };
+    for (int tier = 1; tier <= Rendering::QUALITY_TIER_COUNT; ++tier) {
+        double tierTime = renderer.getTierTraceTime(tier);
+        if (tierTime > 0.0) {
+            ImGui::TextDisabled("%-6s %7.2f ms @ %3.0f%%", tierNames[tier - 1], tierTime,
+                                renderer.getTierTraceScale(tier) * 100.0f);
+        } else {
+            ImGui::TextDisabled("%-6s       - ms", tierNames[tier - 1]);
+        }
+    }
+    
+    // Geodesic integrator
+    const char* integrators[] = {
+        Rendering::getIntegratorName(Rendering::GeodesicIntegrator::FixedStep),
+        Rendering::getIntegratorName(Rendering::GeodesicIntegrator::RK45),
+        Rendering::getIntegratorName(Rendering::GeodesicIntegrator::Kerr)
+    };
+    int integrator = static_cast<int>(renderer.getIntegrator());
+    if (ImGui::Combo("Integrator", &integrator, integrators, 3)) {
+        renderer.setIntegrator(static_cast<Rendering::GeodesicIntegrator>(integrator));
+    }
+    
+    ImGui::SameLine();
+    ImGui::TextDisabled("(?)");
+    if (ImGui::IsItemHovered()) {
+        ImGui::BeginTooltip();
+        ImGui::BulletText("Fixed Step: original constant-step march");
+        ImGui::BulletText("Adaptive RK45: same bending model, error-controlled steps");
+        ImGui::BulletText("Kerr Geodesic: exact null geodesics of the spinning hole");
+        ImGui::EndTooltip();
+    }
+    
+    if (renderer.getIntegrator() == Rendering::GeodesicIntegrator::Kerr) {
+        bool fastPath = renderer.getUseSchwarzschildFastPath();
+        if (ImGui::Checkbox("Schwarzschild Fast Path", &fastPath)) {
+            renderer.setUseSchwarzschildFastPath(fastPath);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            ImGui::Text("Look rays up in a precomputed Binet orbit table when spin < 0.01");
+            ImGui::EndTooltip();
+        }
+        if (renderer.isSchwarzschildFastPathActive()) {
+            ImGui::TextDisabled("Lensing table built in %.1f ms", renderer.getLensingBuildTime());
+        }
+
+        bool shadowCulling = renderer.getUseShadowCulling();
+        if (ImGui::Checkbox("Shadow Culling", &shadowCulling)) {
+            renderer.setUseShadowCulling(shadowCulling);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            ImGui::Text("Skip pixels well inside the analytic shadow outline");
+            ImGui::Text("(off while the photon sphere is shown)");
+            ImGui::EndTooltip();
+        }
+    }
+    
+    float influenceRadius = renderer.getInfluenceRadius();
+    bool farField = influenceRadius > 0.0f;
+    if (ImGui::Checkbox("Analytic Far Field", &farField)) {
+        renderer.setInfluenceRadius(farField ? Rendering::DEFAULT_INFLUENCE_RADIUS : 0.0f);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::BeginTooltip();
+        ImGui::Text("Propagate rays in closed form outside the sphere of influence");
+        ImGui::Text("instead of marching them all the way out");
         ImGui::EndTooltip();
     }
+    if (farField) {
+        if (ImGui::SliderFloat("Influence Radius (Rs)", &influenceRadius, Rendering::MIN_INFLUENCE_RADIUS,
+                               Rendering::MAX_INFLUENCE_RADIUS, "%.1f", ImGuiSliderFlags_Logarithmic)) {
+            renderer.setInfluenceRadius(influenceRadius);
+        }
+    }
+    
+    Rendering::StepStats stepStats = renderer.getStepStats();
+    ImGui::Text("Steps/ray: avg %.1f, max %d", stepStats.averageSteps, stepStats.maxSteps);
+    
+    bool progressive = renderer.getProgressive();
+    if (ImGui::Checkbox("Progressive Refinement", &progressive)) {
+        renderer.setProgressive(progressive);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::BeginTooltip();
+        ImGui::Text("Accumulate jittered samples while the view is still");
+        ImGui::EndTooltip();
+    }
+    if (progressive) {
+        int maxSamples = renderer.getMaxSamples();
+        if (ImGui::SliderInt("Max Samples", &maxSamples, 1, 1024)) {
+            renderer.setMaxSamples(maxSamples);
+        }
+        ImGui::Text("Samples: %d / %d", renderer.getSampleCount(), maxSamples);
+    }
+    
+    bool dynamicResolution = renderer.getDynamicResolution();
+    if (ImGui::Checkbox("Dynamic Resolution", &dynamicResolution)) {
+        renderer.setDynamicResolution(dynamicResolution);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::BeginTooltip();
+        ImGui::Text("Trace below window resolution to stay within the frame budget");
+        ImGui::Text("and drop to half resolution while dragging");
+        ImGui::EndTooltip();
+    }
+    if (dynamicResolution) {
+        float budget = renderer.getTargetFrameTime();
+        if (ImGui::SliderFloat("Frame Budget (ms)", &budget, 4.0f, 50.0f, "%.1f")) {
+            renderer.setTargetFrameTime(budget);
+        }
+    }
+    ImGui::Text("Render: %dx%d (%.0f%%), trace %.1f ms", renderer.getRenderWidth(), renderer.getRenderHeight(),
+                renderer.getRenderScale() * 100.0f, renderer.getTraceTime());
     
     if (ImGui::Checkbox("Enable Bloom", &enableBloom)) {
         renderer.setEnableBloom(enableBloom);
@@ -239,6 +375,15 @@ void Interface::renderRenderingControls(Rendering::Renderer& renderer) {
         renderer.setExposure(exposure);
     }
     
+    // Streamed sky: resolution shown so far, and upload progress
+    const Rendering::SkyMap& sky = renderer.getSkyMap();
+    if (sky.isLoading()) {
+        ImGui::Text("Sky: %s, %d / %d px (%.0f%%)", sky.getName().c_str(), sky.getVisibleFaceSize(),
+                    sky.getFaceSize(), sky.getProgress() * 100.0f);
+    } else if (sky.isReady()) {
+        ImGui::Text("Sky: %s, %d px faces", sky.getName().c_str(), sky.getFaceSize());
+    }
+    
     ImGui::Separator();
     ImGui::Text("Visualization:");
     
@@ -253,6 +398,77 @@ void Interface::renderRenderingControls(Rendering::Renderer& renderer) {
     if (ImGui::Checkbox("Show Accretion Disk", &showAccretionDisk)) {
         renderer.setShowAccretionDisk(showAccretionDisk);
     }
+    
+    ImGui::Separator();
+    ImGui::Text("CPU Ray Tracer:");
+    
+    bool useCpuTracer = renderer.getUseCpuTracer();
+    int cpuThreads = renderer.getCpuThreadCount();
+    
+    if (ImGui::Checkbox("Trace on CPU", &useCpuTracer)) {
+        renderer.setUseCpuTracer(useCpuTracer);
+    }
+    
+    if (useCpuTracer) {
+        if (ImGui::SliderInt("Threads", &cpuThreads, 1, Rendering::CpuRayTracer::getMaxThreads())) {
+            renderer.setCpuThreadCount(cpuThreads);
+        }
+        bool usePackets = renderer.getCpuUsePackets();
+        if (ImGui::Checkbox("SIMD Ray Packets", &usePackets)) {
+            renderer.setCpuUsePackets(usePackets);
+        }
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%s)", renderer.getCpuSimdName());
+        if (usePackets && renderer.getIntegrator() != Rendering::GeodesicIntegrator::FixedStep) {
+            ImGui::TextDisabled("Packets apply to the fixed-step integrator only");
+        }
+        
+        bool workStealing = renderer.getCpuWorkStealing();
+        if (ImGui::Checkbox("Work-Stealing Tiles", &workStealing)) {
+            renderer.setCpuWorkStealing(workStealing);
+        }
+        
+        ImGui::Text("CPU Frame Time: %.1f ms", renderer.getCpuFrameTime());
+        
+        bool useLensingMapCache = renderer.getUseLensingMapCache();
+        if (ImGui::Checkbox("Lensing Map Cache", &useLensingMapCache)) {
+            renderer.setUseLensingMapCache(useLensingMapCache);
+        }
+        ImGui::SameLine();
+        ImGui::TextDisabled("(?)");
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            ImGui::Text("Keep the traced ray geometry per camera and spin:");
+            ImGui::BulletText("Disk radii and overlay changes only re-shade");
+            ImGui::BulletText("Orbiting around the spin axis reuses the map");
+            ImGui::BulletText("Dragging the spin blends cached neighbouring spins");
+            ImGui::EndTooltip();
+        }
+        if (useLensingMapCache) {
+            static const char* results[] = { "off", "traced", "cached", "interpolated" };
+            const Rendering::LensingMapCache& cache = renderer.getLensingMapCache();
+            ImGui::Text("Last frame: %s (%zu maps, %zu MB)",
+                        results[static_cast<int>(renderer.getLensingMapResult())],
+                        cache.getMapCount(), cache.getMemoryUsed() >> 20);
+        }
+        
+        if (workStealing) {
+            int tileSize = renderer.getCpuTileSize();
+            if (ImGui::SliderInt("Tile Size", &tileSize, 8, 128)) {
+                renderer.setCpuTileSize(tileSize);
+            }
+            
+            const Rendering::TileScheduler& scheduler = renderer.getCpuScheduler();
+            ImGui::Text("Load Balance: %.0f%%", scheduler.getLoadBalance() * 100.0);
+            
+            const auto& stats = scheduler.getThreadStats();
+            for (size_t i = 0; i < stats.size(); ++i) {
+                ImGui::Text("  T%zu: busy %.1f ms, idle %.1f ms, %d tiles (%d stolen)",
+                            i, stats[i].busyMs, stats[i].idleMs,
+                            stats[i].tilesExecuted, stats[i].tilesStolen);
+            }
+        }
+    }
 }
 
 void Interface::renderPresets(Physics::BlackHole& blackHole, 
@@ -319,7 +535,7 @@ void Interface::renderPresets(Physics::BlackHole& blackHole,
     }
 }
 
-void Interface::renderPerformanceStats() {
+void Interface::renderPerformanceStats(const Rendering::Renderer& renderer) {
     ImGui::Separator();
     ImGui::Text("Performance:");
     float fps = ImGui::GetIO().Framerate;
@@ -334,6 +550,43 @@ void Interface::renderPerformanceStats() {
     } else {
         ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Status: Poor");
     }
+    
+    // Programs still compiling in the background after startup
+    int pendingShaders = renderer.getPendingShaderCount();
+    if (pendingShaders > 0) {
+        static const char* tierNames[] = { "none", "Low", "Medium", "High", "Ultra" };
+        ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Compiling shaders: %d left", pendingShaders);
+        if (!renderer.getUseCpuTracer() && renderer.getTracedQuality() != renderer.getQuality()) {
+            ImGui::Text("Tracing at %s until ready", tierNames[renderer.getTracedQuality()]);
+        }
+    }
+    
+    // Stages skipped because nothing they depend on changed
+    const Rendering::RenderStageStats& stages = renderer.getStageStats();
+    if (renderer.wasShadeSkipped()) {
+        ImGui::Text("Frame: display only (idle)");
+    } else if (renderer.wasTraceSkipped()) {
+        ImGui::Text("Frame: re-shaded, trace skipped");
+    } else {
+        ImGui::Text("Frame: traced");
+    }
+    ImGui::Text("Skipped: %lld traces, %lld shades of %lld frames",
+                stages.tracesSkipped, stages.shadesSkipped, stages.frames);
+    
+    // GPU time per pass, independent of vsync
+    const Rendering::GpuProfiler& profiler = renderer.getProfiler();
+    ImGui::Text("GPU passes (ms over the last %d frames):", Rendering::GpuProfiler::HISTORY_SIZE);
+    ImGui::TextDisabled("%-9s %6s %6s %6s", "", "min", "avg", "p99");
+    for (int i = 0; i < static_cast<int>(Rendering::GpuPass::Count); ++i) {
+        Rendering::GpuPass pass = static_cast<Rendering::GpuPass>(i);
+        const Rendering::GpuPassStats& stats = profiler.getStats(pass);
+        if (stats.samples > 0) {
+            ImGui::TextDisabled("%-9s %6.2f %6.2f %6.2f", Rendering::GpuProfiler::getPassName(pass),
+                                stats.minMs, stats.avgMs, stats.p99Ms);
+        } else {
+            ImGui::TextDisabled("%-9s %6s", Rendering::GpuProfiler::getPassName(pass), "-");
+        }
+    }
 }
 
 } // namespace UI
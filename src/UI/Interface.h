@@ -32,6 +32,9 @@ public:
     bool wantsCaptureMouse() const;
     bool wantsCaptureKeyboard() const;
     
+    // A widget (e.g. a slider) is being dragged or edited
+    bool isInteracting() const;
+    
     void toggleHelp() { m_showHelp = !m_showHelp; }
     
 private:
@@ -42,12 +45,13 @@ private:
     void renderPresets(Physics::BlackHole& blackHole, 
                       Physics::AccretionDisk& disk,
                       Core::Camera& camera);
-    void renderPerformanceStats();
+    void renderPerformanceStats(const Rendering::Renderer& renderer);
     
     float m_lastFrameTime;
     int m_frameCount;
     float m_fps;
     bool m_showHelp;
+    bool m_spinSliderActive;
 };
 
 } // namespace UI
@@ -1,18 +1,57 @@
 #include "Core/Window.h"
 #include "Core/Camera.h"
+#include "Core/CommandLine.h"
 #include "Core/Input.h"
+#include "Core/Shader.h"
+#include "Core/CompileThread.h"
+#include "Core/Profiler.h"
 #include "Physics/BlackHole.h"
 #include "Physics/AccretionDisk.h"
 #include "Physics/Constants.h"
 #include "Rendering/Renderer.h"
+#include "Rendering/GpuProfiler.h"
+#include "Rendering/OfflineRenderer.h"
+#include "Rendering/BatchRenderer.h"
+#include "Rendering/Benchmark.h"
 #include "UI/Interface.h"
 
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <iostream>
 #include <memory>
 
-int main() {
+int main(int argc, char** argv) {
+    auto processStart = std::chrono::steady_clock::now();
+    
+    Core::LaunchOptions options;
+    if (!Core::parseCommandLine(argc, argv, options)) {
+        Core::printUsage(argv[0]);
+        return -1;
+    }
+    
+    if (options.mode == Core::RunMode::Help) {
+        Core::printUsage(argv[0]);
+        return 0;
+    }
+    
+    if (!options.profilePath.empty()) {
+        Core::Profiler::setEnabled(true);
+        Core::Profiler::writeAtExit(options.profilePath);
+        PROFILE_THREAD_NAME("Main");
+    }
+    
     try {
+        // Headless mode: no window, GL context, UI or shaders
+        if (options.mode == Core::RunMode::Render) {
+            return Rendering::runOfflineRender(options, processStart);
+        }
+        if (options.mode == Core::RunMode::Batch) {
+            return Rendering::runBatchRender(options);
+        }
+        if (options.mode == Core::RunMode::Benchmark) {
+            return Rendering::runBenchmark(options);
+        }
+        
         // Create window
         Core::Window window(Physics::DEFAULT_WIDTH, Physics::DEFAULT_HEIGHT, 
                            "Black Hole Simulation - RTX Accelerated");
@@ -51,9 +90,24 @@ int main() {
         // Create accretion disk
         Physics::AccretionDisk disk(&blackHole);
         
+        // Program binaries from earlier runs skip most of the shader compiles
+        Core::Shader::setBinaryCacheDirectory(options.shaderCacheDir);
+        
+        // The rest compile off the render thread: on the driver's own threads
+        // if it can, else on a worker with a shared context
+        std::unique_ptr<Core::CompileThread> compileThread;
+        if (!Core::Shader::enableParallelCompile()) {
+            compileThread = std::make_unique<Core::CompileThread>(window.getHandle());
+            Core::Shader::setCompileThread(compileThread.get());
+        }
+        
         // Create renderer
         Rendering::Renderer renderer(window.getWidth(), window.getHeight());
-        renderer.initialize();
+        renderer.initialize(options.quality);
+        renderer.setInfluenceRadius(options.influenceRadius);
+        if (!options.skyPath.empty()) {
+            renderer.loadSkyMap(options.skyPath, options.skyFaceSize);
+        }
         
         // Create UI
         UI::Interface ui(&window);
@@ -77,6 +131,9 @@ int main() {
         std::cout << "  Middle Mouse: Reset camera" << std::endl;
         std::cout << "  H: Toggle help window" << std::endl;
         std::cout << "  Q/W/E/R: Quality Low/Medium/High/Ultra" << std::endl;
+        if (!options.profilePath.empty()) {
+            std::cout << "  F9: Write CPU profile to " << options.profilePath << std::endl;
+        }
         std::cout << "  ESC: Exit" << std::endl;
         std::cout << "========================================\n" << std::endl;
         
@@ -85,6 +142,7 @@ int main() {
         
         // Main render loop
         while (!window.shouldClose()) {
+            PROFILE_ZONE("Frame");
             frameCount++;
             if (frameCount <= 5) {
                 std::cout << "Starting frame " << frameCount << "..." << std::endl;
@@ -110,16 +168,21 @@ int main() {
                 std::cout << "Frame 1: UI frame began..." << std::endl;
             };
             
+            // Dragging the camera or a slider lowers the render resolution
+            bool interacting = ui.isInteracting();
+            
             if (!ui.wantsCaptureMouse()) {
                 // Camera controls
                 if (Core::Input::isMouseButtonDown(GLFW_MOUSE_BUTTON_LEFT)) {
                     glm::vec2 delta = Core::Input::getMouseDelta();
                     camera.orbit(-delta.x * 0.005f, delta.y * 0.005f);
+                    interacting = true;
                 }
                 
                 if (Core::Input::isMouseButtonDown(GLFW_MOUSE_BUTTON_RIGHT)) {
                     glm::vec2 delta = Core::Input::getMouseDelta();
                     camera.pan(glm::vec2(-delta.x * 0.01f, delta.y * 0.01f));
+                    interacting = true;
                 }
                 
                 // Scroll wheel for zoom
@@ -159,6 +222,11 @@ int main() {
                     renderer.setQuality(4); // Ultra
                     std::cout << "Quality: Ultra (slowest)" << std::endl;
                 }
+                
+                // Write the CPU profile so far
+                if (Core::Input::isKeyPressed(GLFW_KEY_F9) && !options.profilePath.empty()) {
+                    Core::Profiler::writeChromeTrace(options.profilePath);
+                }
             }
             
             // ESC key to exit (always works)
@@ -175,6 +243,8 @@ int main() {
             }
             
             // Render scene
+            renderer.setAnimationTime(static_cast<float>(currentTime));
+            renderer.setInteracting(interacting);
             renderer.render(camera, blackHole, disk);
             
             if (frameCount == 1) {
@@ -183,7 +253,9 @@ int main() {
             
             // Render UI
             ui.renderControls(camera, blackHole, disk, renderer);
+            renderer.getProfiler().begin(Rendering::GpuPass::UI);
             ui.endFrame();
+            renderer.getProfiler().end(Rendering::GpuPass::UI);
             
             if (frameCount == 1) {
                 std::cout << "Frame 1: UI rendered, swapping buffers..." << std::endl;
@@ -194,6 +266,18 @@ int main() {
             
             if (frameCount == 1) {
                 std::cout << "Frame 1: First frame complete!" << std::endl;
+                double startupMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - processStart).count();
+                std::cout << "Startup to first frame: " << startupMs << " ms";
+                if (Core::Shader::getBinaryCacheDirectory().empty()) {
+                    std::cout << " (shader cache off)" << std::endl;
+                } else {
+                    // Warm: every program came from the cache
+                    int hits = Core::Shader::getBinaryCacheHits();
+                    int misses = Core::Shader::getBinaryCacheMisses();
+                    std::cout << " (" << (misses == 0 ? "warm" : "cold") << " shader cache, "
+                              << hits << " programs loaded, " << misses << " compiled)" << std::endl;
+                }
             }
             
             // Debug: Check if window wants to close